@@ -23,6 +23,143 @@
 
 namespace lapack_wrapper {
 
+  /*\
+   |   ____   ____ __  __
+   |  |  _ \ / ___|  \/  |
+   |  | |_) | |   | |\/| |
+   |  |  _ <| |___| |  | |
+   |  |_| \_\\____|_|  |_|
+  \*/
+
+  // order nodes by degree
+  class rcm_degree_less {
+    std::vector<integer> const & R;
+  public:
+    explicit
+    rcm_degree_less( std::vector<integer> const & R_in ) : R(R_in) {}
+    bool
+    operator () ( integer a, integer b ) const
+    { return R[a+1]-R[a] < R[b+1]-R[b]; }
+  };
+
+  // level structure from r, returns the number of levels
+  // and in last the start of the last level in queue
+  static
+  integer
+  rcm_levels(
+    std::vector<integer> const & R,
+    std::vector<integer> const & J,
+    integer                      r,
+    integer                      stamp,
+    std::vector<integer>       & mark,
+    std::vector<integer>       & queue,
+    integer                    & last
+  ) {
+    queue.clear();
+    queue.push_back(r);
+    mark[r] = stamp;
+    integer nlev = 0, lo = 0;
+    while ( lo < integer(queue.size()) ) {
+      integer hi = integer(queue.size());
+      last = lo;
+      ++nlev;
+      for ( integer kk = lo; kk < hi; ++kk )
+        for ( integer jj = R[queue[kk]]; jj < R[queue[kk]+1]; ++jj )
+          if ( mark[J[jj]] != stamp ) { mark[J[jj]] = stamp; queue.push_back(J[jj]); }
+      lo = hi;
+    }
+    return nlev;
+  }
+
+  void
+  rcm_permutation(
+    integer       n,
+    integer       nnz,
+    integer const rows[],
+    integer const cols[],
+    bool          fi,
+    integer       perm[]
+  ) {
+    integer offs = fi ? 1 : 0;
+
+    // adjacency of A+A^T without the diagonal
+    std::vector<integer> R( size_t(n+1), 0 ), J;
+    for ( integer k = 0; k < nnz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      LAPACK_WRAPPER_ASSERT(
+        i >= 0 && i < n && j >= 0 && j < n,
+        "rcm_permutation, bad index ( " << i << " , " << j << " )"
+      );
+      if ( i != j ) { ++R[i+1]; ++R[j+1]; }
+    }
+    for ( integer i = 0; i < n; ++i ) R[i+1] += R[i];
+    J.resize( size_t(R[n]) );
+    {
+      std::vector<integer> fill( R.begin(), R.end()-1 );
+      for ( integer k = 0; k < nnz; ++k ) {
+        integer i = rows[k]-offs;
+        integer j = cols[k]-offs;
+        if ( i != j ) { J[fill[i]++] = j; J[fill[j]++] = i; }
+      }
+    }
+    integer nz = 0;
+    for ( integer i = 0; i < n; ++i ) {
+      std::vector<integer>::iterator b = J.begin()+R[i];
+      std::vector<integer>::iterator e = J.begin()+R[i+1];
+      std::sort( b, e );
+      e = std::unique( b, e );
+      R[i] = nz;
+      for ( ; b != e; ++b ) J[nz++] = *b;
+    }
+    R[n] = nz;
+
+    std::vector<integer> mark( size_t(n), -1 ), queue, nbr;
+    integer stamp = 0;
+    rcm_degree_less lessDeg( R );
+
+    // the first not numbered node by increasing degree starts a component
+    std::vector<integer> byDeg( static_cast<size_t>(n) );
+    for ( integer i = 0; i < n; ++i ) byDeg[i] = i;
+    std::stable_sort( byDeg.begin(), byDeg.end(), lessDeg );
+
+    std::vector<bool> done( size_t(n), false );
+    integer pos = 0;
+    for ( integer s = 0; s < n; ++s ) {
+      integer r = byDeg[s];
+      if ( done[r] ) continue;
+
+      // pseudo peripheral node (George-Liu)
+      integer last = 0;
+      integer nlev = rcm_levels( R, J, r, ++stamp, mark, queue, last );
+      while ( true ) {
+        integer x = queue[last];
+        for ( integer kk = last+1; kk < integer(queue.size()); ++kk )
+          if ( lessDeg( queue[kk], x ) ) x = queue[kk];
+        integer xlast = 0;
+        integer xlev  = rcm_levels( R, J, x, ++stamp, mark, queue, xlast );
+        if ( xlev <= nlev ) break;
+        r    = x;
+        nlev = xlev;
+        last = xlast;
+      }
+
+      // Cuthill-McKee from r, neighbours by increasing degree
+      integer head = pos;
+      perm[pos++] = r;
+      done[r]     = true;
+      while ( head < pos ) {
+        integer v = perm[head++];
+        nbr.clear();
+        for ( integer jj = R[v]; jj < R[v+1]; ++jj )
+          if ( !done[J[jj]] ) { done[J[jj]] = true; nbr.push_back(J[jj]); }
+        std::stable_sort( nbr.begin(), nbr.end(), lessDeg );
+        for ( size_t kk = 0; kk < nbr.size(); ++kk ) perm[pos++] = nbr[kk];
+      }
+    }
+    std::reverse( perm, perm+n );
+  }
+
   /*\
    |   ____                  _          _ __  __       _        _
    |  | __ )  __ _ _ __   __| | ___  __| |  \/  | __ _| |_ _ __(_)_  __
@@ -41,6 +178,7 @@ namespace lapack_wrapper {
   , nU(0)
   , ldAB(0)
   , is_factorized(false)
+  , perm(nullptr)
   {}
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -69,18 +207,109 @@ namespace lapack_wrapper {
     allocIntegers.allocate(m);
     AB   = allocReals( nnz );
     ipiv = allocIntegers( m );
+    perm = nullptr;
     is_factorized = false;
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+  template <typename T>
+  void
+  BandedLU<T>::setup( SparseCCOOR<valueType> const & A, bool rcm ) {
+    integer nr, nc, nz;
+    A.get_info( nr, nc, nz );
+    integer   const * rows = nullptr;
+    integer   const * cols = nullptr;
+    valueType const * vals = nullptr;
+    if ( nz > 0 ) A.get_data( rows, cols, vals );
+    integer offs = A.FORTRAN_indexing() ? 1 : 0;
+    LAPACK_WRAPPER_ASSERT(
+      !rcm || nr == nc,
+      "BandedLU::setup, renumbering needs a square matrix"
+    );
+
+    // renumbering and bandwidth
+    std::vector<integer> P, iP;
+    if ( rcm && nr > 0 ) {
+      P.resize( size_t(nr) );
+      iP.resize( size_t(nr) );
+      rcm_permutation( nr, nz, rows, cols, offs == 1, &P.front() );
+      for ( integer k = 0; k < nr; ++k ) iP[P[k]] = k;
+    }
+    integer bL = 0, bU = 0;
+    for ( integer k = 0; k < nz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      LAPACK_WRAPPER_ASSERT(
+        i >= 0 && i < nr && j >= 0 && j < nc,
+        "BandedLU::setup, bad index ( " << i << " , " << j << " )"
+      );
+      if ( !P.empty() ) { i = iP[i]; j = iP[j]; }
+      bL = std::max( bL, i-j );
+      bU = std::max( bU, j-i );
+    }
+
+    m    = nr;
+    n    = nc;
+    nL   = bL;
+    nU   = bU;
+    ldAB = 2*nL+nU+1;
+    integer nnz = n*ldAB;
+    allocReals.allocate( nnz );
+    allocIntegers.allocate( m + integer(P.size()) );
+    AB   = allocReals( nnz );
+    ipiv = allocIntegers( m );
+    perm = nullptr;
+    if ( !P.empty() ) {
+      perm = allocIntegers( m );
+      std::copy( P.begin(), P.end(), perm );
+    }
+    is_factorized = false;
+
+    // load
+    lapack_wrapper::zero( nnz, AB, 1 );
+    for ( integer k = 0; k < nz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      if ( perm != nullptr ) { i = iP[i]; j = iP[j]; }
+      AB[iaddr(i,j)] = vals[k];
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+  template <typename T>
+  void
+  BandedLU<T>::solve_band(
+    Transposition TRANS,
+    integer       nrhs,
+    valueType     B[],
+    integer       ldB
+  ) const {
+    if ( perm == nullptr ) {
+      integer info = gbtrs( TRANS, m, nL, nU, nrhs, AB, ldAB, ipiv, B, ldB );
+      LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::solve, info = " << info );
+    } else {
+      // solve in the band numbering, the buffer is local so that
+      // concurrent solves with the same factorization are safe
+      std::vector<valueType> W( size_t(m)*size_t(nrhs) );
+      for ( integer c = 0; c < nrhs; ++c )
+        for ( integer k = 0; k < m; ++k ) W[k+c*m] = B[perm[k]+c*ldB];
+      integer info = gbtrs( TRANS, m, nL, nU, nrhs, AB, ldAB, ipiv, &W.front(), m );
+      LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::solve, info = " << info );
+      for ( integer c = 0; c < nrhs; ++c )
+        for ( integer k = 0; k < m; ++k ) B[perm[k]+c*ldB] = W[k+c*m];
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
   template <typename T>
   void
   BandedLU<T>::solve( valueType xb[] ) const {
     LAPACK_WRAPPER_ASSERT( is_factorized, "BandedLU::solve, matrix not yet factorized" );
     LAPACK_WRAPPER_ASSERT( m == n, "BandedLU::solve, matrix must be square" );
-    integer info = gbtrs( NO_TRANSPOSE, m, nL, nU, 1, AB, ldAB, ipiv, xb, m );
-    LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::solve, info = " << info );
+    solve_band( NO_TRANSPOSE, 1, xb, m );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -90,8 +319,7 @@ namespace lapack_wrapper {
   BandedLU<T>::t_solve( valueType xb[] ) const {
     LAPACK_WRAPPER_ASSERT( is_factorized, "BandedLU::solve, matrix not yet factorized" );
     LAPACK_WRAPPER_ASSERT( m == n, "BandedLU::solve, matrix must be square" );
-    integer info = gbtrs( TRANSPOSE, m, nL, nU, 1, AB, ldAB, ipiv, xb, m );
-    LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::t_solve, info = " << info );
+    solve_band( TRANSPOSE, 1, xb, m );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -101,8 +329,7 @@ namespace lapack_wrapper {
   BandedLU<T>::solve( integer nrhs, valueType B[], integer ldB ) const {
     LAPACK_WRAPPER_ASSERT( is_factorized, "BandedLU::solve, matrix not yet factorized" );
     LAPACK_WRAPPER_ASSERT( m == n, "BandedLU::solve, matrix must be square" );
-    integer info = gbtrs( NO_TRANSPOSE, m, nL, nU, nrhs, AB, ldAB, ipiv, B, ldB );
-    LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::solve, info = " << info );
+    solve_band( NO_TRANSPOSE, nrhs, B, ldB );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -112,8 +339,7 @@ namespace lapack_wrapper {
   BandedLU<T>::t_solve( integer nrhs, valueType B[], integer ldB ) const {
     LAPACK_WRAPPER_ASSERT( is_factorized, "BandedLU::solve, matrix not yet factorized" );
     LAPACK_WRAPPER_ASSERT( m == n, "BandedLU::solve, matrix must be square" );
-    integer info = gbtrs( TRANSPOSE, m, nL, nU, nrhs, AB, ldAB, ipiv, B, ldB );
-    LAPACK_WRAPPER_ASSERT( info == 0, "BandedLU::t_solve, info = " << info );
+    solve_band( TRANSPOSE, nrhs, B, ldB );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -246,6 +472,18 @@ namespace lapack_wrapper {
     valueType       y[]
   ) const {
 
+    if ( perm != nullptr ) {
+      // band in the new numbering, x and y in the old one
+      for ( integer j = 0; j < n; ++j ) {
+        integer imin = std::max( j-nU, integer(0) );
+        integer imax = std::min( j+nL, m-1 );
+        valueType ax = alpha*x[perm[j]];
+        for ( integer i = imin; i <= imax; ++i )
+          y[perm[i]] += AB[iaddr(i,j)] * ax;
+      }
+      return;
+    }
+
     valueType const * col = AB + nL;
     for ( integer j = 0; j < n; ++j, col += ldAB ) {
       integer imin  = j-nU;
@@ -282,6 +520,8 @@ namespace lapack_wrapper {
   , nD(0)
   , ldAB(0)
   , is_factorized(false)
+  , allocIntegers("_BandedSPD_integers")
+  , perm(nullptr)
   {}
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -306,7 +546,96 @@ namespace lapack_wrapper {
     integer nnz = n*ldAB;
     allocReals.allocate( nnz );
     AB   = allocReals( nnz );
+    perm = nullptr;
+    is_factorized = false;
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+  template <typename T>
+  void
+  BandedSPD<T>::setup(
+    ULselect                       _UPLO,
+    SparseCCOOR<valueType> const & A,
+    bool                           rcm
+  ) {
+    integer nr, nc, nz;
+    A.get_info( nr, nc, nz );
+    integer   const * rows = nullptr;
+    integer   const * cols = nullptr;
+    valueType const * vals = nullptr;
+    if ( nz > 0 ) A.get_data( rows, cols, vals );
+    integer offs = A.FORTRAN_indexing() ? 1 : 0;
+    LAPACK_WRAPPER_ASSERT(
+      nr == nc,
+      "BandedSPD::setup, matrix must be square"
+    );
+
+    // renumbering and bandwidth
+    std::vector<integer> P, iP;
+    if ( rcm && nr > 0 ) {
+      P.resize( size_t(nr) );
+      iP.resize( size_t(nr) );
+      rcm_permutation( nr, nz, rows, cols, offs == 1, &P.front() );
+      for ( integer k = 0; k < nr; ++k ) iP[P[k]] = k;
+    }
+    integer bD = 0;
+    for ( integer k = 0; k < nz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      LAPACK_WRAPPER_ASSERT(
+        i >= 0 && i < nr && j >= 0 && j < nc,
+        "BandedSPD::setup, bad index ( " << i << " , " << j << " )"
+      );
+      if ( !P.empty() ) { i = iP[i]; j = iP[j]; }
+      bD = std::max( bD, i > j ? i-j : j-i );
+    }
+
+    UPLO = _UPLO;
+    n    = nr;
+    nD   = bD;
+    ldAB = nD+1;
+    integer nnz = n*ldAB;
+    allocReals.allocate( nnz );
+    AB   = allocReals( nnz );
+    perm = nullptr;
+    if ( !P.empty() ) {
+      allocIntegers.allocate( n );
+      perm = allocIntegers( n );
+      std::copy( P.begin(), P.end(), perm );
+    }
     is_factorized = false;
+
+    // load the entries in the triangle UPLO
+    lapack_wrapper::zero( nnz, AB, 1 );
+    for ( integer k = 0; k < nz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      if ( perm != nullptr ) { i = iP[i]; j = iP[j]; }
+      if ( (UPLO == UPPER) == (i > j) ) std::swap( i, j );
+      if ( UPLO == UPPER ) AB[nD+i-j+j*ldAB] = vals[k];
+      else                 AB[i-j+j*ldAB]    = vals[k];
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+  template <typename T>
+  void
+  BandedSPD<T>::solve_band( integer nrhs, valueType B[], integer ldB ) const {
+    if ( perm == nullptr ) {
+      integer info = pbtrs( UPLO, n, nD, nrhs, AB, ldAB, B, ldB );
+      LAPACK_WRAPPER_ASSERT( info == 0, "BandedSPD::solve, info = " << info );
+    } else {
+      // solve in the band numbering, local buffer as in BandedLU
+      std::vector<valueType> W( size_t(n)*size_t(nrhs) );
+      for ( integer c = 0; c < nrhs; ++c )
+        for ( integer k = 0; k < n; ++k ) W[k+c*n] = B[perm[k]+c*ldB];
+      integer info = pbtrs( UPLO, n, nD, nrhs, AB, ldAB, &W.front(), n );
+      LAPACK_WRAPPER_ASSERT( info == 0, "BandedSPD::solve, info = " << info );
+      for ( integer c = 0; c < nrhs; ++c )
+        for ( integer k = 0; k < n; ++k ) B[perm[k]+c*ldB] = W[k+c*n];
+    }
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -318,11 +647,7 @@ namespace lapack_wrapper {
       is_factorized,
       "BandedSPD::solve, matrix not yet factorized"
     );
-    integer info = pbtrs( UPLO, n, nD, 1, AB, ldAB, xb, n );
-    LAPACK_WRAPPER_ASSERT(
-      info == 0,
-      "BandedSPD::solve, info = " << info
-    );
+    solve_band( 1, xb, n );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -334,11 +659,7 @@ namespace lapack_wrapper {
       is_factorized,
       "BandedSPD::solve, matrix not yet factorized"
     );
-    integer info = pbtrs( UPLO, n, nD, 1, AB, ldAB, xb, n );
-    LAPACK_WRAPPER_ASSERT(
-      info == 0,
-      "BandedSPD::t_solve, info = " << info
-    );
+    solve_band( 1, xb, n );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -350,11 +671,7 @@ namespace lapack_wrapper {
       is_factorized,
       "BandedSPD::solve, matrix not yet factorized"
     );
-    integer info = pbtrs( UPLO, n, nD, nrhs, AB, ldAB, B, ldB );
-    LAPACK_WRAPPER_ASSERT(
-      info == 0,
-      "BandedSPD::solve, info = " << info
-    );
+    solve_band( nrhs, B, ldB );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -366,11 +683,7 @@ namespace lapack_wrapper {
       is_factorized,
       "BandedSPD::solve, matrix not yet factorized"
     );
-    integer info = pbtrs( UPLO, n, nD, nrhs, AB, ldAB, B, ldB );
-    LAPACK_WRAPPER_ASSERT(
-      info == 0,
-      "BandedSPD::t_solve, info = " << info
-    );
+    solve_band( nrhs, B, ldB );
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -23,6 +23,28 @@
 
 namespace lapack_wrapper {
 
+  /*!
+   * \brief rcm_permutation:
+   *        reverse Cuthill-McKee renumbering of the pattern of \f$ A+A^T \f$,
+   *        reduces the bandwidth.
+   *
+   * \param[in]  n    number of rows and columns
+   * \param[in]  nnz  number of entries
+   * \param[in]  rows row indices of the entries
+   * \param[in]  cols column indices of the entries
+   * \param[in]  fi   \c true if the indices start from 1
+   * \param[out] perm \c perm[k] is the old index of the new row and column \c k
+   */
+  void
+  rcm_permutation(
+    integer       n,
+    integer       nnz,
+    integer const rows[],
+    integer const cols[],
+    bool          fi,
+    integer       perm[]
+  );
+
   //============================================================================
   /*\
   :|:   ____                  _          _ _    _   _
@@ -46,6 +68,18 @@ namespace lapack_wrapper {
 
     bool is_factorized;
 
+  private:
+
+    integer * perm; // nullptr or the old index of the band row/column k
+
+    void
+    solve_band(
+      Transposition TRANS,
+      integer       nrhs,
+      valueType     B[],
+      integer       ldB
+    ) const;
+
   public:
 
     BandedLU();
@@ -59,6 +93,25 @@ namespace lapack_wrapper {
       integer nU  // number of upper diagonal
     );
 
+    /*!
+     * \brief setup with the tight bandwidth of the sparse matrix \c A
+     *        and load its entries.
+     *
+     * With \c rcm the rows and columns of the square matrix \c A are
+     * first renumbered by \c rcm_permutation: the band (and so
+     * \c operator() and \c insert) is in the new numbering while
+     * \c solve, \c t_solve and \c aAxpy work in the numbering of \c A.
+     */
+    void
+    setup( SparseCCOOR<valueType> const & A, bool rcm = false );
+
+    /*!
+     * \brief the renumbering of the last \c setup, \c nullptr if none:
+     *        entry \c k is the row/column of \c A stored as row/column
+     *        \c k of the band.
+     */
+    integer const * permutation() const { return perm; }
+
     integer
     iaddr( integer i, integer j ) const {
       integer d = (i-j+nL+nU);
@@ -68,6 +121,8 @@ namespace lapack_wrapper {
     void
     check( integer i, integer j ) const;
 
+    // element access and insert use the band numbering, that differs
+    // from the one of solve and aAxpy if permutation() != nullptr
     valueType const &
     operator () ( integer i, integer j ) const
     { return AB[iaddr(i,j)]; }
@@ -169,6 +224,14 @@ namespace lapack_wrapper {
     ULselect    UPLO;
     bool is_factorized;
 
+  private:
+
+    Malloc<integer> allocIntegers;
+    integer *       perm; // nullptr or the old index of the band row/column k
+
+    void
+    solve_band( integer nrhs, valueType B[], integer ldB ) const;
+
   public:
 
     BandedSPD();
@@ -183,6 +246,21 @@ namespace lapack_wrapper {
       integer  nD    // number of upper diagonal
     );
 
+    /*!
+     * \brief setup with the tight bandwidth of the symmetric sparse
+     *        matrix \c A and load its entries.
+     *
+     * The entries of \c A are stored in the triangle \c UPLO, \c A can
+     * hold one or both triangles.  With \c rcm the rows and columns are
+     * first renumbered by \c rcm_permutation, see \c BandedLU::setup.
+     */
+    void
+    setup( ULselect UPLO, SparseCCOOR<valueType> const & A, bool rcm = false );
+
+    //! the renumbering of the last \c setup, see \c BandedLU::permutation
+    integer const * permutation() const { return perm; }
+
+    // element access and insert use the band numbering, see BandedLU
     valueType const &
     operator () ( integer i, integer j ) const
     { return AB[i+j*ldAB]; }
@@ -23,6 +23,50 @@
 
 namespace lapack_wrapper {
 
+  integer
+  block_tridiagonal_partition(
+    integer                n,
+    integer                nnz,
+    integer const          rows[],
+    integer const          cols[],
+    bool                   fi,
+    std::vector<integer> & rBlocks
+  ) {
+    integer offs = fi ? 1 : 0;
+
+    // reach[c] = largest index coupled to c in A+A^T
+    std::vector<integer> reach( static_cast<size_t>(n) );
+    for ( integer c = 0; c < n; ++c ) reach[c] = c;
+    for ( integer k = 0; k < nnz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      LAPACK_WRAPPER_ASSERT(
+        i >= 0 && i < n && j >= 0 && j < n,
+        "block_tridiagonal_partition, bad index ( " << i << " , " << j << " )"
+      );
+      if ( i < j ) std::swap( i, j );
+      if ( i > reach[j] ) reach[j] = i;
+    }
+
+    rBlocks.clear();
+    rBlocks.push_back(0);
+    if ( n == 0 ) return 0;
+
+    // first block: rows coupled at most as far as row 0
+    integer b = 1;
+    while ( b < n && reach[b] <= reach[0] ) ++b;
+    rBlocks.push_back(b);
+
+    // next block must contain all the rows coupled to the previous blocks
+    integer R = 0, c = 0;
+    while ( b < n ) {
+      for ( ; c < b; ++c ) if ( reach[c] > R ) R = reach[c];
+      b = std::max( b+1, R+1 );
+      rBlocks.push_back(b);
+    }
+    return integer(rBlocks.size())-1;
+  }
+
   //============================================================================
   /*\
    |  ___ _         _     _____    _    _ _                         _
@@ -109,6 +153,104 @@ namespace lapack_wrapper {
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+  template <typename T>
+  void
+  BlockTridiagonalSymmetic<T>::setup(
+    SparseCCOOR<valueType> const & A,
+    bool                           sym
+  ) {
+    integer nr, nc, nz;
+    A.get_info( nr, nc, nz );
+    LAPACK_WRAPPER_ASSERT(
+      nr == nc && nr > 0,
+      "BlockTridiagonalSymmetic::setup, bad matrix size " << nr << " x " << nc
+    );
+    integer const * rows = nullptr;
+    integer const * cols = nullptr;
+    valueType const * vals = nullptr;
+    if ( nz > 0 ) A.get_data( rows, cols, vals );
+    std::vector<integer> rBlocks;
+    integer nblks = block_tridiagonal_partition(
+      nr, nz, rows, cols, A.FORTRAN_indexing(), rBlocks
+    );
+    this->setup( nblks, &rBlocks.front() );
+    this->load( A, sym );
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+  template <typename T>
+  void
+  BlockTridiagonalSymmetic<T>::setup(
+    integer                        nblks,
+    integer const                  rBlocks[],
+    SparseCCOOR<valueType> const & A,
+    bool                           sym
+  ) {
+    this->setup( nblks, rBlocks );
+    this->load( A, sym );
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+  template <typename T>
+  void
+  BlockTridiagonalSymmetic<T>::load(
+    SparseCCOOR<valueType> const & A,
+    bool                           sym
+  ) {
+    integer nr, nc, nz;
+    A.get_info( nr, nc, nz );
+    integer N = this->row_blocks[this->nBlocks];
+    LAPACK_WRAPPER_ASSERT(
+      nr == N && nc == N,
+      "BlockTridiagonalSymmetic::load, matrix " << nr << " x " << nc <<
+      " expected " << N << " x " << N
+    );
+    integer const * rows = nullptr;
+    integer const * cols = nullptr;
+    valueType const * vals = nullptr;
+    if ( nz > 0 ) A.get_data( rows, cols, vals );
+    integer offs = A.FORTRAN_indexing() ? 1 : 0;
+
+    // row to block map
+    std::vector<integer> blk( static_cast<size_t>(N) );
+    for ( integer b = 0; b < this->nBlocks; ++b )
+      std::fill( blk.begin()+row_blocks[b], blk.begin()+row_blocks[b+1], b );
+
+    this->zero();
+    for ( integer k = 0; k < nz; ++k ) {
+      integer i = rows[k]-offs;
+      integer j = cols[k]-offs;
+      LAPACK_WRAPPER_ASSERT(
+        i >= 0 && i < N && j >= 0 && j < N,
+        "BlockTridiagonalSymmetic::load, bad index ( " << i << " , " << j << " )"
+      );
+      integer bi = blk[i];
+      integer bj = blk[j];
+      if ( bi == bj ) {
+        integer     i0 = row_blocks[bi];
+        integer     ld = row_blocks[bi+1] - i0;
+        valueType * D  = this->D_blocks[bi];
+        D[(i-i0)+(j-i0)*ld] = vals[k];
+        if ( sym ) D[(j-i0)+(i-i0)*ld] = vals[k];
+      } else if ( bi == bj+1 ) {
+        this->L_blocks[bj][(i-row_blocks[bi])+(j-row_blocks[bj])*this->LnumRows(bj)] = vals[k];
+      } else if ( bj == bi+1 ) {
+        this->L_blocks[bi][(j-row_blocks[bj])+(i-row_blocks[bi])*this->LnumRows(bi)] = vals[k];
+      } else {
+        LAPACK_WRAPPER_ERROR(
+          "in lapack_wrapper::BlockTridiagonalSymmetic::load, entry ( " <<
+          i << " , " << j << " ) in block ( " << bi << " , " << bj <<
+          " ) outside the block tridiagonal structure"
+        );
+      }
+    }
+    is_factorized = false;
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
   template <typename T>
   void
   BlockTridiagonalSymmetic<T>::zero() { // fill to 0 all the blocks
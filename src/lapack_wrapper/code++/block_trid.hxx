@@ -23,6 +23,35 @@
 
 namespace lapack_wrapper {
 
+  /*!
+   * \brief block_tridiagonal_partition:
+   *        block boundaries of a block tridiagonal pattern.
+   *
+   * The pattern of \f$ A+A^T \f$ is split in consecutive blocks such that
+   * every entry falls in a diagonal block or in one of the two blocks next
+   * to it.  The first block ends where the column reach of the rows
+   * grows, the following ones are the smallest compatible with the
+   * tridiagonal structure (dense \c m x \c m coupled blocks are found
+   * exactly).
+   *
+   * \param[in]  n       number of rows and columns
+   * \param[in]  nnz     number of entries
+   * \param[in]  rows    row indices of the entries
+   * \param[in]  cols    column indices of the entries
+   * \param[in]  fi      \c true if the indices start from 1
+   * \param[out] rBlocks the \c nblks+1 block boundaries
+   * \return the number of blocks \c nblks
+   */
+  integer
+  block_tridiagonal_partition(
+    integer                n,
+    integer                nnz,
+    integer const          rows[],
+    integer const          cols[],
+    bool                   fi,
+    std::vector<integer> & rBlocks
+  );
+
   //============================================================================
   /*\
   :|:  ___ _         _     _____    _    _ _                         _
@@ -83,6 +112,36 @@ namespace lapack_wrapper {
     void
     setup( integer nblks, integer const block_size );
 
+    /*!
+     * \brief setup from the sparse matrix \c A, block boundaries
+     *        computed by \c block_tridiagonal_partition, and \c load it.
+     */
+    void
+    setup( SparseCCOOR<valueType> const & A, bool sym );
+
+    /*!
+     * \brief setup with the given block boundaries and \c load \c A.
+     */
+    void
+    setup(
+      integer                        nblks,
+      integer const                  rBlocks[],
+      SparseCCOOR<valueType> const & A,
+      bool                           sym
+    );
+
+    /*!
+     * \brief zero the blocks and scatter the entries of \c A.
+     *
+     * Entries of the upper off diagonal blocks are stored transposed in
+     * the \c L blocks, so \c A can hold the lower triangle or the whole
+     * matrix; with \c sym the entries of the diagonal blocks are also
+     * mirrored, as in \c insert.  The row to block map is computed once,
+     * the cost is linear in the number of entries.
+     */
+    void
+    load( SparseCCOOR<valueType> const & A, bool sym );
+
     void
     zero();
 
@@ -194,6 +194,8 @@ namespace lapack_wrapper {
   , fortran_indexing(fi)
   , matrix_is_full(false)
   , matrix_is_row_major(false)
+  , pattern_is_frozen(false)
+  , push_position(0)
   {
     this->vals.clear(); this->vals.reserve(reserve_nnz);
     this->rows.clear(); this->rows.reserve(reserve_nnz);
@@ -355,13 +357,15 @@ namespace lapack_wrapper {
     this->vals.clear();
     this->rows.clear();
     this->cols.clear();
+    this->unfreeze_pattern();
   }
 
   template <typename T>
   void
   SparseCCOOR<T>::setZero() {
-    if ( this->matrix_is_full ) {
+    if ( this->matrix_is_full || this->pattern_is_frozen ) {
       std::fill( this->vals.begin(), this->vals.end(), T(0) );
+      this->push_position = 0;
     } else {
       this->nnz = 0;
       this->vals.clear();
@@ -387,6 +391,7 @@ namespace lapack_wrapper {
     this->vals.clear(); this->vals.reserve(reserve_nnz);
     this->rows.clear(); this->rows.reserve(reserve_nnz);
     this->cols.clear(); this->cols.reserve(reserve_nnz);
+    this->unfreeze_pattern();
   }
 
   template <typename T>
@@ -408,6 +413,8 @@ namespace lapack_wrapper {
     }
     this->matrix_is_full      = true;
     this->matrix_is_row_major = false;
+
+    this->unfreeze_pattern();
   }
 
   template <typename T>
@@ -429,6 +436,8 @@ namespace lapack_wrapper {
     }
     this->matrix_is_full      = true;
     this->matrix_is_row_major = true;
+
+    this->unfreeze_pattern();
   }
 
   template <typename T>
@@ -460,6 +469,101 @@ namespace lapack_wrapper {
     this->cols.reserve(reserve_nnz);
   }
 
+  // order slots by column
+  class SparseCCOOR_column_less {
+    std::vector<integer> const & C;
+  public:
+    explicit
+    SparseCCOOR_column_less( std::vector<integer> const & C_in ) : C(C_in) {}
+    bool operator () ( integer a, integer b ) const { return C[a] < C[b]; }
+  };
+
+  template <typename T>
+  void
+  SparseCCOOR<T>::freeze_pattern() {
+    this->pattern_is_frozen = true;
+    this->push_position     = 0;
+    // slots by rows, stable sort by columns in each row
+    integer offs = this->fortran_indexing ? 1 : 0;
+    this->pattern_R.assign( size_t(this->nRows+1), 0 );
+    for ( integer k = 0; k < this->nnz; ++k ) ++this->pattern_R[this->rows[k]-offs+1];
+    for ( integer i = 0; i < this->nRows; ++i ) this->pattern_R[i+1] += this->pattern_R[i];
+    this->pattern_I.resize( size_t(this->nnz) );
+    std::vector<integer> fill( this->pattern_R.begin(), this->pattern_R.end()-1 );
+    for ( integer k = 0; k < this->nnz; ++k ) this->pattern_I[fill[this->rows[k]-offs]++] = k;
+    SparseCCOOR_column_less less( this->cols );
+    for ( integer i = 0; i < this->nRows; ++i )
+      std::stable_sort(
+        this->pattern_I.begin()+this->pattern_R[i],
+        this->pattern_I.begin()+this->pattern_R[i+1],
+        less
+      );
+    // collapse the duplicates in the slot of the first one with the value
+    // of the last one (the value get_matrix takes), then build again
+    std::vector<bool> drop;
+    for ( integer i = 0; i < this->nRows; ++i ) {
+      for ( integer kk = this->pattern_R[i]+1; kk < this->pattern_R[i+1]; ++kk ) {
+        integer first = this->pattern_I[kk-1];
+        integer k     = this->pattern_I[kk];
+        if ( this->cols[k] != this->cols[first] ) continue;
+        if ( drop.empty() ) drop.assign( size_t(this->nnz), false );
+        this->vals[first] = this->vals[k];
+        this->pattern_I[kk] = first; // next duplicates compare with first
+        drop[k] = true;
+      }
+    }
+    if ( !drop.empty() ) {
+      integer nz = 0;
+      for ( integer k = 0; k < this->nnz; ++k ) {
+        if ( drop[k] ) continue;
+        this->rows[nz] = this->rows[k];
+        this->cols[nz] = this->cols[k];
+        this->vals[nz] = this->vals[k];
+        ++nz;
+      }
+      this->rows.resize( size_t(nz) );
+      this->cols.resize( size_t(nz) );
+      this->vals.resize( size_t(nz) );
+      this->nnz = nz;
+      this->freeze_pattern();
+    }
+  }
+
+  template <typename T>
+  void
+  SparseCCOOR<T>::unfreeze_pattern() {
+    this->pattern_is_frozen = false;
+    this->push_position     = 0;
+    this->pattern_R.clear();
+    this->pattern_I.clear();
+  }
+
+  template <typename T>
+  integer
+  SparseCCOOR<T>::frozen_slot( integer i, integer j ) {
+    integer pos = this->push_position;
+    if ( pos >= this->nnz || this->rows[pos] != i || this->cols[pos] != j ) {
+      // out of the assembly order: search the slot in the row
+      integer offs = this->fortran_indexing ? 1 : 0;
+      integer lo = this->pattern_R[i-offs];
+      integer hi = this->pattern_R[i-offs+1];
+      integer ie = hi;
+      while ( lo < hi ) {
+        integer mid = (lo+hi)/2;
+        if ( this->cols[this->pattern_I[mid]] < j ) lo = mid+1;
+        else                                        hi = mid;
+      }
+      LAPACK_WRAPPER_ASSERT(
+        lo < ie && this->cols[this->pattern_I[lo]] == j,
+        "SparseCCOOR::push_value( " << i-offs << ", " << j-offs <<
+        ") not in the frozen pattern"
+      );
+      pos = this->pattern_I[lo];
+    }
+    this->push_position = pos+1;
+    return pos;
+  }
+
   template <typename T>
   void
   SparseCCOOR<T>::to_FORTRAN_indexing() {
@@ -498,10 +602,14 @@ namespace lapack_wrapper {
        else                             vals[ row + col * nRows ] =  val;
     } else {
       if ( this->fortran_indexing ) { ++row; ++col; }
-      this->vals.push_back(val);
-      this->rows.push_back(row);
-      this->cols.push_back(col);
-      ++this->nnz;
+      if ( this->pattern_is_frozen ) {
+        this->vals[ this->frozen_slot( row, col ) ] = val;
+      } else {
+        this->vals.push_back(val);
+        this->rows.push_back(row);
+        this->cols.push_back(col);
+        ++this->nnz;
+      }
     }
   }
 
@@ -520,6 +628,8 @@ namespace lapack_wrapper {
     if ( this->matrix_is_full ) {
        if ( this->matrix_is_row_major ) vals[ col + row * nCols ] =  val;
        else                             vals[ row + col * nRows ] =  val;
+    } else if ( this->pattern_is_frozen ) {
+      this->vals[ this->frozen_slot( row, col ) ] = val;
     } else {
       this->vals.push_back(val);
       this->rows.push_back(row);
@@ -448,6 +448,14 @@ namespace lapack_wrapper {
     bool matrix_is_full;
     bool matrix_is_row_major;
 
+    // frozen pattern: slots sorted by (row,column) and assembly cursor
+    bool                 pattern_is_frozen;
+    integer              push_position;
+    std::vector<integer> pattern_R;
+    std::vector<integer> pattern_I;
+
+    integer frozen_slot( integer i, integer j );
+
   public:
 
     using SparseMatrixBase<real>::nRows;
@@ -459,6 +467,8 @@ namespace lapack_wrapper {
     , fortran_indexing(false)
     , matrix_is_full(false)
     , matrix_is_row_major(false)
+    , pattern_is_frozen(false)
+    , push_position(0)
     {}
 
     SparseCCOOR(
@@ -494,11 +504,27 @@ namespace lapack_wrapper {
     FORTRAN_indexing() const LAPACK_WRAPPER_OVERRIDE
     { return this->fortran_indexing; }
 
+    //! \c true if the matrix is stored full (see \c setup_as_full_row_major)
+    bool
+    is_full() const
+    { return this->matrix_is_full; }
+
+    //! \c true if the full matrix is stored by rows
+    bool
+    is_row_major() const
+    { return this->matrix_is_row_major; }
+
+    //! \c true if the pattern is frozen (see \c freeze_pattern)
+    bool
+    is_pattern_frozen() const
+    { return this->pattern_is_frozen; }
+
     virtual
     void
     transpose() LAPACK_WRAPPER_OVERRIDE {
       this->rows.swap(this->cols);
       std::swap( this->nRows, this->nCols );
+      if ( this->pattern_is_frozen ) this->freeze_pattern();
     }
 
     virtual
@@ -668,6 +694,26 @@ namespace lapack_wrapper {
     void
     reserve( integer reserve_nnz );
 
+    /*!
+     * \brief freeze_pattern:
+     *        fix the current pattern, the following pushes only write values.
+     *
+     * A push writes the value in the next slot when \c (row,col) follows
+     * the assembly order of the frozen pattern, otherwise the slot of
+     * \c (row,col) is searched in its row.  Pushing an entry outside the
+     * pattern is an error.  \c setZero clears the values and restarts the
+     * assembly order, so an assembly repeated in the same order is a
+     * streaming write with no allocation.  Entries pushed more than once
+     * before freezing are collapsed in one slot, in the position of the
+     * first push and with the value of the last one.
+     */
+    void
+    freeze_pattern();
+
+    //! back to the standard mode, new pushes append entries
+    void
+    unfreeze_pattern();
+
     void
     get_full_view( MatrixWrapper<valueType> & MW ) LAPACK_WRAPPER_OVERRIDE {
       LAPACK_WRAPPER_ASSERT(
@@ -14,6 +14,29 @@ namespace SparseTool {
   // #     #  #  #     # #     # #     #    #    #     # #     #
   // ######   #   #####   #####   #####     #    #     # ######
   */
+  //! Temporary vectors of \c bicgstab, reuse it to avoid allocation in repeated solves
+  template <typename T>
+  class BicgstabWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    Vector<T> p, s, t, v, r, rtilde;
+
+    BicgstabWorkspace() {}
+    explicit BicgstabWorkspace( indexType neq ) { resize(neq); }
+
+    //! size the vectors for a system with \c neq equations, no allocation if the size is unchanged
+    void
+    resize( indexType neq ) {
+      p.resize(neq);
+      s.resize(neq);
+      t.resize(neq);
+      v.resize(neq);
+      r.resize(neq);
+      rtilde.resize(neq);
+    }
+  };
+
   /*!
    *  Bi Conjugate Stabilized Conjugate Gradient Iterative Solver
    *
@@ -42,6 +65,7 @@ namespace SparseTool {
     valueType           epsi,
     indexType           maxIter,
     indexType         & iter,
+    BicgstabWorkspace<typename vector_type::valueType> & ws,
     ostream           * pStream = nullptr
   ) {
 
@@ -60,7 +84,13 @@ namespace SparseTool {
     typedef typename vector_type::valueType vType;
 
     indexType neq = b.size();
-    vector_type p(neq), s(neq), t(neq), v(neq), r(neq), rtilde(neq);
+    ws.resize(neq);
+    Vector<vType> & p      = ws.p;
+    Vector<vType> & s      = ws.s;
+    Vector<vType> & t      = ws.t;
+    Vector<vType> & v      = ws.v;
+    Vector<vType> & r      = ws.r;
+    Vector<vType> & rtilde = ws.rtilde;
 
     iter = 1;
 
@@ -119,10 +149,35 @@ namespace SparseTool {
 
     return resid;
   }
+
+  /*!
+   *  Same as the overload with the workspace, the temporary vectors
+   *  are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  bicgstab(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    BicgstabWorkspace<typename vector_type::valueType> ws;
+    return bicgstab( A, b, x, P, epsi, maxIter, iter, ws, pStream );
+  }
 }
 
 namespace SparseToolLoad {
   using ::SparseTool::bicgstab;
+  using ::SparseTool::BicgstabWorkspace;
 }
 
 #endif
@@ -13,6 +13,27 @@ namespace SparseTool {
   //  #    # #    # #    # #    #
   //   ####   ####   ####   ####
   */
+  //! Temporary vectors of \c cocg, reuse it to avoid allocation in repeated solves
+  template <typename T>
+  class CocgWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    Vector<T> p, q, r, rt;
+
+    CocgWorkspace() {}
+    explicit CocgWorkspace( indexType neq ) { resize(neq); }
+
+    //! size the vectors for a system with \c neq equations, no allocation if the size is unchanged
+    void
+    resize( indexType neq ) {
+      p.resize(neq);
+      q.resize(neq);
+      r.resize(neq);
+      rt.resize(neq);
+    }
+  };
+
   /*!
    *  Preconditioned Conjugate Gradient Iterative Solver
    *  \param A       coefficient matrix
@@ -42,6 +63,7 @@ namespace SparseTool {
     valueType   const & epsi,
     indexType   const   maxIter,
     indexType         & iter,
+    CocgWorkspace<typename vector_type::valueType> & ws,
     ostream           * pStream = nullptr
   ) {
     
@@ -59,7 +81,11 @@ namespace SparseTool {
     typedef typename vector_type::valueType vType;
 
     indexType   neq = b.size();
-    vector_type p(neq), q(neq), r(neq), rt(neq);
+    ws.resize(neq);
+    Vector<vType> & p  = ws.p;
+    Vector<vType> & q  = ws.q;
+    Vector<vType> & r  = ws.r;
+    Vector<vType> & rt = ws.rt;
     valueType   resid;
     vType       rho, mu, alpha, beta;
 
@@ -97,10 +123,35 @@ namespace SparseTool {
     return resid;
   }
 
+  /*!
+   *  Same as the overload with the workspace, the temporary vectors
+   *  are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  cocg(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType   const & epsi,
+    indexType   const   maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    CocgWorkspace<typename vector_type::valueType> ws;
+    return cocg( A, b, x, P, epsi, maxIter, iter, ws, pStream );
+  }
+
 }
 
 namespace SparseToolLoad {
   using ::SparseTool::cocg;
+  using ::SparseTool::CocgWorkspace;
 }
 
 #endif
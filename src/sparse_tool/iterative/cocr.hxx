@@ -14,6 +14,29 @@ namespace SparseTool {
   //  #    # #    # #    # #   #  
   //   ####   ####   ####  #    #                             
   */
+  //! Temporary vectors of \c cocr, reuse it to avoid allocation in repeated solves
+  template <typename T>
+  class CocrWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    Vector<T> p, q, qt, r, rt, Art;
+
+    CocrWorkspace() {}
+    explicit CocrWorkspace( indexType neq ) { resize(neq); }
+
+    //! size the vectors for a system with \c neq equations, no allocation if the size is unchanged
+    void
+    resize( indexType neq ) {
+      p.resize(neq);
+      q.resize(neq);
+      qt.resize(neq);
+      r.resize(neq);
+      rt.resize(neq);
+      Art.resize(neq);
+    }
+  };
+
   /*!
    *  Preconditioned Conjugate Gradient Iterative Solver
    *  \param A       coefficient matrix
@@ -43,6 +66,7 @@ namespace SparseTool {
     valueType   const & epsi,
     indexType   const   maxIter,
     indexType         & iter,
+    CocrWorkspace<typename vector_type::valueType> & ws,
     ostream           * pStream = nullptr
   ) {
 
@@ -60,7 +84,13 @@ namespace SparseTool {
     typedef typename vector_type::valueType vType;
 
     indexType   neq = b.size();
-    vector_type p(neq), q(neq), qt(neq), r(neq), rt(neq), Art(neq);
+    ws.resize(neq);
+    Vector<vType> & p   = ws.p;
+    Vector<vType> & q   = ws.q;
+    Vector<vType> & qt  = ws.qt;
+    Vector<vType> & r   = ws.r;
+    Vector<vType> & rt  = ws.rt;
+    Vector<vType> & Art = ws.Art;
     valueType   resid;
     vType       rho, mu, alpha, beta;
 
@@ -102,10 +132,35 @@ namespace SparseTool {
     return resid;
   }
 
+  /*!
+   *  Same as the overload with the workspace, the temporary vectors
+   *  are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  cocr(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType   const & epsi,
+    indexType   const   maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    CocrWorkspace<typename vector_type::valueType> ws;
+    return cocr( A, b, x, P, epsi, maxIter, iter, ws, pStream );
+  }
+
 }
 
 namespace SparseToolLoad {
   using ::SparseTool::cocr;
+  using ::SparseTool::CocrWorkspace;
 }
 
 #endif
@@ -0,0 +1,235 @@
+#ifndef SPARSETOOL_ITERATIVE_FGMRES_HH
+#define SPARSETOOL_ITERATIVE_FGMRES_HH
+
+#include <type_traits>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  ######   #####    #     #  #####   #####   ####
+  //  #       #     #   ##   ##  #    #  #      #    #
+  //  #       #         # # # #  #    #  #      #
+  //  #####   #         #  #  #  #####   ####    ####
+  //  #       #  ####   #     #  #    #  #           #
+  //  #       #      #  #     #  #     # #      #    #
+  //  #        ######   #     #  #     # #####   ####
+  */
+  //! \cond NODOC
+
+  // z = P^(-1) v for a class derived from Preco<PRECO>
+  template <typename PRECO, typename VECTOR>
+  inline
+  void
+  fgmres_apply( PRECO const & P, VECTOR & z, VECTOR const & v, std::true_type )
+  { P.assPreco( z, v ); }
+
+  // z = P^(-1) v for a generic callable P(z,v)
+  template <typename PRECO, typename VECTOR>
+  inline
+  void
+  fgmres_apply( PRECO const & P, VECTOR & z, VECTOR const & v, std::false_type )
+  { P( z, v ); }
+
+  //! \endcond
+
+  //! Krylov basis, preconditioned directions and temporaries of \c fgmres
+  template <typename T>
+  class FgmresWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    Vector<T>          w, r, H, s, cs, sn;
+    Vector<Vector<T> > v, z;
+
+    FgmresWorkspace() {}
+    FgmresWorkspace( indexType neq, indexType m ) { resize(neq,m); }
+
+    //! size the buffers for \c neq equations and Krylov dimension \c m, no allocation if the sizes are unchanged
+    void
+    resize( indexType neq, indexType m ) {
+      indexType m1 = m+1;
+      w.resize(neq);
+      r.resize(neq);
+      H.resize(m1*m1);
+      s.resize(m1);
+      cs.resize(m1);
+      sn.resize(m1);
+      v.resize(m1);
+      z.resize(m);
+      for ( indexType nv = 0; nv < m1; ++nv ) v(nv).resize(neq);
+      for ( indexType nv = 0; nv < m;  ++nv ) z(nv).resize(neq);
+    }
+  };
+
+  /*!
+   *  Flexible Generalized Minimal Residual Iterative Solver
+   *  \param A       coefficient matrix
+   *  \param b       righ hand side
+   *  \param x       guess and solution
+   *  \param P       preconditioner, a class derived from \c Preco or a
+   *                 callable object <tt> P(z,v) </tt> storing in \c z the
+   *                 approximate solution of \f$ M z = v \f$
+   *  \param epsi    Admitted tolerance
+   *  \param m       maximum dimension of Krilov subspace
+   *  \param maxIter maximum number of admitted iteration
+   *  \param iter    total number of performed itaration
+   *  \param ws      workspace with the Krylov basis and the temporaries
+   *  \param pStream pointer to stream object for messages
+   *  \return last computed residual
+   *
+   *  Right preconditioned GMRES of Saad where the preconditioned
+   *  directions \f$ z_i = M_i^{-1} v_i \f$ are stored together with the
+   *  Krylov basis, so the preconditioner may change at every iteration
+   *  (inner iterative solver, multigrid cycle, ...).
+   *  The returned residual is the one of the unpreconditioned system.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  fgmres(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           m, // maxSubIter
+    indexType           maxIter,
+    indexType         & iter,
+    FgmresWorkspace<typename vector_type::valueType> & ws,
+    ostream           * pStream = nullptr
+  ) {
+
+    using ::SparseToolFun::absval;
+    typedef typename vector_type::valueType vType;
+    typedef std::integral_constant<
+      bool, std::is_base_of<Preco<preco_type>,preco_type>::value
+    > is_preco;
+
+    SPARSETOOL_ASSERT(
+      A.numRows() == b.size() &&
+      A.numCols() == x.size() &&
+      A.numRows() == A.numCols(),
+      "Bad system in fgmres" <<
+      "dim matrix  = " << A.numRows() <<
+      " x " << A.numCols() <<
+      "\ndim r.h.s.  = " << b.size() <<
+      "\ndim unknown = " << x.size()
+    )
+    valueType resid = 0;
+    indexType m1    = m+1;
+    indexType neq   = b.size();
+    ws.resize(neq,m);
+    Vector<vType>          & w  = ws.w;
+    Vector<vType>          & r  = ws.r;
+    Vector<vType>          & H  = ws.H;
+    Vector<vType>          & s  = ws.s;
+    Vector<vType>          & cs = ws.cs;
+    Vector<vType>          & sn = ws.sn;
+    Vector<Vector<vType> > & v  = ws.v;
+    Vector<Vector<vType> > & z  = ws.z;
+
+    iter = 1;
+    do {
+
+      r  = b - A * x;
+      valueType beta = norm2(r);
+      if ( beta <= epsi ) { resid = beta; goto fine; }
+
+      vType betax = beta;
+      v(0) = r / betax;
+      s(0) = beta;
+      for ( indexType k = 1; k <= m; ++k ) s(k) = 0;
+
+      indexType i = 0;
+      do {
+
+        fgmres_apply( P, z(i), v(i), is_preco() );
+        w = A * z(i);
+
+        indexType k;
+        for ( k = 0; k <= i; ++k ) {
+          H(k*m1+i) = dot(v(k), w);
+          w -= H(k*m1+i) * v(k);
+        }
+
+        H((i+1)*m1+i) = norm2(w);
+        v(i+1)        = w / H((i+1)*m1+i);
+
+        for ( k = 0; k < i; ++k )
+          ApplyPlaneRotation(H(k*m1+i), H((k+1)*m1+i), cs(k), sn(k));
+
+        GeneratePlaneRotation(H(i*m1+i), H((i+1)*m1+i), cs(i), sn(i));
+        ApplyPlaneRotation(H(i*m1+i), H((i+1)*m1+i), cs(i), sn(i));
+        ApplyPlaneRotation(s(i), s(i+1), cs(i), sn(i));
+
+        ++i; ++iter;
+        resid = absval(s(i));
+        if ( pStream != nullptr ) (*pStream) << "iter = " << iter << " residual = " << resid << '\n';
+
+      } while ( i < m && iter <= maxIter && resid > epsi );
+
+      // Backsolve:
+      for ( int ii = i-1; ii >= 0; --ii ) {
+        s(ii) /= H(ii*m1+ii);
+        for ( int jj = ii - 1; jj >= 0; --jj )
+          s(jj) -= H(jj*m1+ii) * s(ii);
+      }
+
+      // update with the preconditioned directions
+      for ( indexType jj = 0; jj < i; ++jj )
+        x += z(jj) * s(jj);
+
+    } while ( iter <= maxIter );
+
+  fine:
+
+    return resid;
+  }
+
+  /*!
+   *  Same as the overload with the workspace, the Krylov basis
+   *  and the temporary vectors are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  fgmres(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           m, // maxSubIter
+    indexType           maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    FgmresWorkspace<typename vector_type::valueType> ws;
+    return fgmres( A, b, x, P, epsi, m, maxIter, iter, ws, pStream );
+  }
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::fgmres;
+  using ::SparseTool::FgmresWorkspace;
+}
+
+#endif
+
+/*
+// ####### ####### #######
+// #       #     # #
+// #       #     # #
+// #####   #     # #####
+// #       #     # #
+// #       #     # #
+// ####### ####### #
+*/
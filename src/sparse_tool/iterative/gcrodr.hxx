@@ -0,0 +1,425 @@
+#ifndef SPARSETOOL_ITERATIVE_GCRODR_HH
+#define SPARSETOOL_ITERATIVE_GCRODR_HH
+
+#include <type_traits>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //   #####   #####  ######  #######        ######  ######
+  //  #     # #     # #     # #     #        #     # #     #
+  //  #       #       #     # #     #        #     # #     #
+  //  #  #### #       ######  #     # #####  #     # ######
+  //  #     # #       #   #   #     #        #     # #   #
+  //  #     # #     # #    #  #     #        #     # #    #
+  //   #####   #####  #     # #######        ######  #     #
+  */
+
+  //! Recycle subspace and workspace of \c gcrodr
+  /*!
+   *  Store the \c k vectors \f$ U \f$ of the recycle subspace
+   *  (harmonic Ritz vectors of the last solve) and all the temporaries of
+   *  the solver.  The object must be kept alive between the solves of a
+   *  sequence of related systems, it is resized (and the recycle
+   *  subspace dropped) when the dimension of the system changes.
+   */
+  template <typename T>
+  class GcroDrRecycle {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    //! \cond NODOC
+    indexType kmax, kc, neq, mdim;
+    Vector<T> U, C, Ynew, Cnew, V, r, w, tmp,
+              H, Hr, B, g, cs, sn, cr, D, y,
+              G, VW, GP, Qe, E1, E2, Pk, Pt, R;
+    ::lapack_wrapper::QR<T> qr; //!< QR of the recycled and deflation blocks
+    //! \endcond
+
+    //! build an empty recycle space of at most \c k vectors
+    explicit
+    GcroDrRecycle( indexType k = 10 )
+    : kmax(k), kc(0), neq(0), mdim(0)
+    {}
+
+    //! maximum number of recycled vectors
+    indexType maxSize() const { return kmax; }
+
+    //! number of vectors in the recycle subspace
+    indexType size() const { return kc; }
+
+    //! drop the recycle subspace
+    void reset() { kc = 0; }
+
+    //! size the buffers for \c n equations and Krylov dimension \c m, no allocation if the sizes are unchanged
+    void
+    resize( indexType n, indexType m ) {
+      if ( n != neq ) kc = 0;
+      neq  = n;
+      mdim = m;
+      indexType m1 = m+1;
+      U.resize(n*kmax);
+      C.resize(n*kmax);
+      Ynew.resize(n*kmax);
+      Cnew.resize(n*kmax);
+      V.resize(n*m1);
+      r.resize(n);
+      w.resize(n);
+      tmp.resize(n);
+      H.resize(m1*m);
+      Hr.resize(m1*m);
+      B.resize(kmax*m);
+      g.resize(m1);
+      cs.resize(m);
+      sn.resize(m);
+      cr.resize(kmax);
+      D.resize(kmax);
+      y.resize(m);
+      G.resize(m1*m);
+      VW.resize(m1*m);
+      GP.resize(m1*kmax);
+      Qe.resize(m1*kmax);
+      E1.resize(m*m);
+      E2.resize(m*m);
+      Pk.resize(m*kmax);
+      Pt.resize(m*kmax);
+      R.resize(kmax*kmax);
+    }
+  };
+
+  /*!
+   *  GCRO-DR (Generalized Conjugate Residual with inner Orthogonalization
+   *  and Deflated Restarting) Iterative Solver
+   *  \param A       coefficient matrix
+   *  \param b       righ hand side
+   *  \param x       guess and solution
+   *  \param P       preconditioner
+   *  \param epsi    Admitted tolerance
+   *  \param m       maximum dimension of the search space (recycled + Krylov)
+   *  \param maxIter maximum number of admitted iteration
+   *  \param iter    total number of performed itaration
+   *  \param rec     recycle subspace, updated on exit
+   *  \param pStream pointer to stream object for messages
+   *  \return last computed residual
+   *
+   *  Left preconditioned GCRO-DR of Parks et al.
+   *  At each restart the \c k harmonic Ritz vectors associated to the
+   *  smallest harmonic Ritz values are kept in \c rec and the Arnoldi
+   *  process is run on the operator deflated by them.
+   *  When \c rec contains vectors from a previous solve (the matrix and
+   *  the preconditioner may be changed), they are mapped with the new
+   *  operator, orthonormalized and projected out of the initial residual,
+   *  so the solve starts with the slow modes already removed.
+   *  Only real \c float or \c double values are supported.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  gcrodr(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           m,
+    indexType           maxIter,
+    indexType         & iter,
+    GcroDrRecycle<valueType> & rec,
+    ostream           * pStream = nullptr
+  ) {
+
+    static_assert(
+      ( std::is_same<valueType,float>::value ||
+        std::is_same<valueType,double>::value ) &&
+      std::is_same<typename vector_type::valueType,valueType>::value,
+      "gcrodr supports only real float or double values"
+    );
+
+    using ::SparseToolFun::absval;
+    using ::lapack_wrapper::integer;
+    using ::lapack_wrapper::gemm;
+    using ::lapack_wrapper::gemv;
+    using ::lapack_wrapper::trsm;
+    using ::lapack_wrapper::trsv;
+    using ::lapack_wrapper::nrm2;
+    using ::lapack_wrapper::NO_TRANSPOSE;
+    using ::lapack_wrapper::TRANSPOSE;
+    using ::lapack_wrapper::RIGHT;
+    using ::lapack_wrapper::UPPER;
+    using ::lapack_wrapper::NON_UNIT;
+
+    SPARSETOOL_ASSERT(
+      A.numRows() == b.size() &&
+      A.numCols() == x.size() &&
+      A.numRows() == A.numCols(),
+      "Bad system in gcrodr" <<
+      "dim matrix  = " << A.numRows() <<
+      " x " << A.numCols() <<
+      "\ndim r.h.s.  = " << b.size() <<
+      "\ndim unknown = " << x.size()
+    )
+    SPARSETOOL_ASSERT(
+      m > rec.maxSize(),
+      "gcrodr, m = " << m << " must be greater than the recycle size " << rec.maxSize()
+    )
+
+    indexType neq = b.size();
+    indexType m1  = m+1;
+    integer   n   = integer(neq);
+    integer   ld  = integer(m1);
+    rec.resize(neq,m);
+
+    indexType kmax = rec.kmax;
+    indexType kc   = rec.kc;
+
+    Vector<valueType> & U  = rec.U;
+    Vector<valueType> & C  = rec.C;
+    Vector<valueType> & V  = rec.V;
+    Vector<valueType> & r  = rec.r;
+    Vector<valueType> & w  = rec.w;
+    Vector<valueType> & tp = rec.tmp;
+    Vector<valueType> & H  = rec.H;
+    Vector<valueType> & Hr = rec.Hr;
+    Vector<valueType> & Bm = rec.B;
+    Vector<valueType> & g  = rec.g;
+    Vector<valueType> & cs = rec.cs;
+    Vector<valueType> & sn = rec.sn;
+    Vector<valueType> & cr = rec.cr;
+    Vector<valueType> & D  = rec.D;
+    Vector<valueType> & y  = rec.y;
+
+    ::lapack_wrapper::QR<valueType> & qr = rec.qr;
+
+    iter = 1;
+    r = b - A * x;
+    r = r / P;
+    valueType resid = norm2(r);
+    if ( resid <= epsi ) { rec.kc = kc; return resid; }
+
+    if ( kc > 0 ) {
+      // C = P^(-1) A U with the current operator, orthonormalize
+      for ( indexType i = 0; i < kc; ++i ) {
+        std::copy( &U(i*neq), &U(i*neq)+neq, &tp(0) );
+        w = A * tp;
+        w = w / P;
+        std::copy( &w(0), &w(0)+neq, &C(i*neq) );
+      }
+      qr.factorize( "gcrodr", n, integer(kc), &C(0), n );
+      qr.getR( &rec.R(0), integer(kc) );
+      std::fill( &C(0), &C(0)+neq*kc, valueType(0) );
+      for ( indexType i = 0; i < kc; ++i ) C(i*neq+i) = 1;
+      qr.Q_mul( n, integer(kc), &C(0), n );
+      trsm( RIGHT, UPPER, NO_TRANSPOSE, NON_UNIT,
+            n, integer(kc), 1, &rec.R(0), integer(kc), &U(0), n );
+      // x += U C' r, r -= C C' r
+      gemv( TRANSPOSE, n, integer(kc), 1, &C(0), n, &r(0), 1, 0, &cr(0), 1 );
+      gemv( NO_TRANSPOSE, n, integer(kc), 1, &U(0), n, &cr(0), 1, 0, &tp(0), 1 );
+      for ( indexType k = 0; k < neq; ++k ) x(k) += tp(k);
+      gemv( NO_TRANSPOSE, n, integer(kc), -1, &C(0), n, &cr(0), 1, 1, &r(0), 1 );
+    }
+
+    do {
+
+      valueType beta = norm2(r);
+      resid = beta;
+      if ( beta <= epsi ) break;
+
+      if ( kc > 0 )
+        gemv( TRANSPOSE, n, integer(kc), 1, &C(0), n, &r(0), 1, 0, &cr(0), 1 );
+
+      for ( indexType k = 0; k < neq; ++k ) V(k) = r(k)/beta;
+      g.setZero();
+      g(0) = beta;
+
+      // Arnoldi with the operator (I-CC') P^(-1) A
+      indexType mm = m - kc;
+      indexType j  = 0;
+      do {
+        std::copy( &V(j*neq), &V(j*neq)+neq, &tp(0) );
+        w = A * tp;
+        w = w / P;
+        if ( kc > 0 ) {
+          gemv( TRANSPOSE, n, integer(kc), 1, &C(0), n, &w(0), 1, 0, &Bm(j*kmax), 1 );
+          gemv( NO_TRANSPOSE, n, integer(kc), -1, &C(0), n, &Bm(j*kmax), 1, 1, &w(0), 1 );
+        }
+        for ( indexType i = 0; i <= j; ++i ) {
+          valueType const * Vi = &V(i*neq);
+          valueType hij = 0;
+          for ( indexType k = 0; k < neq; ++k ) hij += Vi[k]*w(k);
+          for ( indexType k = 0; k < neq; ++k ) w(k) -= hij*Vi[k];
+          H(i+j*m1) = hij;
+        }
+        valueType hj1 = norm2(w);
+        H(j+1+j*m1) = hj1;
+        valueType * Vj1 = &V((j+1)*neq);
+        valueType ih = hj1 > 0 ? 1/hj1 : 0; // zero on lucky breakdown
+        for ( indexType k = 0; k < neq; ++k ) Vj1[k] = w(k)*ih;
+
+        for ( indexType i = 0; i <= j+1; ++i ) Hr(i+j*m1) = H(i+j*m1);
+        for ( indexType i = 0; i < j; ++i )
+          ApplyPlaneRotation(Hr(i+j*m1), Hr(i+1+j*m1), cs(i), sn(i));
+        GeneratePlaneRotation(Hr(j+j*m1), Hr(j+1+j*m1), cs(j), sn(j));
+        ApplyPlaneRotation(Hr(j+j*m1), Hr(j+1+j*m1), cs(j), sn(j));
+        ApplyPlaneRotation(g(j), g(j+1), cs(j), sn(j));
+
+        ++j; ++iter;
+        resid = absval(g(j));
+        if ( pStream != nullptr ) (*pStream) << "iter = " << iter << " residual = " << resid << '\n';
+
+      } while ( j < mm && iter <= maxIter && resid > epsi );
+
+      // x += V y + U (C'r - B y)
+      std::copy( &g(0), &g(0)+j, &y(0) );
+      trsv( UPPER, NO_TRANSPOSE, NON_UNIT, integer(j), &Hr(0), ld, &y(0), 1 );
+      gemv( NO_TRANSPOSE, n, integer(j), 1, &V(0), n, &y(0), 1, 1, &x(0), 1 );
+      if ( kc > 0 ) {
+        gemv( NO_TRANSPOSE, integer(kc), integer(j), -1, &Bm(0), integer(kmax), &y(0), 1, 1, &cr(0), 1 );
+        gemv( NO_TRANSPOSE, n, integer(kc), 1, &U(0), n, &cr(0), 1, 1, &x(0), 1 );
+      }
+
+      r = b - A * x;
+      r = r / P;
+
+      // new recycle space from the harmonic Ritz vectors of the search space
+      indexType nw = kc+j;
+      indexType nv = nw+1;
+      indexType nk = std::min( kmax, nw );
+
+      Vector<valueType> & G  = rec.G;
+      Vector<valueType> & VW = rec.VW;
+      Vector<valueType> & E1 = rec.E1;
+      Vector<valueType> & E2 = rec.E2;
+      Vector<valueType> & Pk = rec.Pk;
+      Vector<valueType> & Pt = rec.Pt;
+      Vector<valueType> & GP = rec.GP;
+      Vector<valueType> & Qe = rec.Qe;
+
+      for ( indexType i = 0; i < kc; ++i ) D(i) = 1/nrm2( n, &U(i*neq), 1 );
+
+      // G = [ D B ; 0 Hbar ], VW = [C V]'[U*D V]
+      G.setZero();
+      VW.setZero();
+      for ( indexType i = 0; i < kc; ++i ) {
+        G(i+i*m1) = D(i);
+        for ( indexType jj = 0; jj < j; ++jj ) G(i+(kc+jj)*m1) = Bm(i+jj*kmax);
+      }
+      for ( indexType jj = 0; jj < j; ++jj ) {
+        for ( indexType ii = 0; ii <= jj+1; ++ii ) G(kc+ii+(kc+jj)*m1) = H(ii+jj*m1);
+        VW(kc+jj+(kc+jj)*m1) = 1;
+      }
+      if ( kc > 0 ) {
+        gemm( TRANSPOSE, NO_TRANSPOSE, integer(kc), integer(kc), n,
+              1, &C(0), n, &U(0), n, 0, &VW(0), ld );
+        gemm( TRANSPOSE, NO_TRANSPOSE, integer(j+1), integer(kc), n,
+              1, &V(0), n, &U(0), n, 0, &VW(kc), ld );
+        for ( indexType l = 0; l < kc; ++l )
+          for ( indexType i = 0; i < nv; ++i )
+            VW(i+l*m1) *= D(l);
+      }
+
+      // (G'G) z = theta (G'VW) z
+      gemm( TRANSPOSE, NO_TRANSPOSE, integer(nw), integer(nw), integer(nv),
+            1, &G(0), ld, &G(0), ld, 0, &E1(0), integer(nw) );
+      gemm( TRANSPOSE, NO_TRANSPOSE, integer(nw), integer(nw), integer(nv),
+            1, &G(0), ld, &VW(0), ld, 0, &E2(0), integer(nw) );
+
+      ::lapack_wrapper::GeneralizedEigenvectors<valueType> gev(
+        integer(nw), &E1(0), integer(nw), &E2(0), integer(nw)
+      );
+      vector<valueType> re, im;
+      vector<vector<std::complex<valueType> > > vecs;
+      gev.getEigenvalues( re, im );
+      gev.getRightEigenvector( vecs );
+
+      // select the nk smallest in modulus, a complex pair gives its
+      // real and imaginary part
+      vector<indexType> idx(nw);
+      vector<valueType> mods(nw);
+      for ( indexType i = 0; i < nw; ++i ) {
+        idx[i]  = i;
+        mods[i] = std::hypot(re[i],im[i]);
+        if ( !(mods[i] == mods[i]) ) mods[i] = std::numeric_limits<valueType>::infinity();
+      }
+      std::sort( idx.begin(), idx.end(),
+                 [&mods]( indexType a, indexType b2 ) { return mods[a] < mods[b2]; } );
+      vector<bool> used(nw,false);
+      indexType    np = 0;
+      for ( indexType ii = 0; ii < nw && np < nk; ++ii ) {
+        indexType i = idx[ii];
+        if ( used[i] ) continue;
+        used[i] = true;
+        for ( indexType l = 0; l < nw; ++l ) Pk(l+np*nw) = vecs[i][l].real();
+        ++np;
+        if ( im[i] != 0 ) {
+          indexType ic = im[i] > 0 ? i+1 : i-1;
+          used[ic] = true;
+          if ( np < nk ) {
+            for ( indexType l = 0; l < nw; ++l ) Pk(l+np*nw) = vecs[i][l].imag();
+            ++np;
+          }
+        }
+      }
+      nk = np;
+
+      if ( nk > 0 ) {
+        // Ynew = [U*D V] Pk
+        for ( indexType l = 0; l < nk; ++l )
+          for ( indexType i = 0; i < kc; ++i )
+            Pt(i+l*nw) = D(i)*Pk(i+l*nw);
+        if ( kc > 0 )
+          gemm( NO_TRANSPOSE, NO_TRANSPOSE, n, integer(nk), integer(kc),
+                1, &U(0), n, &Pt(0), integer(nw), 0, &rec.Ynew(0), n );
+        gemm( NO_TRANSPOSE, NO_TRANSPOSE, n, integer(nk), integer(j),
+              1, &V(0), n, &Pk(kc), integer(nw), kc > 0 ? 1 : 0, &rec.Ynew(0), n );
+
+        // G Pk = Q R
+        gemm( NO_TRANSPOSE, NO_TRANSPOSE, integer(nv), integer(nk), integer(nw),
+              1, &G(0), ld, &Pk(0), integer(nw), 0, &GP(0), ld );
+        qr.factorize( "gcrodr", integer(nv), integer(nk), &GP(0), ld );
+        qr.getR( &rec.R(0), integer(nk) );
+        Qe.setZero();
+        for ( indexType l = 0; l < nk; ++l ) Qe(l+l*m1) = 1;
+        qr.Q_mul( integer(nv), integer(nk), &Qe(0), ld );
+
+        // Cnew = [C V] Q, Unew = Ynew R^(-1)
+        if ( kc > 0 )
+          gemm( NO_TRANSPOSE, NO_TRANSPOSE, n, integer(nk), integer(kc),
+                1, &C(0), n, &Qe(0), ld, 0, &rec.Cnew(0), n );
+        gemm( NO_TRANSPOSE, NO_TRANSPOSE, n, integer(nk), integer(j+1),
+              1, &V(0), n, &Qe(kc), ld, kc > 0 ? 1 : 0, &rec.Cnew(0), n );
+        trsm( RIGHT, UPPER, NO_TRANSPOSE, NON_UNIT,
+              n, integer(nk), 1, &rec.R(0), integer(nk), &rec.Ynew(0), n );
+
+        U.swap(rec.Ynew);
+        C.swap(rec.Cnew);
+        kc = nk;
+      }
+
+    } while ( iter <= maxIter );
+
+    rec.kc = kc;
+    return resid;
+  }
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::gcrodr;
+  using ::SparseTool::GcroDrRecycle;
+}
+
+#endif
+
+/*
+// ####### ####### #######
+// #       #     # #
+// #       #     # #
+// #####   #     # #####
+// #       #     # #
+// #       #     # #
+// ####### ####### #
+*/
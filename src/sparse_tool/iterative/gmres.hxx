@@ -57,6 +57,33 @@ namespace SparseTool {
     dx = temp;
   }
   //! \endcond
+
+  //! Krylov basis and temporaries of \c gmres, reuse it to avoid allocation in repeated solves
+  template <typename T>
+  class GmresWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    Vector<T>         w, r, H, s, cs, sn;
+    Vector<Vector<T> > v;
+
+    GmresWorkspace() {}
+    GmresWorkspace( indexType neq, indexType m ) { resize(neq,m); }
+
+    //! size the buffers for \c neq equations and Krylov dimension \c m, no allocation if the sizes are unchanged
+    void
+    resize( indexType neq, indexType m ) {
+      indexType m1 = m+1;
+      w.resize(neq);
+      r.resize(neq);
+      H.resize(m1*m1);
+      s.resize(m1);
+      cs.resize(m1);
+      sn.resize(m1);
+      v.resize(m1);
+      for ( indexType nv = 0; nv < m1; ++nv ) v(nv).resize(neq);
+    }
+  };
   
   /*!
    *  Generalized Minimal Residual Iterative Solver
@@ -86,10 +113,12 @@ namespace SparseTool {
     indexType           m, // maxSubIter
     indexType           maxIter,
     indexType         & iter,
+    GmresWorkspace<typename vector_type::valueType> & ws,
     ostream           * pStream = nullptr
   ) {
 
     using ::SparseToolFun::absval;
+    typedef typename vector_type::valueType vType;
 
     SPARSETOOL_ASSERT(
       A.numRows() == b.size() &&
@@ -104,10 +133,14 @@ namespace SparseTool {
     valueType resid = 0;
     indexType m1    = m+1;
     indexType neq   = b.size();
-    vector_type w(neq), r(neq), H(m1*m1), s(m1), cs(m1), sn(m1);
-    
-    Vector<vector_type> v(m1);
-    for ( indexType nv = 0; nv <= m; ++nv ) v(nv) . resize(neq);
+    ws.resize(neq,m);
+    Vector<vType>          & w  = ws.w;
+    Vector<vType>          & r  = ws.r;
+    Vector<vType>          & H  = ws.H;
+    Vector<vType>          & s  = ws.s;
+    Vector<vType>          & cs = ws.cs;
+    Vector<vType>          & sn = ws.sn;
+    Vector<Vector<vType> > & v  = ws.v;
 
     iter = 1;
     do {
@@ -166,10 +199,36 @@ namespace SparseTool {
 
     return resid;
   }
+
+  /*!
+   *  Same as the overload with the workspace, the Krylov basis
+   *  and the temporary vectors are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  gmres(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           m, // maxSubIter
+    indexType           maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    GmresWorkspace<typename vector_type::valueType> ws;
+    return gmres( A, b, x, P, epsi, m, maxIter, iter, ws, pStream );
+  }
 }
 
 namespace SparseToolLoad {
   using ::SparseTool::gmres;
+  using ::SparseTool::GmresWorkspace;
 }
 
 #endif
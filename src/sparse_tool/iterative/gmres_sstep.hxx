@@ -0,0 +1,404 @@
+#ifndef SPARSETOOL_ITERATIVE_GMRES_SSTEP_HH
+#define SPARSETOOL_ITERATIVE_GMRES_SSTEP_HH
+
+#include <type_traits>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //   #####    #     #  #####   #####   ####           ####   ####  ##### ###### #####
+  //  #     #   ##   ##  #    #  #      #    #         #      #        #   #      #    #
+  //  #         # # # #  #    #  #      #               ####   ####    #   #####  #    #
+  //  #         #  #  #  #####   ####    ####               #      #   #   #      #####
+  //  #  ####   #     #  #    #  #           #         #    # #    #   #   #      #
+  //  #      #  #     #  #     # #      #    #         #    # #    #   #   #      #
+  //   ######   #     #  #     # #####   ####  #####    ####   ####    #   ###### #
+  */
+  //! \cond NODOC
+
+  /*
+  //  Order the Ritz values in modified Leja order keeping complex
+  //  conjugate pairs adjacent. On output the first ns entries of
+  //  thRe and thIm2 define the shifts of the Newton basis:
+  //    K(k+1) = Op K(k) - thRe(k) K(k) + thIm2(k) K(k-1)
+  //  where thIm2(k) != 0 only for the second element of a pair.
+  */
+  template <typename valueType>
+  inline
+  void
+  gmres_sstep_leja(
+    vector<valueType> const & re,
+    vector<valueType> const & im,
+    indexType                 ns,
+    Vector<valueType>       & thRe,
+    Vector<valueType>       & thIm2
+  ) {
+    indexType         n = indexType(re.size());
+    vector<bool>      used(n,false);
+    vector<valueType> lprod(n,0);
+    thRe.setZero();
+    thIm2.setZero();
+    indexType k = 0;
+    while ( k < ns && k < n ) {
+      // first the largest modulus, then maximize the product of distances
+      indexType ipos = n;
+      valueType best = 0;
+      for ( indexType i = 0; i < n; ++i ) {
+        if ( used[i] || im[i] < 0 ) continue;
+        valueType v = k == 0 ? std::hypot(re[i],im[i]) : lprod[i];
+        if ( ipos == n || v > best ) { ipos = i; best = v; }
+      }
+      if ( ipos == n ) break;
+      used[ipos] = true;
+      thRe(k) = re[ipos];
+      bool pair = im[ipos] > 0 && k+1 < ns;
+      for ( indexType i = 0; i < n; ++i ) {
+        if ( used[i] ) continue;
+        valueType d = std::hypot(re[i]-re[ipos],im[i]-im[ipos]);
+        if ( im[ipos] > 0 ) d *= std::hypot(re[i]-re[ipos],im[i]+im[ipos]);
+        lprod[i] += std::log(d+std::numeric_limits<valueType>::min());
+      }
+      ++k;
+      if ( pair ) {
+        // the conjugate is consumed together with ipos
+        for ( indexType i = 0; i < n; ++i )
+          if ( !used[i] && im[i] < 0 && re[i] == re[ipos] ) { used[i] = true; break; }
+        thRe(k)  = re[ipos];
+        thIm2(k) = im[ipos]*im[ipos];
+        ++k;
+      }
+    }
+  }
+  //! \endcond
+
+  //! Krylov basis and temporaries of \c gmres_sstep, reuse it to avoid allocation in repeated solves
+  template <typename T>
+  class GmresSstepWorkspace {
+  public:
+    typedef T valueType; //!< type of the elements of the vectors
+
+    // V   = Krylov basis (column major, neq x (m+1))
+    // H   = Hessenberg matrix in the basis V, Hr = H reduced by rotations
+    // Ts  = coordinates of the s-step basis [q_c,W] in the basis V
+    // C,G = block projections and right hand side for the new columns of H
+    Vector<T> V, H, Hr, Ts, C, Cp, G, R, g, cs, sn, thRe, thIm2;
+    Vector<T> r, w, tmp;
+
+    ::lapack_wrapper::QR<T> qr; //!< tall skinny QR of the blocks
+
+    GmresSstepWorkspace() {}
+    GmresSstepWorkspace( indexType neq, indexType s, indexType m ) { resize(neq,s,m); }
+
+    //! size the buffers for \c neq equations, block \c s and Krylov dimension \c m (a multiple of \c s), no allocation if the sizes are unchanged
+    void
+    resize( indexType neq, indexType s, indexType m ) {
+      indexType m1 = m+1;
+      V.resize(neq*m1);
+      H.resize(m1*m);
+      Hr.resize(m1*m);
+      Ts.resize(m1*(s+1));
+      C.resize(m1*s);
+      Cp.resize(m1*s);
+      G.resize(m1*s);
+      R.resize(s*s);
+      g.resize(m1);
+      cs.resize(m);
+      sn.resize(m);
+      thRe.resize(s);
+      thIm2.resize(s);
+      r.resize(neq);
+      w.resize(neq);
+      tmp.resize(neq);
+    }
+  };
+
+  /*!
+   *  s-step (communication avoiding) Generalized Minimal Residual Iterative Solver
+   *  \param A       coefficient matrix
+   *  \param b       righ hand side
+   *  \param x       guess and solution
+   *  \param P       preconditioner
+   *  \param epsi    Admitted tolerance
+   *  \param s       number of basis vectors generated for each block
+   *  \param m       maximum dimension of Krilov subspace (rounded up to a multiple of \c s)
+   *  \param maxIter maximum number of admitted iteration
+   *  \param iter    total number of performed itaration
+   *  \param pStream pointer to stream object for messages
+   *  \return last computed residual
+   *
+   *  Same left preconditioned minimization of \c gmres, but the Krylov basis
+   *  is built \c s vectors at a time.  Each block is generated without
+   *  inner products (monomial basis in the first cycle, Newton basis with
+   *  Leja ordered Ritz values of the first cycle afterwards), projected out
+   *  of the previous basis by two passes of block Gram-Schmidt done with
+   *  \c gemm and orthonormalized by a tall skinny Householder QR
+   *  (\c lapack_wrapper::QR).  The Hessenberg matrix is recovered from the
+   *  change of basis with a triangular solve, so the number of global
+   *  reductions per cycle is reduced by a factor \c s.
+   *  Only real \c float or \c double values are supported.
+   *
+   *  Worth it when reductions dominate, it may need more iterations.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  gmres_sstep(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           s,
+    indexType           m, // maxSubIter
+    indexType           maxIter,
+    indexType         & iter,
+    GmresSstepWorkspace<typename vector_type::valueType> & ws,
+    ostream           * pStream = nullptr
+  ) {
+
+    static_assert(
+      ( std::is_same<valueType,float>::value ||
+        std::is_same<valueType,double>::value ) &&
+      std::is_same<typename vector_type::valueType,valueType>::value,
+      "gmres_sstep supports only real float or double values"
+    );
+
+    using ::SparseToolFun::absval;
+    using ::lapack_wrapper::integer;
+    using ::lapack_wrapper::gemm;
+    using ::lapack_wrapper::gemv;
+    using ::lapack_wrapper::trsm;
+    using ::lapack_wrapper::trsv;
+    using ::lapack_wrapper::NO_TRANSPOSE;
+    using ::lapack_wrapper::TRANSPOSE;
+
+    SPARSETOOL_ASSERT(
+      A.numRows() == b.size() &&
+      A.numCols() == x.size() &&
+      A.numRows() == A.numCols(),
+      "Bad system in gmres_sstep" <<
+      "dim matrix  = " << A.numRows() <<
+      " x " << A.numCols() <<
+      "\ndim r.h.s.  = " << b.size() <<
+      "\ndim unknown = " << x.size()
+    )
+    SPARSETOOL_ASSERT(
+      s > 0 && m > 0 && s <= b.size(),
+      "gmres_sstep, bad block size s = " << s << " or m = " << m
+    )
+
+    valueType resid = 0;
+    indexType neq   = b.size();
+    m = ((m+s-1)/s)*s;
+    indexType m1 = m+1;
+    integer   n  = integer(neq);
+    integer   ld = integer(m1);
+
+    ws.resize( neq, s, m );
+    Vector<valueType> & V     = ws.V;
+    Vector<valueType> & H     = ws.H;
+    Vector<valueType> & Hr    = ws.Hr;
+    Vector<valueType> & T     = ws.Ts;
+    Vector<valueType> & C     = ws.C;
+    Vector<valueType> & Cp    = ws.Cp;
+    Vector<valueType> & G     = ws.G;
+    Vector<valueType> & R     = ws.R;
+    Vector<valueType> & g     = ws.g;
+    Vector<valueType> & cs    = ws.cs;
+    Vector<valueType> & sn    = ws.sn;
+    Vector<valueType> & thRe  = ws.thRe;
+    Vector<valueType> & thIm2 = ws.thIm2;
+    Vector<valueType> & r     = ws.r;
+    Vector<valueType> & w     = ws.w;
+    Vector<valueType> & tmp   = ws.tmp;
+
+    ::lapack_wrapper::QR<valueType> & qr = ws.qr;
+
+    valueType const eps = std::numeric_limits<valueType>::epsilon();
+    bool newton = false;
+    thRe.setZero();
+    thIm2.setZero();
+
+    iter = 1;
+    do {
+
+      r = b - A * x;
+      r = r / P;
+      valueType beta = norm2(r);
+      if ( beta <= epsi ) { resid = beta; break; }
+
+      for ( indexType k = 0; k < neq; ++k ) V(k) = r(k)/beta;
+      g.setZero();
+      g(0) = beta;
+      H.setZero();
+
+      indexType c = 0;  // last column of V already orthonormal
+      bool      done = false;
+      while ( c < m && !done ) {
+
+        valueType * W = &V(c*neq+neq);
+
+        // matrix powers kernel: s vectors without inner products
+        for ( indexType j = 0; j < s; ++j ) {
+          valueType const * Kj = &V((c+j)*neq);
+          for ( indexType k = 0; k < neq; ++k ) tmp(k) = Kj[k];
+          w = A * tmp;
+          w = w / P;
+          valueType * Kj1 = W + j*neq;
+          if ( thIm2(j) != 0 ) {
+            valueType const * Kjm = Kj - neq;
+            for ( indexType k = 0; k < neq; ++k )
+              Kj1[k] = w(k) - thRe(j)*tmp(k) + thIm2(j)*Kjm[k];
+          } else {
+            for ( indexType k = 0; k < neq; ++k )
+              Kj1[k] = w(k) - thRe(j)*tmp(k);
+          }
+        }
+
+        // block Gram-Schmidt, two passes, W = V*C + W'
+        integer nc = integer(c+1);
+        C.setZero();
+        for ( integer pass = 0; pass < 2; ++pass ) {
+          gemm( TRANSPOSE, NO_TRANSPOSE, nc, integer(s), n,
+                1, &V(0), n, W, n, 0, &Cp(0), ld );
+          gemm( NO_TRANSPOSE, NO_TRANSPOSE, n, integer(s), nc,
+                -1, &V(0), n, &Cp(0), ld, 1, W, n );
+          for ( indexType j = 0; j < s; ++j )
+            for ( indexType i = 0; i <= c; ++i )
+              C(i+j*m1) += Cp(i+j*m1);
+        }
+
+        // tall skinny QR, W' = Q*R, Q stored explicitly in place of W
+        qr.factorize( "gmres_sstep", n, integer(s), W, n );
+        qr.getR( &R(0), integer(s) );
+        std::fill( W, W+neq*s, valueType(0) );
+        for ( indexType j = 0; j < s; ++j ) W[j*neq+j] = 1;
+        qr.Q_mul( n, integer(s), W, n );
+
+        // effective block length, a negligible R(j,j) means the
+        // Krylov space is (numerically) invariant
+        indexType sb = s;
+        for ( indexType j = 0; j < s && sb == s; ++j ) {
+          valueType cn = 0;
+          for ( indexType i = 0; i <= c; ++i ) cn += C(i+j*m1)*C(i+j*m1);
+          for ( indexType i = 0; i <= j; ++i ) cn += R(i+j*s)*R(i+j*s);
+          if ( absval(R(j+j*s)) <= 100*eps*std::sqrt(cn) ) sb = j+1;
+        }
+
+        // T = coordinates of [q_c,K(1),...,K(sb)] in V(:,0..c+sb)
+        T.setZero();
+        T(c) = 1;
+        for ( indexType j = 0; j < sb; ++j ) {
+          for ( indexType i = 0; i <= c; ++i ) T(i+(j+1)*m1) = C(i+j*m1);
+          for ( indexType i = 0; i <= j; ++i ) T(c+1+i+(j+1)*m1) = R(i+j*s);
+        }
+
+        // G = T*B - [ H_old * T_top ; 0 ]
+        G.setZero();
+        for ( indexType j = 0; j < sb; ++j ) {
+          for ( indexType i = 0; i <= c+sb; ++i ) {
+            valueType tmpv = T(i+(j+1)*m1) + thRe(j) * T(i+j*m1);
+            if ( j > 0 ) tmpv -= thIm2(j) * T(i+(j-1)*m1);
+            G(i+j*m1) = tmpv;
+          }
+        }
+        if ( c > 0 )
+          gemm( NO_TRANSPOSE, NO_TRANSPOSE, nc, integer(sb), integer(c),
+                -1, &H(0), ld, &T(0), ld, 1, &G(0), ld );
+
+        // H(:,c..c+sb-1) = G * T_bot^(-1)
+        trsm( ::lapack_wrapper::RIGHT, ::lapack_wrapper::UPPER,
+              NO_TRANSPOSE, ::lapack_wrapper::NON_UNIT,
+              integer(c+sb+1), integer(sb), 1, &T(c), ld, &G(0), ld );
+        for ( indexType j = 0; j < sb; ++j )
+          for ( indexType i = 0; i <= c+j+1; ++i )
+            H(i+(c+j)*m1) = G(i+j*m1);
+
+        // least squares update with plane rotations, column by column
+        for ( indexType j = 0; j < sb; ++j ) {
+          indexType i = c+j;
+          for ( indexType k = 0; k <= i+1; ++k ) Hr(k+i*m1) = H(k+i*m1);
+          for ( indexType k = 0; k < i; ++k )
+            ApplyPlaneRotation(Hr(k+i*m1), Hr(k+1+i*m1), cs(k), sn(k));
+          GeneratePlaneRotation(Hr(i+i*m1), Hr(i+1+i*m1), cs(i), sn(i));
+          ApplyPlaneRotation(Hr(i+i*m1), Hr(i+1+i*m1), cs(i), sn(i));
+          ApplyPlaneRotation(g(i), g(i+1), cs(i), sn(i));
+
+          ++iter;
+          resid = absval(g(i+1));
+          if ( pStream != nullptr ) (*pStream) << "iter = " << iter << " residual = " << resid << '\n';
+          if ( resid <= epsi || iter > maxIter ) { sb = j+1; done = true; }
+        }
+        c += sb;
+        if ( sb < s ) done = true;
+      }
+
+      // Backsolve and update
+      trsv( ::lapack_wrapper::UPPER, NO_TRANSPOSE, ::lapack_wrapper::NON_UNIT,
+            integer(c), &Hr(0), ld, &g(0), 1 );
+      for ( indexType k = 0; k < neq; ++k ) tmp(k) = x(k);
+      gemv( NO_TRANSPOSE, n, integer(c), 1, &V(0), n, &g(0), 1, 1, &tmp(0), 1 );
+      for ( indexType k = 0; k < neq; ++k ) x(k) = tmp(k);
+
+      // Newton shifts from the Ritz values of the first full cycle
+      if ( !newton && c >= s && s > 1 ) {
+        ::lapack_wrapper::Eigenvalues<valueType> eig( integer(c), &H(0), ld );
+        vector<valueType> re, im;
+        eig.getEigenvalues( re, im );
+        gmres_sstep_leja( re, im, s, thRe, thIm2 );
+        newton = true;
+      }
+
+    } while ( iter <= maxIter );
+
+    return resid;
+  }
+
+  /*!
+   *  Same as the overload with the workspace, the Krylov basis and the
+   *  temporaries are allocated at each call.
+   */
+  template <typename valueType,
+            typename indexType,
+            typename matrix_type,
+            typename vector_type,
+            typename preco_type>
+  valueType
+  gmres_sstep(
+    matrix_type const & A,
+    vector_type const & b,
+    vector_type       & x,
+    preco_type  const & P,
+    valueType           epsi,
+    indexType           s,
+    indexType           m, // maxSubIter
+    indexType           maxIter,
+    indexType         & iter,
+    ostream           * pStream = nullptr
+  ) {
+    GmresSstepWorkspace<typename vector_type::valueType> ws;
+    return gmres_sstep( A, b, x, P, epsi, s, m, maxIter, iter, ws, pStream );
+  }
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::gmres_sstep;
+  using ::SparseTool::GmresSstepWorkspace;
+}
+
+#endif
+
+/*
+// ####### ####### #######
+// #       #     # #
+// #       #     # #
+// #####   #     # #####
+// #       #     # #
+// #       #     # #
+// ####### ####### #
+*/
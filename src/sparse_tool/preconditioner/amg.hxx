@@ -0,0 +1,647 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_AMG_HH
+#define SPARSETOOL_ITERATIVE_PRECO_AMG_HH
+
+#include <cmath>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //     #    #     #  #####
+  //    # #   ##   ## #     #
+  //   #   #  # # # # #
+  //  #     # #  #  # #  ####
+  //  ####### #     # #     #
+  //  #     # #     # #     #
+  //  #     # #     #  #####
+  */
+
+  //! smoother of the levels of \c AMGpreconditioner
+  typedef enum { AMG_JACOBI = 0, AMG_CHEBYSHEV = 1 } AMGsmoother;
+
+  //! \cond NODOC
+
+  // compressed rows of one operator of the hierarchy
+  template <typename T>
+  struct AMGcsr {
+    indexType         nr, nc;
+    Vector<indexType> R, J;
+    Vector<T>         A;
+
+    AMGcsr() : nr(0), nc(0) {}
+
+    indexType nnz() const { return R.empty() ? 0 : R(nr); }
+  };
+
+  // C = A * B, rows of C computed concurrently by nt threads
+  template <typename T>
+  inline
+  void
+  amg_spgemm( AMGcsr<T> const & A, AMGcsr<T> const & B, AMGcsr<T> & C, indexType nt ) {
+    indexType const none = indexType(-1);
+    C.nr = A.nr;
+    C.nc = B.nc;
+    C.R.resize(C.nr+1);
+    vector<Vector<indexType> > J(nt);
+    vector<Vector<T> >         V(nt);
+    parallel_run( nt, [&]( indexType tid, SweepBarrier & barrier ) {
+      bool sense = false;
+      indexType lo = (A.nr*tid)/nt;
+      indexType hi = (A.nr*(tid+1))/nt;
+      Vector<indexType> & Jt = J[tid];
+      Vector<T>         & Vt = V[tid];
+      Vector<indexType> pos(B.nc);
+      pos = none;
+      for ( indexType i = lo; i < hi; ++i ) {
+        indexType start = Jt.size();
+        for ( indexType ii = A.R(i); ii < A.R(i+1); ++ii ) {
+          indexType k  = A.J(ii);
+          T         ak = A.A(ii);
+          for ( indexType kk = B.R(k); kk < B.R(k+1); ++kk ) {
+            indexType j = B.J(kk);
+            if ( pos(j) == none || pos(j) < start ) {
+              pos(j) = Jt.size();
+              Jt.push_back(j);
+              Vt.push_back(ak*B.A(kk));
+            } else {
+              Vt(pos(j)) += ak*B.A(kk);
+            }
+          }
+        }
+        C.R(i+1) = Jt.size() - start;
+      }
+      barrier.wait(sense);
+      if ( tid == 0 ) {
+        C.R(0) = 0;
+        for ( indexType i = 0; i < C.nr; ++i ) C.R(i+1) += C.R(i);
+        C.J.resize(C.R(C.nr));
+        C.A.resize(C.R(C.nr));
+      }
+      barrier.wait(sense);
+      std::copy( Jt.begin(), Jt.end(), C.J.begin() + C.R(lo) );
+      std::copy( Vt.begin(), Vt.end(), C.A.begin() + C.R(lo) );
+    } );
+  }
+
+  // B = A^T
+  template <typename T>
+  inline
+  void
+  amg_transpose( AMGcsr<T> const & A, AMGcsr<T> & B ) {
+    B.nr = A.nc;
+    B.nc = A.nr;
+    B.R.resize(B.nr+1);
+    B.J.resize(A.nnz());
+    B.A.resize(A.nnz());
+    B.R = 0;
+    for ( indexType kk = 0; kk < A.nnz(); ++kk ) ++B.R(A.J(kk)+1);
+    for ( indexType i = 0; i < B.nr; ++i ) B.R(i+1) += B.R(i);
+    Vector<indexType> fill(B.nr);
+    for ( indexType i = 0; i < B.nr; ++i ) fill(i) = B.R(i);
+    for ( indexType i = 0; i < A.nr; ++i )
+      for ( indexType kk = A.R(i); kk < A.R(i+1); ++kk ) {
+        indexType pos = fill(A.J(kk))++;
+        B.J(pos) = i;
+        B.A(pos) = A.A(kk);
+      }
+  }
+
+  // one level of the hierarchy: operator, prolongator, restriction
+  template <typename T>
+  struct AMGlevel {
+    AMGcsr<T> A, P, R;
+    Vector<T> Dinv;
+    T         rho;
+  };
+
+  // work vectors of one level for a V-cycle
+  template <typename T>
+  struct AMGwork {
+    Vector<T> x, b, r, d, w;
+  };
+
+  //! \endcond
+
+  /*!
+   *  Algebraic multigrid preconditioner, smoothed aggregation of
+   *  Vanek, Mandel and Brezina.
+   *
+   *  The hierarchy is built from the strength graph
+   *  \f$ |a_{ij}| \geq \theta \sqrt{|a_{ii}a_{jj}|} \f$, the nodes are
+   *  grouped in aggregates and the piecewise constant tentative
+   *  prolongator is smoothed by one damped Jacobi step,
+   *  \f$ P = (I-\frac{4}{3\rho}D^{-1}A)T \f$; the coarse operator is the
+   *  Galerkin product \f$ P^T A P \f$.
+   *  Coarsening stops when the size is below \c setCoarseSize, the
+   *  coarsest level is solved by \c lapack_wrapper::LU.
+   *  One application is a V-cycle with damped Jacobi or Chebyshev
+   *  smoothing, symmetric if the matrix is, so it can be used with \c cg.
+   *
+   *  With \c setNumThreads the products of the setup and all the
+   *  operations of the V-cycle are split by rows among the threads;
+   *  the aggregation is sequential.
+   *  Only real types supported by \c lapack_wrapper::LU (\c float, \c double).
+   */
+  template <typename T>
+  class AMGpreconditioner : public Preco<AMGpreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef AMGpreconditioner<T> AMGPRECO;
+    typedef Preco<AMGPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    AMGsmoother   smoother;
+    indexType     nSweeps, nThreads, coarseSize, maxLevels;
+    mutable ThreadPool pool;
+    valueType     theta;
+
+    vector<AMGlevel<valueType> > levels;
+
+    lapack_wrapper::LU<valueType> coarseLU;
+
+    PrecoScratch<vector<AMGwork<valueType> > > scratch;
+
+    // aggregates of the strength graph of A, none for isolated nodes
+    indexType
+    aggregate( AMGcsr<valueType> const & A,
+               Vector<valueType> const & Dinv,
+               valueType                 th,
+               Vector<indexType>       & agg ) const {
+      indexType const none = indexType(-1);
+      indexType n = A.nr;
+
+      // strength graph
+      Vector<indexType> S_R(n+1), S_J;
+      S_J.reserve(A.nnz());
+      S_R(0) = 0;
+      for ( indexType i = 0; i < n; ++i ) {
+        for ( indexType kk = A.R(i); kk < A.R(i+1); ++kk ) {
+          indexType j = A.J(kk);
+          if ( j == i ) continue;
+          valueType aij = A.A(kk);
+          if ( aij*aij*std::abs(Dinv(i)*Dinv(j)) >= th*th ) S_J.push_back(j);
+        }
+        S_R(i+1) = S_J.size();
+      }
+
+      agg.resize(n);
+      agg = none;
+      indexType nagg = 0;
+
+      // pass 1: a node with all the neighbours free is a root
+      for ( indexType i = 0; i < n; ++i ) {
+        if ( agg(i) != none || S_R(i) == S_R(i+1) ) continue;
+        bool free = true;
+        for ( indexType kk = S_R(i); kk < S_R(i+1) && free; ++kk )
+          free = agg(S_J(kk)) == none;
+        if ( !free ) continue;
+        agg(i) = nagg;
+        for ( indexType kk = S_R(i); kk < S_R(i+1); ++kk ) agg(S_J(kk)) = nagg;
+        ++nagg;
+      }
+
+      // pass 2: join an aggregate of pass 1 of a neighbour
+      Vector<indexType> agg1(agg);
+      for ( indexType i = 0; i < n; ++i ) {
+        if ( agg(i) != none ) continue;
+        for ( indexType kk = S_R(i); kk < S_R(i+1); ++kk ) {
+          indexType a = agg1(S_J(kk));
+          if ( a != none ) { agg(i) = a; break; }
+        }
+      }
+
+      // pass 3: the remaining nodes with the free neighbours
+      for ( indexType i = 0; i < n; ++i ) {
+        if ( agg(i) != none || S_R(i) == S_R(i+1) ) continue;
+        agg(i) = nagg;
+        for ( indexType kk = S_R(i); kk < S_R(i+1); ++kk )
+          if ( agg(S_J(kk)) == none ) agg(S_J(kk)) = nagg;
+        ++nagg;
+      }
+      return nagg;
+    }
+
+    // spectral radius of D^(-1) A by power iteration
+    valueType
+    spectral_radius( AMGlevel<valueType> const & lv ) const {
+      indexType n = lv.A.nr;
+      Vector<valueType> x(n), y(n);
+      valueType rho = 0;
+      // pseudo random start, rich in the oscillating components
+      for ( indexType i = 0; i < n; ++i )
+        x(i) = valueType(((i+1)*2654435761u) >> 16 & 0xFFFF)/valueType(0xFFFF) - valueType(0.5);
+      x = x / norm2(x);
+      // the norm is summed by one thread: same estimate for any number of threads
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        bool sense = false;
+        indexType lo = (n*tid)/nThreads;
+        indexType hi = (n*(tid+1))/nThreads;
+        for ( indexType it = 0; it < 20; ++it ) {
+          for ( indexType i = lo; i < hi; ++i ) {
+            valueType tmp = 0;
+            for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+              tmp += lv.A.A(kk) * x(lv.A.J(kk));
+            y(i) = lv.Dinv(i) * tmp;
+          }
+          barrier.wait(sense);
+          if ( tid == 0 ) rho = norm2(y);
+          barrier.wait(sense);
+          if ( rho == 0 ) break;
+          for ( indexType i = lo; i < hi; ++i ) x(i) = y(i) / rho;
+          barrier.wait(sense);
+        }
+      } );
+      return rho;
+    }
+
+    //! build the smoothed aggregation hierarchy of \c M
+    template <typename MAT>
+    void
+    build_AMG( MAT const & M ) {
+
+      SPARSETOOL_ASSERT(
+        M.isOrdered(),
+        "AMGpreconditioner::build_AMG pattern must be ordered before use"
+      )
+      SPARSETOOL_ASSERT(
+        M.numRows() == M.numCols(),
+        "AMGpreconditioner::build_AMG only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        M.numRows() > 0,
+        "AMGpreconditioner::build_AMG empty matrix"
+      )
+
+      PRECO::pr_size = M.numRows();
+      levels.clear();
+      levels.reserve(maxLevels);
+      levels.resize(1);
+
+      // step 0: copy the matrix by rows
+      AMGcsr<valueType> & A0 = levels[0].A;
+      A0.nr = A0.nc = PRECO::pr_size;
+      A0.R.resize( PRECO::pr_size + 1 );
+      A0.R = 0;
+      for ( M.Begin(); M.End(); M.Next() ) ++A0.R(M.row()+1);
+      for ( indexType i = 0; i < PRECO::pr_size; ++i ) A0.R(i+1) += A0.R(i);
+      A0.J.resize( A0.R(PRECO::pr_size) );
+      A0.A.resize( A0.R(PRECO::pr_size) );
+      {
+        Vector<indexType> fill( PRECO::pr_size );
+        for ( indexType i = 0; i < PRECO::pr_size; ++i ) fill(i) = A0.R(i);
+        for ( M.Begin(); M.End(); M.Next() ) {
+          indexType pos = fill(M.row())++;
+          A0.J(pos) = M.column();
+          A0.A(pos) = M.value();
+        }
+      }
+
+      valueType th = theta;
+      for ( indexType l = 0;; ++l ) {
+        AMGlevel<valueType> & lv = levels[l];
+        indexType n = lv.A.nr;
+
+        // step 1: diagonal and spectral radius
+        lv.Dinv.resize(n);
+        lv.Dinv = valueType(0);
+        for ( indexType i = 0; i < n; ++i )
+          for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+            if ( lv.A.J(kk) == i ) lv.Dinv(i) += lv.A.A(kk);
+        for ( indexType i = 0; i < n; ++i ) {
+          SPARSETOOL_ASSERT(
+            lv.Dinv(i) != valueType(0),
+            "AMGpreconditioner::build_AMG level " << l << " D(" << i << ") == 0"
+          )
+          lv.Dinv(i) = valueType(1)/lv.Dinv(i);
+        }
+        lv.rho = spectral_radius(lv);
+
+        if ( n <= coarseSize || l+1 >= maxLevels ) break;
+
+        // step 2: aggregation and tentative prolongator
+        Vector<indexType> agg;
+        indexType nc = aggregate( lv.A, lv.Dinv, th, agg );
+        if ( nc == 0 || 10*nc >= 9*n ) break; // coarsening stalled
+
+        Vector<indexType> asize(nc);
+        asize = 0;
+        for ( indexType i = 0; i < n; ++i ) if ( agg(i) != indexType(-1) ) ++asize(agg(i));
+        AMGcsr<valueType> Tent;
+        Tent.nr = n;
+        Tent.nc = nc;
+        Tent.R.resize(n+1);
+        Tent.R(0) = 0;
+        for ( indexType i = 0; i < n; ++i ) {
+          if ( agg(i) != indexType(-1) ) {
+            Tent.J.push_back(agg(i));
+            Tent.A.push_back(valueType(1)/std::sqrt(valueType(asize(agg(i)))));
+          }
+          Tent.R(i+1) = Tent.J.size();
+        }
+
+        // step 3: smoothed prolongator P = (I - omega D^(-1) A) T
+        valueType omega = valueType(4)/(valueType(3)*lv.rho);
+        AMGcsr<valueType> S;
+        S.nr = S.nc = n;
+        S.R  = lv.A.R;
+        S.J  = lv.A.J;
+        S.A.resize(lv.A.nnz());
+        for ( indexType i = 0; i < n; ++i )
+          for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk ) {
+            S.A(kk) = -omega*lv.Dinv(i)*lv.A.A(kk);
+            if ( lv.A.J(kk) == i ) S.A(kk) += valueType(1);
+          }
+        amg_spgemm( S, Tent, lv.P, nThreads );
+        amg_transpose( lv.P, lv.R );
+
+        // step 4: Galerkin coarse operator R A P
+        AMGcsr<valueType> AP;
+        amg_spgemm( lv.A, lv.P, AP, nThreads );
+        levels.resize(l+2);
+        amg_spgemm( levels[l].R, AP, levels[l+1].A, nThreads );
+
+        th *= valueType(0.5);
+      }
+
+      // step 5: factorize the coarsest level
+      AMGcsr<valueType> const & Ac = levels.back().A;
+      if ( Ac.nr <= coarseSize ) {
+        lapack_wrapper::integer nc = lapack_wrapper::integer(Ac.nr);
+        Vector<valueType> dense(Ac.nr*Ac.nr);
+        dense = valueType(0);
+        for ( indexType i = 0; i < Ac.nr; ++i )
+          for ( indexType kk = Ac.R(i); kk < Ac.R(i+1); ++kk )
+            dense(i+Ac.J(kk)*Ac.nr) += Ac.A(kk);
+        coarseLU.factorize( "AMGpreconditioner::build_AMG", nc, nc, &dense.front(), nc );
+      }
+
+      // step 6: work vectors of the V-cycle
+      vector<AMGwork<valueType> > & ws = scratch.setup();
+      ws.resize( levels.size() );
+      for ( indexType l = 0; l < levels.size(); ++l ) {
+        indexType n = levels[l].A.nr;
+        ws[l].x.resize(n);
+        ws[l].b.resize(n);
+        ws[l].r.resize(n);
+        ws[l].d.resize(n);
+        ws[l].w.resize(n);
+      }
+    }
+
+    // smoothing of A x = b on the rows of thread tid, zero initial guess if zero
+    void
+    smooth( AMGlevel<valueType> const & lv,
+            AMGwork<valueType>        & wk,
+            bool                        zero,
+            indexType                   tid,
+            SweepBarrier              & barrier,
+            bool                      & sense ) const {
+      indexType n  = lv.A.nr;
+      indexType lo = (n*tid)/nThreads;
+      indexType hi = (n*(tid+1))/nThreads;
+      Vector<valueType> & x = wk.x;
+      Vector<valueType> const & b = wk.b;
+      if ( smoother == AMG_JACOBI ) {
+        valueType omega = valueType(4)/(valueType(3)*lv.rho);
+        for ( indexType s = 0; s < nSweeps; ++s ) {
+          if ( zero && s == 0 ) {
+            for ( indexType i = lo; i < hi; ++i ) x(i) = omega * lv.Dinv(i) * b(i);
+          } else {
+            for ( indexType i = lo; i < hi; ++i ) {
+              valueType tmp = b(i);
+              for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+                tmp -= lv.A.A(kk) * x(lv.A.J(kk));
+              wk.r(i) = x(i) + omega * lv.Dinv(i) * tmp;
+            }
+            barrier.wait(sense);
+            for ( indexType i = lo; i < hi; ++i ) x(i) = wk.r(i);
+          }
+          barrier.wait(sense);
+        }
+      } else {
+        // Chebyshev polynomial of D^(-1) A on [rho/30,1.1*rho]
+        valueType lmax  = valueType(1.1)*lv.rho;
+        valueType lmin  = lmax/valueType(30);
+        valueType th    = (lmax+lmin)/2;
+        valueType delta = (lmax-lmin)/2;
+        valueType sigma = th/delta;
+        valueType rho   = 1/sigma;
+        Vector<valueType> * pd = &wk.d;
+        Vector<valueType> * pw = &wk.w;
+        Vector<valueType> & r  = wk.r;
+        for ( indexType i = lo; i < hi; ++i ) {
+          valueType tmp = b(i);
+          if ( !zero ) {
+            for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+              tmp -= lv.A.A(kk) * x(lv.A.J(kk));
+          } else {
+            x(i) = 0;
+          }
+          r(i) = lv.Dinv(i) * tmp;
+          (*pd)(i) = r(i) / th;
+        }
+        barrier.wait(sense);
+        for ( indexType k = 0; k < nSweeps; ++k ) {
+          Vector<valueType> & d = *pd;
+          Vector<valueType> & w = *pw;
+          for ( indexType i = lo; i < hi; ++i ) x(i) += d(i);
+          if ( k+1 == nSweeps ) break;
+          valueType rho1 = 1/(2*sigma-rho);
+          for ( indexType i = lo; i < hi; ++i ) {
+            valueType tmp = 0;
+            for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+              tmp += lv.A.A(kk) * d(lv.A.J(kk));
+            r(i) -= lv.Dinv(i) * tmp;
+            w(i)  = rho1*rho*d(i) + (2*rho1/delta)*r(i);
+          }
+          rho = rho1;
+          std::swap( pd, pw );
+          barrier.wait(sense);
+        }
+        barrier.wait(sense);
+      }
+    }
+
+    // one V-cycle, b of the first level already loaded
+    void
+    vcycle( vector<AMGwork<valueType> > & ws, indexType tid, SweepBarrier & barrier ) const {
+      bool      sense = false;
+      indexType nl    = indexType(levels.size());
+      for ( indexType l = 0; l+1 < nl; ++l ) {
+        AMGlevel<valueType> const & lv = levels[l];
+        AMGwork<valueType>        & wv = ws[l];
+        AMGwork<valueType>        & wc = ws[l+1];
+        smooth( lv, wv, true, tid, barrier, sense );
+        // residual and restriction
+        indexType lo = (lv.A.nr*tid)/nThreads;
+        indexType hi = (lv.A.nr*(tid+1))/nThreads;
+        for ( indexType i = lo; i < hi; ++i ) {
+          valueType tmp = wv.b(i);
+          for ( indexType kk = lv.A.R(i); kk < lv.A.R(i+1); ++kk )
+            tmp -= lv.A.A(kk) * wv.x(lv.A.J(kk));
+          wv.r(i) = tmp;
+        }
+        barrier.wait(sense);
+        lo = (lv.R.nr*tid)/nThreads;
+        hi = (lv.R.nr*(tid+1))/nThreads;
+        for ( indexType i = lo; i < hi; ++i ) {
+          valueType tmp = 0;
+          for ( indexType kk = lv.R.R(i); kk < lv.R.R(i+1); ++kk )
+            tmp += lv.R.A(kk) * wv.r(lv.R.J(kk));
+          wc.b(i) = tmp;
+        }
+        barrier.wait(sense);
+      }
+
+      // coarsest level
+      AMGlevel<valueType> const & lz = levels.back();
+      AMGwork<valueType>        & wz = ws.back();
+      if ( lz.A.nr <= coarseSize ) {
+        if ( tid == 0 ) {
+          wz.x = wz.b;
+          coarseLU.solve( &wz.x.front() );
+        }
+        barrier.wait(sense);
+      } else {
+        smooth( lz, wz, true,  tid, barrier, sense );
+        smooth( lz, wz, false, tid, barrier, sense );
+      }
+
+      for ( indexType l = nl-1; l > 0; --l ) {
+        AMGlevel<valueType> const & lv = levels[l-1];
+        AMGwork<valueType>        & wv = ws[l-1];
+        AMGwork<valueType>        & wc = ws[l];
+        // prolongation and post smoothing
+        indexType lo = (lv.P.nr*tid)/nThreads;
+        indexType hi = (lv.P.nr*(tid+1))/nThreads;
+        for ( indexType i = lo; i < hi; ++i ) {
+          valueType tmp = 0;
+          for ( indexType kk = lv.P.R(i); kk < lv.P.R(i+1); ++kk )
+            tmp += lv.P.A(kk) * wc.x(lv.P.J(kk));
+          wv.x(i) += tmp;
+        }
+        barrier.wait(sense);
+        smooth( lv, wv, false, tid, barrier, sense );
+      }
+    }
+
+  public:
+
+    AMGpreconditioner(void)
+    : Preco<AMGPRECO>()
+    , smoother(AMG_JACOBI)
+    , nSweeps(2)
+    , nThreads(1)
+    , coarseSize(500)
+    , maxLevels(20)
+    , theta(0.08)
+    {}
+
+    template <typename MAT>
+    AMGpreconditioner( MAT const & M )
+    : Preco<AMGPRECO>()
+    , smoother(AMG_JACOBI)
+    , nSweeps(2)
+    , nThreads(1)
+    , coarseSize(500)
+    , maxLevels(20)
+    , theta(0.08)
+    { build_AMG( M ); }
+
+    //! build the preconditioner from matrix \c M
+    template <typename MAT>
+    void
+    build( MAT const & M )
+    { build_AMG( M ); }
+
+    /*!
+     *  Smoother of the V-cycle: \c AMG_JACOBI with \c n damped Jacobi
+     *  sweeps or \c AMG_CHEBYSHEV with a polynomial of degree \c n,
+     *  pre and post smoothing.  Default 2 Jacobi sweeps.
+     */
+    void
+    setSmoother( AMGsmoother s, indexType n ) {
+      SPARSETOOL_ASSERT( n > 0, "AMGpreconditioner::setSmoother bad number of sweeps " << n )
+      smoother = s;
+      nSweeps  = n;
+    }
+
+    //! number of threads used by \c build and \c assPreco, default 1
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "AMGpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      pool.resize(nt);
+    }
+
+    //! strength threshold of the first level, halved at each level, default 0.08
+    void setStrength( valueType th ) { theta = th; }
+
+    //! levels with at most \c n unknowns are solved by \c LU, default 500
+    void setCoarseSize( indexType n ) { coarseSize = n; }
+
+    //! maximum number of levels, default 20
+    void
+    setMaxLevels( indexType n ) {
+      SPARSETOOL_ASSERT( n > 0, "AMGpreconditioner::setMaxLevels bad number of levels " << n )
+      maxLevels = n;
+    }
+
+    //! number of levels of the hierarchy
+    indexType numLevels() const { return indexType(levels.size()); }
+
+    //! number of unknowns of level \c l
+    indexType levelSize( indexType l ) const { return levels[l].A.nr; }
+
+    //! sum of the nonzeros of all the levels over the nonzeros of the matrix
+    valueType
+    operatorComplexity() const {
+      valueType nnz = 0;
+      for ( indexType l = 0; l < levels.size(); ++l ) nnz += levels[l].A.nnz();
+      return nnz / levels[0].A.nnz();
+    }
+
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typename PrecoScratch<vector<AMGwork<valueType> > >::Lease ws( scratch );
+      AMGwork<valueType> & w0 = (*ws)[0];
+      for ( indexType i = 0; i < PRECO::pr_size; ++i ) w0.b(i) = v(i);
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        vcycle( *ws, tid, barrier );
+      } );
+      for ( indexType i = 0; i < PRECO::pr_size; ++i ) res(i) = w0.x(i);
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,AMGpreconditioner<TP> >
+  operator / (Vector<T> const & v, AMGpreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,AMGpreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::AMGsmoother;
+  using ::SparseTool::AMG_JACOBI;
+  using ::SparseTool::AMG_CHEBYSHEV;
+  using ::SparseTool::AMGpreconditioner;
+}
+
+#endif
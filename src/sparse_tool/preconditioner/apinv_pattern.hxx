@@ -0,0 +1,53 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_APINV_PATTERN_HH
+#define SPARSETOOL_ITERATIVE_PRECO_APINV_PATTERN_HH
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace SparseTool {
+
+  //! \cond NODOC
+
+  /*
+  // Sorted pattern of row i of |A|^p (compressed rows R, J), indices <= imax.
+  // Shared by the sparse approximate inverses (SPAI and FSAI).
+  // mark must be sized as the rows and must not hold i on entry.
+  */
+  inline
+  void
+  apinv_pattern( Vector<indexType> const & R,
+                 Vector<indexType> const & J,
+                 indexType                 i,
+                 indexType                 p,
+                 indexType                 imax,
+                 Vector<indexType>       & mark,
+                 vector<indexType>       & list ) {
+    list.clear();
+    list.push_back(i);
+    mark(i) = i;
+    indexType lo = 0;
+    for ( indexType l = 0; l < p; ++l ) {
+      indexType hi = list.size();
+      for ( indexType kk = lo; kk < hi; ++kk ) {
+        indexType r = list[kk];
+        for ( indexType jj = R(r); jj < R(r+1); ++jj ) {
+          indexType j = J(jj);
+          if ( mark(j) != i ) { mark(j) = i; list.push_back(j); }
+        }
+      }
+      lo = hi;
+    }
+    indexType nk = 0;
+    for ( indexType kk = 0; kk < list.size(); ++kk )
+      if ( list[kk] <= imax ) list[nk++] = list[kk];
+    list.resize(nk);
+    std::sort( list.begin(), list.end() );
+  }
+
+  //! \endcond
+
+}
+
+#endif
@@ -55,7 +55,29 @@ namespace SparseTool {
 
     Vector<indexType> Lnnz, Unnz, Bnnz;
 
-    mutable Vector<valueType> br, bi, x, y;
+    bool                       multicolor;
+    indexType                  nThreads;
+    MulticolorSweep<valueType> colors;
+
+    //! copy the off diagonal part in the multicolor sweeps when \c multicolor is set
+    void
+    build_colors() {
+      if ( !multicolor ) { colors.clear(); return; }
+      colors.init( PRECO::pr_size, nThreads );
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        colors.count( k, L_R(k+1) - L_R(k) );
+        for ( indexType kk = U_C(k); kk < U_C(k+1); ++kk ) colors.count( U_I(kk) );
+      }
+      colors.allocate();
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk ) colors.push( k, L_J(kk), L_A(kk) );
+        for ( indexType kk = U_C(k); kk < U_C(k+1); ++kk ) colors.push( U_I(kk), k, U_A(kk) );
+      }
+      colors.analyze();
+    }
+
+    // work vectors br, bi, x, y, t
+    PrecoScratch<Vector<Vector<valueType> > > scratch;
 
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT>
@@ -190,18 +212,19 @@ namespace SparseTool {
                             "CSSORpreconditioner::D(" << i << ") = " << D(i) << " size = " << D.size() );
 
       // step 6: allocate working vectors
-      br . resize( PRECO::pr_size );
-      bi . resize( PRECO::pr_size );
-      x  . resize( PRECO::pr_size );
-      y  . resize( PRECO::pr_size );
+      Vector<Vector<valueType> > & ws = scratch.setup();
+      ws.resize(5);
+      for ( indexType k = 0; k < 5; ++k ) ws(k).resize( PRECO::pr_size );
+
+      build_colors();
     }
 
   public:
 
-    CSSORpreconditioner(void) : Preco<CSSORPRECO>() {}
+    CSSORpreconditioner(void) : Preco<CSSORPRECO>(), multicolor(false), nThreads(1) {}
     
     template <typename MAT>
-    CSSORpreconditioner( MAT const & M, valueType _omega, indexType _maxIter ) : Preco<CSSORPRECO>()
+    CSSORpreconditioner( MAT const & M, valueType _omega, indexType _maxIter ) : Preco<CSSORPRECO>(), multicolor(false), nThreads(1)
     { build_SOR( M, _omega, _maxIter ); }
 
     //! build the preconditioner from matrix \c M with pattern \c P
@@ -210,10 +233,42 @@ namespace SparseTool {
     build( MAT const & M, valueType _omega, indexType _maxIter )
     { build_SOR( M, _omega, _maxIter ); }
 
+    /*!
+     *  Select the multicolor sweeps on \c nt threads (\c yes = true)
+     *  or the natural order sweeps (\c yes = false, the default).
+     *  The coloring is computed here if already built or at each \c build.
+     */
+    void
+    setMulticolor( bool yes, indexType nt = 1 ) {
+      SPARSETOOL_ASSERT( nt > 0, "CSSORpreconditioner::setMulticolor bad number of threads " << nt )
+      multicolor = yes;
+      nThreads   = nt;
+      if ( PRECO::pr_size > 0 ) build_colors();
+    }
+
+    //! \c true if the multicolor sweeps are used
+    bool isMulticolor() const { return multicolor; }
+
+    //! number of colors of the multicolor sweeps (0 if not used)
+    indexType numColors() const { return colors.numColors(); }
+
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
     assPreco( VECTOR & xc, VECTOR const & bc ) const {
+      typename PrecoScratch<Vector<Vector<valueType> > >::Lease ws( scratch );
+      Vector<valueType> & br = (*ws)(0);
+      Vector<valueType> & bi = (*ws)(1);
+      Vector<valueType> & x  = (*ws)(2);
+      Vector<valueType> & y  = (*ws)(3);
+      Vector<valueType> & t  = (*ws)(4);
+
       indexType const * pC;  indexType const * pI;  valueType const * pUA;
       indexType const * pBR; indexType const * pBJ; valueType const * pBA;
       indexType const * pR;  indexType const * pJ;  valueType const * pLA;
@@ -228,6 +283,49 @@ namespace SparseTool {
 
       x.setZero();
       y.setZero();
+
+      if ( multicolor ) {
+        colors.run( [&]( indexType tid, SweepBarrier & barrier ) {
+          bool sense = false;
+          indexType lo = 0, hi = PRECO::pr_size;
+          colors.split( lo, hi, tid );
+          for ( indexType ii = 0; ii < maxIter; ++ii ) {
+            for ( indexType i = lo; i < hi; ++i ) {
+              valueType tmp = br(i);
+              for ( indexType kk = B_R(i); kk < B_R(i+1); ++kk ) tmp += B_A(kk) * y(B_J(kk));
+              t(i) = tmp;
+            }
+            barrier.wait(sense);
+            colors.sweep( x, t, D, omega, true, tid, barrier, sense );
+            for ( indexType i = lo; i < hi; ++i ) {
+              valueType tmp = bi(i);
+              for ( indexType kk = B_R(i); kk < B_R(i+1); ++kk ) tmp -= B_A(kk) * x(B_J(kk));
+              t(i) = tmp;
+            }
+            barrier.wait(sense);
+            colors.sweep( y, t, D, omega, true, tid, barrier, sense );
+          }
+          for ( indexType ii = 0; ii < maxIter; ++ii ) {
+            for ( indexType i = lo; i < hi; ++i ) {
+              valueType tmp = bi(i);
+              for ( indexType kk = B_R(i); kk < B_R(i+1); ++kk ) tmp -= B_A(kk) * x(B_J(kk));
+              t(i) = tmp;
+            }
+            barrier.wait(sense);
+            colors.sweep( y, t, D, omega, false, tid, barrier, sense );
+            for ( indexType i = lo; i < hi; ++i ) {
+              valueType tmp = br(i);
+              for ( indexType kk = B_R(i); kk < B_R(i+1); ++kk ) tmp += B_A(kk) * y(B_J(kk));
+              t(i) = tmp;
+            }
+            barrier.wait(sense);
+            colors.sweep( x, t, D, omega, false, tid, barrier, sense );
+          }
+        } );
+        for ( k=0; k < PRECO::pr_size; ++k ) xc(k) = T(x(k),y(k));
+        return;
+      }
+
       for ( indexType ii = 0; ii < maxIter; ++ii ) {
 
         // calcolo ((1/omega-1)*D-U)*x + B*y + b --------------------
@@ -384,7 +482,7 @@ namespace SparseTool {
       }
 
       // copia risulatato in uscita
-      for ( k=0; k < PRECO::pr_size; ++k ) xc(k) = valueType(x(k),y(k));
+      for ( k=0; k < PRECO::pr_size; ++k ) xc(k) = T(x(k),y(k));
     }
 
   };
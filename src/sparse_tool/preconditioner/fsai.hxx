@@ -0,0 +1,252 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_FSAI_HH
+#define SPARSETOOL_ITERATIVE_PRECO_FSAI_HH
+
+#include <atomic>
+#include <cmath>
+
+#include "apinv_pattern.hxx"
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  #######  #####     #    ###
+  //  #       #     #   # #    #
+  //  #       #        #   #   #
+  //  #####    #####  #     #  #
+  //  #             # #######  #
+  //  #       #     # #     #  #
+  //  #        #####  #     # ###
+  */
+  /*!
+   *  Factorized sparse approximate inverse preconditioner
+   *  \f$ G^T G \approx A^{-1} \f$ for symmetric positive definite matrices
+   *  (Kolotilina-Yeremin), \f$ G \f$ lower triangular on the lower pattern
+   *  of \f$ |A|^p \f$.
+   *
+   *  Row \c i of \f$ G \f$ with pattern \f$ P \f$ solves the small system
+   *  \f$ A(P,P) g = e_i \f$ with \c lapack_wrapper::QR and is scaled by
+   *  \f$ 1/\sqrt{g_i} \f$, so that \f$ G A G^T \f$ has unit diagonal.
+   *  The rows are independent and are computed concurrently; the
+   *  application is two sparse matrix-vector products with \f$ G \f$ and
+   *  \f$ G^T \f$ (both stored by rows), split by rows among the threads.
+   */
+  template <typename T>
+  class FSAIpreconditioner : public Preco<FSAIpreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef FSAIpreconditioner<T> FSAIPRECO;
+    typedef Preco<FSAIPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    Vector<indexType> G_R;
+    Vector<indexType> G_J;
+    Vector<valueType> G_A;
+
+    Vector<indexType> Gt_R;
+    Vector<indexType> Gt_J;
+    Vector<valueType> Gt_A;
+
+    indexType nThreads;
+    mutable ThreadPool pool;
+
+    PrecoScratch<Vector<valueType> > scratch;
+
+    //! build the \c FSAI of \c A on the lower pattern of \f$ |A|^p \f$
+    template <typename MAT>
+    void
+    build_FSAI( MAT const & A, indexType p ) {
+
+      SPARSETOOL_ASSERT(
+        A.isOrdered(),
+        "FSAIpreconditioner::build_FSAI pattern must be ordered before use"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == A.numCols(),
+        "FSAIpreconditioner::build_FSAI only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() > 0,
+        "FSAIpreconditioner::build_FSAI empty matrix"
+      )
+      SPARSETOOL_ASSERT(
+        p > 0,
+        "FSAIpreconditioner::build_FSAI pattern power must be positive"
+      )
+
+      PRECO::pr_size = A.numRows();
+      indexType n = PRECO::pr_size;
+      indexType const none = indexType(-1);
+
+      // step 0: copy the matrix by rows (ordered: increasing columns in each row)
+      Vector<indexType> A_R(n+1), A_J;
+      Vector<valueType> A_A;
+      A_R = 0;
+      for ( A.Begin(); A.End(); A.Next() ) ++A_R(A.row()+1);
+      for ( indexType i = 0; i < n; ++i ) A_R(i+1) += A_R(i);
+      A_J.resize(A_R(n));
+      A_A.resize(A_R(n));
+      {
+        Vector<indexType> fill(n);
+        for ( indexType i = 0; i < n; ++i ) fill(i) = A_R(i);
+        for ( A.Begin(); A.End(); A.Next() ) {
+          indexType pos = fill(A.row())++;
+          A_J(pos) = A.column();
+          A_A(pos) = A.value();
+        }
+      }
+
+      // step 1: pattern of G, row i ends with the diagonal
+      {
+        Vector<indexType> mark(n);
+        vector<indexType> list;
+        mark = none;
+        G_R.resize(n+1);
+        G_R(0) = 0;
+        G_J.clear();
+        G_J.reserve( A_R(n) );
+        for ( indexType i = 0; i < n; ++i ) {
+          apinv_pattern( A_R, A_J, i, p, i, mark, list );
+          for ( indexType kk = 0; kk < list.size(); ++kk ) G_J.push_back(list[kk]);
+          G_R(i+1) = G_J.size();
+        }
+      }
+      G_A.resize(G_R(n));
+
+      // step 2: local systems for the rows, concurrently
+      atomic<indexType> next(0);
+      pool.run( [&]( indexType, SweepBarrier & ) {
+        lapack_wrapper::QR<valueType> qr;
+        vector<valueType> Ad, x;
+        for ( indexType i = next++; i < n; i = next++ ) {
+          indexType const * P = &G_J.front() + G_R(i);
+          indexType         m = G_R(i+1) - G_R(i);
+          Ad.assign( size_t(m)*m, valueType(0) );
+          for ( indexType a = 0; a < m; ++a )
+            for ( indexType kk = A_R(P[a]); kk < A_R(P[a]+1); ++kk ) {
+              indexType const * q = std::lower_bound( P, P+m, A_J(kk) );
+              if ( q != P+m && *q == A_J(kk) ) Ad[a+size_t(q-P)*m] += A_A(kk);
+            }
+          valueType aii = Ad[size_t(m)*m-1];
+          x.assign( m, valueType(0) );
+          x[m-1] = valueType(1);
+          qr.factorize( "FSAIpreconditioner::build_FSAI", m, m, &Ad.front(), m );
+          qr.Qt_mul( &x.front() );
+          qr.invR_mul( &x.front() );
+          valueType d = x[m-1];
+          if ( d > 0 ) {
+            d = std::sqrt(d);
+            for ( indexType a = 0; a < m; ++a ) G_A(G_R(i)+a) = x[a] / d;
+          } else {
+            // not positive definite block: Jacobi row
+            for ( indexType a = 0; a+1 < m; ++a ) G_A(G_R(i)+a) = valueType(0);
+            G_A(G_R(i+1)-1) = valueType(1)/std::sqrt(aii > 0 ? aii : -aii);
+          }
+        }
+      } );
+
+      // step 3: G^T by rows
+      Gt_R.resize(n+1);
+      Gt_R = 0;
+      for ( indexType kk = 0; kk < G_R(n); ++kk ) ++Gt_R(G_J(kk)+1);
+      for ( indexType i = 0; i < n; ++i ) Gt_R(i+1) += Gt_R(i);
+      Gt_J.resize(G_R(n));
+      Gt_A.resize(G_R(n));
+      {
+        Vector<indexType> fill(n);
+        for ( indexType i = 0; i < n; ++i ) fill(i) = Gt_R(i);
+        for ( indexType i = 0; i < n; ++i )
+          for ( indexType kk = G_R(i); kk < G_R(i+1); ++kk ) {
+            indexType pos = fill(G_J(kk))++;
+            Gt_J(pos) = i;
+            Gt_A(pos) = G_A(kk);
+          }
+      }
+      scratch.setup().resize(n);
+    }
+
+  public:
+
+    FSAIpreconditioner(void) : Preco<FSAIPRECO>(), nThreads(1) {}
+
+    template <typename MAT>
+    FSAIpreconditioner( MAT const & M, indexType p = 1 ) : Preco<FSAIPRECO>(), nThreads(1)
+    { build_FSAI( M, p ); }
+
+    //! build the preconditioner from matrix \c M on the lower pattern of \f$ |M|^p \f$
+    template <typename MAT>
+    void
+    build( MAT const & M, indexType p = 1 )
+    { build_FSAI( M, p ); }
+
+    //! build and apply with \c nt threads (set before \c build to build in parallel)
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "FSAIpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      pool.resize(nt);
+    }
+
+    //! number of threads used by \c build and \c assPreco
+    indexType numThreads() const { return nThreads; }
+
+    //! number of stored entries of \f$ G \f$
+    indexType nnz() const { return G_R(PRECO::pr_size); }
+
+    //! concurrent \c assPreco on this object, each with its own work vector
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typedef typename VECTOR::valueType vType;
+      typename PrecoScratch<Vector<valueType> >::Lease ws( scratch );
+      Vector<valueType> & tmp = *ws;
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        indexType lo = (PRECO::pr_size*tid)/nThreads;
+        indexType hi = (PRECO::pr_size*(tid+1))/nThreads;
+        // tmp = G v
+        for ( indexType i = lo; i < hi; ++i ) {
+          vType s(0);
+          for ( indexType kk = G_R(i); kk < G_R(i+1); ++kk )
+            s += G_A(kk) * v(G_J(kk));
+          tmp(i) = s;
+        }
+        bool local_sense = false;
+        barrier.wait(local_sense);
+        // res = G^T tmp
+        for ( indexType i = lo; i < hi; ++i ) {
+          vType s(0);
+          for ( indexType kk = Gt_R(i); kk < Gt_R(i+1); ++kk )
+            s += Gt_A(kk) * tmp(Gt_J(kk));
+          res(i) = s;
+        }
+      } );
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,FSAIpreconditioner<TP> >
+  operator / (Vector<T> const & v, FSAIpreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,FSAIpreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::FSAIpreconditioner;
+}
+
+#endif
@@ -29,13 +29,15 @@ namespace SparseTool {
 
     // variabili per CG
     CCoorMatrix<rvalueType>    Amat;
-    mutable Vector<rvalueType> p, q, r, Ap, tmp1, tmp2;
     rvalueType                 epsi;
 
   private:
 
     indexType neq, maxIter;
     SSORpreconditioner<rvalueType> preco;
+
+    // work vectors p, q, r, Ap of the inner CG and tmp1, tmp2
+    PrecoScratch<Vector<Vector<rvalueType> > > scratch;
     //ILDUpreconditioner<rvalueType> preco;
 
     //! build incomplete LDU decomposition with specified pattern \c P
@@ -66,12 +68,9 @@ namespace SparseTool {
       epsi    = rtol;
       neq     = A.numRows();
       Amat . resize(neq,neq,A.nnz());
-      p    . resize(neq);
-      q    . resize(neq);
-      r    . resize(neq);
-      tmp1 . resize(neq);
-      tmp2 . resize(neq);
-      Ap   . resize(neq);
+      Vector<Vector<rvalueType> > & ws = scratch.setup();
+      ws.resize(6);
+      for ( indexType k = 0; k < 6; ++k ) ws(k).resize(neq);
 
       // insert values
       for ( A.Begin(); A.End(); A.Next() ) {
@@ -86,7 +85,13 @@ namespace SparseTool {
 
     //! apply preconditioner to vector \c v and store result to vector \c res
     void
-    assPrecoR( Vector<rvalueType> & x, Vector<rvalueType> const & b ) const {
+    assPrecoR( Vector<rvalueType>          & x,
+               Vector<rvalueType>    const & b,
+               Vector<Vector<rvalueType> > & ws ) const {
+      Vector<rvalueType> & p  = ws(0);
+      Vector<rvalueType> & q  = ws(1);
+      Vector<rvalueType> & r  = ws(2);
+      Vector<rvalueType> & Ap = ws(3);
       rvalueType rho, rho_1, normr0;
       x.setZero();
       r = b; // parto con x = 0
@@ -129,17 +134,26 @@ namespace SparseTool {
     build( MAT const & M, indexType mIter, rvalueType const & rtol, rvalueType const & omega, indexType m )
     { build_HSS_CGSSOR( M, mIter, rtol, omega, m ); }
 
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c y
     template <typename VECTOR>
     void
     assPreco( VECTOR & _y, VECTOR const & v ) const {
+      typename PrecoScratch<Vector<Vector<rvalueType> > >::Lease ws( scratch );
+      Vector<rvalueType> & tmp1 = (*ws)(4);
+      Vector<rvalueType> & tmp2 = (*ws)(5);
 
       for ( indexType k=0; k < neq; ++k ) tmp1(k) = v(k).real();
-      assPrecoR(tmp2,tmp1);
+      assPrecoR(tmp2,tmp1,*ws);
       for ( indexType k=0; k < neq; ++k ) _y(k) = valueType(tmp2(k), _y(k).imag());
 
       for ( indexType k=0; k < neq; ++k ) tmp1(k) = v(k).imag();
-      assPrecoR(tmp2,tmp1);
+      assPrecoR(tmp2,tmp1,*ws);
       for ( indexType k=0; k < neq; ++k ) _y(k) = valueType(_y(k).real(),tmp2(k));
 
       valueType cst = valueType(0.5,-0.5);
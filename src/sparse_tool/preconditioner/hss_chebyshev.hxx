@@ -36,7 +36,8 @@ namespace SparseTool {
     Vector<rvalueType> A_A;
     Vector<indexType>  Annz;
 
-    mutable Vector<valueType> s0, s1, y;
+    // work vectors s0, s1 of the recurrence
+    PrecoScratch<Vector<Vector<valueType> > > scratch;
 
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT>
@@ -65,9 +66,10 @@ namespace SparseTool {
                          "HSS_CHEBYSHEV_Preconditioner::build_LDU computed epsilon must be in the interval (0,1)" )
 
       neq = A.numRows();
-      s0 . resize(neq);
-      s1 . resize(neq);
-      y  . resize(neq);
+      Vector<Vector<valueType> > & ws = scratch.setup();
+      ws.resize(2);
+      ws(0).resize(neq);
+      ws(1).resize(neq);
 
       // step 0: compute necessary memory
       PRECO::pr_size = A.numRows();
@@ -119,7 +121,10 @@ namespace SparseTool {
 
     //! apply preconditioner to vector \c v and store result in vector \c y
     void
-    mulPoly( Vector<valueType> & _y, Vector<valueType> const & v ) const {
+    mulPoly( Vector<valueType>       & _y,
+             Vector<valueType> const & v,
+             Vector<valueType>       & s0,
+             Vector<valueType>       & s1 ) const {
       rvalueType e = sqrt_epsilon*sqrt_epsilon;
       rvalueType a = 2.0/(1.0-e);
       rvalueType b = -(1.0+e)/(1.0-e);
@@ -142,7 +147,7 @@ namespace SparseTool {
         cm1  = cn;
         cn   = cp1;
         cp1 *= c;
-        s0   = s1;
+        s0.swap(s1); // s0 is dropped, no copy
         s1   = _y;
         rvalueType g0 = (cn+1/cn)/(cp1+1/cp1);
         rvalueType aa = 2*a*g0;
@@ -178,11 +183,18 @@ namespace SparseTool {
     build( MAT const & M, indexType m, rvalueType delta )
     { build_HSS_CHEBYSHEV(M,m,delta); }
 
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c y
     template <typename VECTOR>
     void
     assPreco( VECTOR & _y, VECTOR const & v ) const {
-      mulPoly( _y, v );
+      typename PrecoScratch<Vector<Vector<valueType> > >::Lease ws( scratch );
+      mulPoly( _y, v, (*ws)(0), (*ws)(1) );
       _y *= valueType(0.5,-0.5);
     }
 
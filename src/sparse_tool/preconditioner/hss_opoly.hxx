@@ -35,7 +35,8 @@ namespace SparseTool {
     Vector<rvalueType> A_A;
     Vector<indexType>  Annz;
 
-    mutable Vector<valueType> s0, s1, y;
+    // work vectors s0, s1 of the recurrence
+    PrecoScratch<Vector<Vector<valueType> > > scratch;
 
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT>
@@ -57,9 +58,10 @@ namespace SparseTool {
 
       mdegree = m;
       neq     = A.numRows();
-      s0 . resize(neq);
-      s1 . resize(neq);
-      y  . resize(neq);
+      Vector<Vector<valueType> > & ws = scratch.setup();
+      ws.resize(2);
+      ws(0).resize(neq);
+      ws(1).resize(neq);
 
       // step 0: compute necessary memory
       PRECO::pr_size = A.numRows();
@@ -111,7 +113,10 @@ namespace SparseTool {
 
     //! apply preconditioner to vector \c v and store result in vector \c y
     void
-    mulPoly( Vector<valueType> & _y, Vector<valueType> const & v ) const {
+    mulPoly( Vector<valueType>       & _y,
+             Vector<valueType> const & v,
+             Vector<valueType>       & s0,
+             Vector<valueType>       & s1 ) const {
       // s0 = 1.5*v; s1 = 4*v - 10/3 * A*v
       indexType  const * pR = & A_R.front();
       indexType  const * pJ = & A_J.front();
@@ -124,7 +129,7 @@ namespace SparseTool {
         _y(k) = 4.0 * v(k) - (10./3.) * Av;
       };
       for ( indexType n = 2; n <= mdegree; ++n ) {
-        s0 = s1;
+        s0.swap(s1); // s0 is dropped, no copy
         s1 = _y;
         rvalueType delta = ((6*n+12)*n+4.0)/((2*n+1)*(n+2)*(n+2));
         rvalueType a = -4+(6*n+10.0)/((n+2)*(n+2));
@@ -157,11 +162,18 @@ namespace SparseTool {
     build( MAT const & M, indexType m )
     { build_HSS_OPOLY(M,m); }
 
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c y
     template <typename VECTOR>
     void
     assPreco( VECTOR & _y, VECTOR const & v ) const {
-      mulPoly( _y, v );
+      typename PrecoScratch<Vector<Vector<valueType> > >::Lease ws( scratch );
+      mulPoly( _y, v, (*ws)(0), (*ws)(1) );
       _y *= valueType(0.5,-0.5);
     }
 
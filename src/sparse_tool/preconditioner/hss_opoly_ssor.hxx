@@ -33,7 +33,8 @@ namespace SparseTool {
     SSORpreconditioner<rvalueType> preco;
     //IdPreconditioner<rvalueType>   preco;
     CCoorMatrix<rvalueType>        Amat;
-    mutable Vector<rvalueType>     s0, s1, As1, y, tmp1, tmp2;
+    // work vectors s0, s1, As1 of the recurrence and tmp1, tmp2
+    PrecoScratch<Vector<Vector<rvalueType> > > scratch;
 
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT>
@@ -56,13 +57,9 @@ namespace SparseTool {
       mdegree = m;
       neq     = A.numRows();
       Amat . resize(neq,neq,A.nnz());
-      s0   . resize(neq);
-      s1   . resize(neq);
-      As1  . resize(neq);
-      y    . resize(neq);
-
-      tmp1 . resize(neq);
-      tmp2 . resize(neq);
+      Vector<Vector<rvalueType> > & ws = scratch.setup();
+      ws.resize(5);
+      for ( indexType k = 0; k < 5; ++k ) ws(k).resize(neq);
 
       // insert values
       for ( A.Begin(); A.End(); A.Next() ) {
@@ -78,7 +75,11 @@ namespace SparseTool {
 
     //! apply preconditioner to vector \c v and store result in vector \c y
     void
-    mulPoly( Vector<rvalueType> & _y, Vector<rvalueType> const & v ) const {
+    mulPoly( Vector<rvalueType>       & _y,
+             Vector<rvalueType> const & v,
+             Vector<rvalueType>       & s0,
+             Vector<rvalueType>       & s1,
+             Vector<rvalueType>       & As1 ) const {
       s0  = rvalueType(1.5)*v;
       As1 = Amat*v;
       preco.assPreco(_y,As1);
@@ -91,7 +92,7 @@ namespace SparseTool {
         As1 = Amat*s1;
         preco.assPreco(_y,As1);
         _y = a*(_y-v)+b*s1+c*s0;
-        s0 = s1;
+        s0.swap(s1); // s0 is dropped, no copy
         s1 = _y;
       }
     }
@@ -115,16 +116,25 @@ namespace SparseTool {
     build( MAT const & M, indexType m, rvalueType const & omega, indexType iterssor )
     { build_HSS_OPOLY_SSOR( M, m, omega, iterssor ); }
 
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c y
     template <typename VECTOR>
     void
     assPreco( VECTOR & _y, VECTOR const & v ) const {
+      typename PrecoScratch<Vector<Vector<rvalueType> > >::Lease ws( scratch );
+      Vector<rvalueType> & tmp1 = (*ws)(3);
+      Vector<rvalueType> & tmp2 = (*ws)(4);
       for ( indexType k=0; k < neq; ++k ) tmp2(k) = v(k).real();
       preco.assPreco( tmp1, tmp2 ); tmp1 *= 0.5;
-      mulPoly( tmp2, tmp1 );
+      mulPoly( tmp2, tmp1, (*ws)(0), (*ws)(1), (*ws)(2) );
       for ( indexType k=0; k < neq; ++k ) { _y(k) = valueType(tmp2(k),_y(k).imag()); tmp2(k) = v(k).imag(); }
       preco.assPreco( tmp1, tmp2 ); tmp1 *= 0.5;
-      mulPoly( tmp2, tmp1 );
+      mulPoly( tmp2, tmp1, (*ws)(0), (*ws)(1), (*ws)(2) );
       valueType cst = valueType(0.5,-0.5);
       for ( indexType k=0; k < neq; ++k ) { _y(k) = valueType(_y(k).real(),tmp2(k)); _y(k) *= cst; }
     }
@@ -0,0 +1,386 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_IC_HH
+#define SPARSETOOL_ITERATIVE_PRECO_IC_HH
+
+#include <functional>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  ###  #####
+  //   #  #     #
+  //   #  #
+  //   #  #
+  //   #  #
+  //   #  #     #
+  //  ###  #####
+  */
+  //! \cond NODOC
+
+  // a pivot that is not positive (not usable for a complex matrix) breaks IC
+  template <typename T>
+  inline bool ic_breakdown( T const & d ) { return !(d > T(0)); }
+
+  template <typename T>
+  inline bool ic_breakdown( complex<T> const & d ) { return d == complex<T>(0); }
+
+  //! \endcond
+
+  /*!
+   *  Incomplete Cholesky preconditioner \f$ A \approx L D L^T \f$ for
+   *  symmetric positive definite matrices.
+   *
+   *  Only the lower triangle of the matrix is read and only the strict
+   *  lower part of the unit factor \f$ L \f$ (by rows) and the diagonal
+   *  \f$ D \f$ are stored; the backward solve with \f$ L^T \f$ runs by
+   *  columns on the same storage.  The pattern is the lower pattern of
+   *  the matrix, \c IC(0), or its level of fill \c k closure, \c IC(k).
+   *  If a pivot is not positive the factorization is restarted on
+   *  \f$ A + \alpha\,\mathrm{diag}(A) \f$ doubling \f$ \alpha \f$ at
+   *  each failure (Manteuffel shift).
+   *  \c analyze and \c refactor split the build in the symbolic and the
+   *  numeric phase, for a sequence of matrices with the same pattern.
+   *  Besides the factor only the positions of the entries of the matrix
+   *  in the factor and one index per row are kept for \c refactor.
+   */
+  template <typename T>
+  class ICpreconditioner : public Preco<ICpreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef ICpreconditioner<T> ICPRECO;
+    typedef Preco<ICPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    Vector<indexType> L_R;
+    Vector<indexType> L_J;
+    Vector<valueType> L_A;
+
+    Vector<valueType> D;
+
+    // position of the entries of the lower triangle of the matrix, in
+    // the order of its iterator: in L_A or, for the diagonal, L_R(n)+i
+    Vector<indexType> A_pos;
+
+    // position in L_A of the columns of the row being factored
+    Vector<indexType> pos;
+
+    double            alpha;
+    indexType         nShifts;
+
+    //! pattern of \c IC(k) of the lower triangle \c A_R, \c A_J
+    void
+    symbolic( Vector<indexType> const & A_R,
+              Vector<indexType> const & A_J,
+              indexType                 k ) {
+      indexType const none = indexType(-1);
+      indexType n = PRECO::pr_size;
+
+      // rows of L already built, by columns, with their levels
+      Vector<Vector<indexType> > colRow(n), colLev(n);
+      Vector<indexType>          lev(n), mark(n);
+      vector<indexType>          row, heap;
+      mark = none;
+
+      L_R.resize(n+1);
+      L_R(0) = 0;
+      L_J.clear();
+      L_J.reserve( A_R(n) );
+
+      for ( indexType i = 0; i < n; ++i ) {
+        row.clear();
+        heap.clear();
+        for ( indexType kk = A_R(i); kk < A_R(i+1); ++kk ) {
+          indexType j = A_J(kk);
+          if ( j >= i || mark(j) == i ) continue;
+          mark(j) = i;
+          lev(j)  = 0;
+          row.push_back(j);
+          heap.push_back(j);
+        }
+        if ( k > 0 ) {
+          std::make_heap( heap.begin(), heap.end(), std::greater<indexType>() );
+          while ( !heap.empty() ) {
+            std::pop_heap( heap.begin(), heap.end(), std::greater<indexType>() );
+            indexType c = heap.back();
+            heap.pop_back();
+            Vector<indexType> const & cR = colRow(c);
+            Vector<indexType> const & cL = colLev(c);
+            for ( indexType kk = 0; kk < cR.size(); ++kk ) {
+              indexType m = cR(kk);
+              indexType l = lev(c) + cL(kk) + 1;
+              if ( l > k ) continue;
+              if ( mark(m) != i ) {
+                mark(m) = i;
+                lev(m)  = l;
+                row.push_back(m);
+                heap.push_back(m);
+                std::push_heap( heap.begin(), heap.end(), std::greater<indexType>() );
+              } else if ( l < lev(m) ) {
+                lev(m) = l;
+              }
+            }
+          }
+        }
+        std::sort( row.begin(), row.end() );
+        for ( indexType kk = 0; kk < row.size(); ++kk ) {
+          indexType j = row[kk];
+          L_J.push_back(j);
+          if ( k > 0 ) { colRow(j).push_back(i); colLev(j).push_back(lev(j)); }
+        }
+        L_R(i+1) = L_J.size();
+      }
+    }
+
+    //! copy the lower triangle of \c A in \c L_A and \c D, zero on the fill
+    template <typename MAT>
+    void
+    load_values( MAT const & A ) {
+      indexType n = PRECO::pr_size;
+      L_A = valueType(0);
+      D   = valueType(0);
+      indexType t = 0;
+      for ( A.Begin(); A.End(); A.Next() ) {
+        indexType i = A.row();
+        indexType j = A.column();
+        if ( j > i ) continue;
+        SPARSETOOL_ASSERT(
+          t < A_pos.size(),
+          "ICpreconditioner::refactor matrix do not match the analyzed pattern at row " << i
+        )
+        indexType kk = A_pos(t++);
+        if ( j == i ) {
+          SPARSETOOL_ASSERT(
+            kk == L_R(n)+i,
+            "ICpreconditioner::refactor (" << i << "," << j << ") not in the analyzed pattern"
+          )
+          D(i) = A.value();
+        } else {
+          SPARSETOOL_ASSERT(
+            kk >= L_R(i) && kk < L_R(i+1) && L_J(kk) == j,
+            "ICpreconditioner::refactor (" << i << "," << j << ") not in the analyzed pattern"
+          )
+          L_A(kk) = A.value();
+        }
+      }
+      SPARSETOOL_ASSERT(
+        t == A_pos.size(),
+        "ICpreconditioner::refactor matrix do not match the analyzed pattern"
+      )
+    }
+
+    /*!
+     *  numeric \f$ L D L^T \f$ in place on the values loaded by
+     *  \c load_values, \c false on breakdown.
+     *
+     *  Row \c i is computed by rows only: for the columns \c j of the
+     *  row in increasing order \f$ u_{ij} = a_{ij} - \sum_{k<j}
+     *  l_{jk}\, u_{ik} \f$ on the pattern (\f$ u_{ij} = l_{ij} d_j \f$),
+     *  so no column access of \c L is needed.
+     */
+    bool
+    numeric( double shift ) {
+      indexType n = PRECO::pr_size;
+      pos = indexType(-1);
+      for ( indexType i = 0; i < n; ++i ) {
+        indexType lo = L_R(i);
+        indexType hi = L_R(i+1);
+        // positions of the columns of row i, the ones of other rows are
+        // below lo or none
+        for ( indexType kk = lo; kk < hi; ++kk ) pos(L_J(kk)) = kk;
+        valueType di = D(i) * valueType(1+shift);
+        for ( indexType kk = lo; kk < hi; ++kk ) {
+          indexType j = L_J(kk);
+          valueType u = L_A(kk);
+          for ( indexType jj = L_R(j); jj < L_R(j+1); ++jj ) {
+            indexType p = pos(L_J(jj));
+            if ( p >= lo && p < kk ) u -= L_A(jj) * L_A(p);
+          }
+          L_A(kk) = u;
+          di     -= u * u / D(j);
+        }
+        if ( ic_breakdown(di) ) return false;
+        for ( indexType kk = lo; kk < hi; ++kk ) L_A(kk) /= D(L_J(kk));
+        D(i) = di;
+      }
+      return true;
+    }
+
+    //! symbolic \c IC(k) of the lower triangle of the pattern \c P
+    template <typename PAT>
+    void
+    analyze_IC( PAT const & P, indexType k ) {
+
+      SPARSETOOL_ASSERT(
+        P.isOrdered(),
+        "ICpreconditioner::analyze pattern must be ordered before use"
+      )
+      SPARSETOOL_ASSERT(
+        P.numRows() == P.numCols(),
+        "ICpreconditioner::analyze only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        P.numRows() > 0,
+        "ICpreconditioner::analyze empty matrix"
+      )
+
+      PRECO::pr_size = P.numRows();
+      indexType n = PRECO::pr_size;
+
+      // step 0: pattern of the lower triangle by rows (freed on exit)
+      Vector<indexType> A_R(n+1), A_J, fill(n);
+      A_R = 0;
+      for ( P.Begin(); P.End(); P.Next() )
+        if ( P.column() <= P.row() ) ++A_R(P.row()+1);
+      for ( indexType i = 0; i < n; ++i ) A_R(i+1) += A_R(i);
+      A_J.resize(A_R(n));
+      for ( indexType i = 0; i < n; ++i ) fill(i) = A_R(i);
+      for ( P.Begin(); P.End(); P.Next() )
+        if ( P.column() <= P.row() ) A_J(fill(P.row())++) = P.column();
+
+      // step 1: pattern of L
+      symbolic( A_R, A_J, k );
+      L_A.resize( L_R(n) );
+      D.resize(n);
+      pos.resize(n);
+
+      // step 2: where the values of the matrix go
+      A_pos.resize(A_R(n));
+      indexType t = 0;
+      for ( P.Begin(); P.End(); P.Next() ) {
+        indexType i = P.row();
+        indexType j = P.column();
+        if ( j > i ) continue;
+        if ( j == i ) {
+          A_pos(t++) = L_R(n)+i;
+        } else {
+          indexType const * J = &L_J.front();
+          A_pos(t++) = indexType( std::lower_bound( J+L_R(i), J+L_R(i+1), j ) - J );
+        }
+      }
+    }
+
+    //! numeric \c IC of \c A on the pattern built by \c analyze_IC
+    template <typename MAT>
+    void
+    refactor_IC( MAT const & A ) {
+
+      SPARSETOOL_ASSERT(
+        PRECO::pr_size > 0,
+        "ICpreconditioner::refactor pattern not analyzed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == PRECO::pr_size && A.numCols() == PRECO::pr_size,
+        "ICpreconditioner::refactor matrix do not match the analyzed pattern"
+      )
+
+      // step 3: factorize, shift the diagonal on breakdown
+      alpha   = 0;
+      nShifts = 0;
+      for (;;) {
+        load_values( A );
+        if ( numeric( alpha ) ) break;
+        ++nShifts;
+        SPARSETOOL_ASSERT(
+          nShifts <= 30,
+          "ICpreconditioner::build_IC breakdown with diagonal shift " << alpha
+        )
+        alpha = alpha == 0 ? 1e-3 : 2*alpha;
+      }
+    }
+
+    //! build \c IC(k) of the lower triangle of \c A
+    template <typename MAT>
+    void
+    build_IC( MAT const & A, indexType k ) {
+      analyze_IC( A, k );
+      refactor_IC( A );
+    }
+
+  public:
+
+    ICpreconditioner(void) : Preco<ICPRECO>(), alpha(0), nShifts(0) {}
+
+    template <typename MAT>
+    ICpreconditioner( MAT const & M, indexType k = 0 ) : Preco<ICPRECO>(), alpha(0), nShifts(0)
+    { build_IC( M, k ); }
+
+    //! build \c IC(k) of matrix \c M, \c k = 0 (default) keeps the pattern of \c M
+    template <typename MAT>
+    void
+    build( MAT const & M, indexType k = 0 )
+    { build_IC( M, k ); }
+
+    //! compute the pattern of \c IC(k) of \c P, the values are computed by \c refactor
+    template <typename PRE>
+    void
+    analyze( PRE const & P, indexType k = 0 )
+    { analyze_IC( P, k ); }
+
+    /*!
+     *  Compute the factor of matrix \c M on the pattern of the last
+     *  \c analyze or \c build: no memory is allocated and the pattern
+     *  is not recomputed, only the values.  \c M must have the analyzed
+     *  pattern.
+     */
+    template <typename MAT>
+    void
+    refactor( MAT const & M )
+    { refactor_IC( M ); }
+
+    //! relative diagonal shift \f$ \alpha \f$ used by the last build (0 if none)
+    double shift() const { return alpha; }
+
+    //! number of restarts of the last build
+    indexType numShifts() const { return nShifts; }
+
+    //! number of stored entries, diagonal included
+    indexType nnz() const { return L_R(PRECO::pr_size) + PRECO::pr_size; }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typedef typename VECTOR::valueType vType;
+      res = v;
+
+      // solve L
+      for ( indexType k = 1; k < PRECO::pr_size; ++k ) {
+        vType tmp(0);
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk )
+          tmp += L_A(kk) * res(L_J(kk));
+        res(k) -= tmp;
+      }
+
+      // solve D
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) res(k) /= D(k);
+
+      // solve L^T, the rows of L are the columns of L^T
+      for ( indexType k = PRECO::pr_size-1; k > 0; --k ) {
+        vType resk = res(k);
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk )
+          res(L_J(kk)) -= L_A(kk) * resk;
+      }
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,ICpreconditioner<TP> >
+  operator / (Vector<T> const & v, ICpreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,ICpreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::ICpreconditioner;
+}
+
+#endif
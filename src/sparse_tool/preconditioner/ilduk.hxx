@@ -14,60 +14,81 @@ namespace SparseTool {
   //   #  #       #     # #     # #   #  
   //  ### ####### ######   #####  #    #
   */
-  //! Incomplete \c LDU preconditioner
-  template <typename T>
-  class ILDUKpreconditioner : public Preco<ILDUKpreconditioner<T> > {
+  /*!
+   *  Incomplete \c LDU preconditioner.
+   *  The factors are stored as \c S and the arithmetic is done in \c T.
+   */
+  template <typename T, typename S = T>
+  class ILDUKpreconditioner : public Preco<ILDUKpreconditioner<T,S> > {
   public:
 
     //! \cond NODOC
-    typedef ILDUKpreconditioner<T> ILDUKPRECO;
+    typedef ILDUKpreconditioner<T,S> ILDUKPRECO;
     typedef Preco<ILDUKPRECO>      PRECO;
 
     //! \endcond
     typedef T valueType; //!< type of the element of the preconditioner
+    typedef S storeType; //!< type of the stored elements of the factors
 
   private:
 
     Vector<indexType>          Lnnz, Unnz;
 
     Vector<valueType>          W;
-    Vector<valueType>          D;
+    Vector<storeType>          D;
 
-    Vector<Vector<valueType> > L_A;
+    Vector<Vector<storeType> > L_A;
     Vector<Vector<indexType> > L_J;
 
-    Vector<Vector<valueType> > U_A;
+    Vector<Vector<storeType> > U_A;
     Vector<Vector<indexType> > U_I;
 
-    //! build incomplete LDU decomposition with specified pattern \c P
-    template <typename MAT>
+    indexType                   nThreads;
+    LDUlevelSchedule<valueType,storeType> schedule;
+
+    //! copy the factors in the level scheduled solver when \c nThreads > 1
     void
-    build_ILDU( MAT const & A ) {
+    build_schedule() {
+      if ( nThreads < 2 ) { schedule.clear(); return; }
+      schedule.load( PRECO::pr_size, nThreads, L_J, L_A, U_I, U_A );
+    }
+
+    //! copy the new values of the factors in the level scheduled solver
+    void
+    reload_schedule() {
+      if ( schedule.size() != PRECO::pr_size ) { build_schedule(); return; }
+      schedule.reload( L_J, L_A, U_I, U_A );
+    }
+
+    //! structure of the incomplete LDU decomposition with the pattern of \c P
+    template <typename PAT>
+    void
+    analyze_ILDU( PAT const & P ) {
 
       SPARSETOOL_ASSERT(
-        A.isOrdered(),
-        "ILDUKpreconditioner::build_LDU pattern must be ordered before use"
+        P.isOrdered(),
+        "ILDUKpreconditioner::analyze pattern must be ordered before use"
       )
       SPARSETOOL_ASSERT(
-        A.numRows() == A.numCols(),
-        "ILDUKpreconditioner::build_LDU only square matrix allowed"
+        P.numRows() == P.numCols(),
+        "ILDUKpreconditioner::analyze only square matrix allowed"
       )
       SPARSETOOL_ASSERT(
-        A.numRows() > 0,
-        "ILDUKpreconditioner::build_LDU empty matrix"
+        P.numRows() > 0,
+        "ILDUKpreconditioner::analyze empty matrix"
       )
 
       // step 0: count necessary memory
-      PRECO::pr_size = A.numRows();
+      PRECO::pr_size = P.numRows();
       Lnnz.resize( PRECO::pr_size );
       Unnz.resize( PRECO::pr_size );
 
       Lnnz = 0;
       Unnz = 0;
 
-      for ( A.Begin(); A.End(); A.Next() ) {
-        indexType i = A.row();
-        indexType j = A.column();
+      for ( P.Begin(); P.End(); P.Next() ) {
+        indexType i = P.row();
+        indexType j = P.column();
         if      ( i > j ) ++Lnnz(i);
         else if ( i < j ) ++Unnz(j);
       }
@@ -78,27 +99,75 @@ namespace SparseTool {
       U_A.resize( PRECO::pr_size );
       U_I.resize( PRECO::pr_size );
       for ( indexType i = 0; i < PRECO::pr_size; ++i ) {
-        L_A(i).reserve(Lnnz(i));
-        L_J(i).reserve(Lnnz(i));
-        U_A(i).reserve(Unnz(i));
-        U_I(i).reserve(Unnz(i));
+        L_A(i).resize(Lnnz(i));
+        L_J(i).resize(Lnnz(i));
+        U_A(i).resize(Unnz(i));
+        U_I(i).resize(Unnz(i));
       }
 
       D.resize( PRECO::pr_size );
       W.resize( PRECO::pr_size );
-
-      D = valueType(1);
       W = valueType(0);
 
-      // step 2: insert values
+      // step 2: fill structure in the order of the iterator
+      Lnnz = 0;
+      Unnz = 0;
+      for ( P.Begin(); P.End(); P.Next() ) {
+        indexType i = P.row();
+        indexType j = P.column();
+        if      ( i > j ) L_J(i)(Lnnz(i)++) = j;
+        else if ( i < j ) U_I(j)(Unnz(j)++) = i;
+      }
+
+      schedule.clear();
+    }
+
+    //! incomplete LDU decomposition of \c A on the structure built by \c analyze_ILDU
+    template <typename MAT>
+    void
+    refactor_ILDU( MAT const & A ) {
+
+      SPARSETOOL_ASSERT(
+        PRECO::pr_size > 0,
+        "ILDUKpreconditioner::refactor pattern not analyzed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == PRECO::pr_size && A.numCols() == PRECO::pr_size,
+        "ILDUKpreconditioner::refactor matrix do not match the analyzed pattern"
+      )
+
+      D    = storeType(1);
+      Lnnz = 0;
+      Unnz = 0;
+
+      // insert values, same order of the iterator of the analyzed pattern
       for ( A.Begin(); A.End(); A.Next() ) {
         indexType i = A.row();
         indexType j = A.column();
         typename MAT::valueType const val = A.value(); // (i,j);
-        if      ( i > j ) { L_A(i).push_back(val); L_J(i).push_back(j); }
-        else if ( i < j ) { U_A(j).push_back(val); U_I(j).push_back(i); }
-        else              D(i) = val;
+        if ( i > j ) {
+          indexType kk = Lnnz(i)++;
+          SPARSETOOL_ASSERT(
+            kk < L_J(i).size() && L_J(i)(kk) == j,
+            "ILDUKpreconditioner::refactor (" << i << "," << j << ") not in the analyzed pattern"
+          )
+          L_A(i)(kk) = val;
+        } else if ( i < j ) {
+          indexType kk = Unnz(j)++;
+          SPARSETOOL_ASSERT(
+            kk < U_I(j).size() && U_I(j)(kk) == i,
+            "ILDUKpreconditioner::refactor (" << i << "," << j << ") not in the analyzed pattern"
+          )
+          U_A(j)(kk) = val;
+        } else {
+          D(i) = val;
+        }
       }
+      for ( indexType i = 0; i < PRECO::pr_size; ++i )
+        SPARSETOOL_ASSERT(
+          Lnnz(i) == L_J(i).size() && Unnz(i) == U_I(i).size(),
+          "ILDUKpreconditioner::refactor matrix do not match the analyzed pattern at row/column " << i
+        )
 
       // SORTING (da eliminare)
       //for ( indexType i = 0; i < PRECO::pr_size; ++i ) {
@@ -131,9 +200,9 @@ namespace SparseTool {
       // build LDU decomposition
       for ( indexType k = 1; k < PRECO::pr_size; ++k ) {
         indexType kk;
-        Vector<valueType> & L_Ak = L_A(k);
+        Vector<storeType> & L_Ak = L_A(k);
         Vector<indexType> & L_Jk = L_J(k);
-        Vector<valueType> & U_Ak = U_A(k);
+        Vector<storeType> & U_Ak = U_A(k);
         Vector<indexType> & U_Ik = U_I(k);
 
         // W = M21^T  ---- l^T = D^(-1)U^(-T) M21^T
@@ -142,15 +211,15 @@ namespace SparseTool {
         // W = U^(-T) W ---- l^T = D^(-1)U^(-T) M21^T
         for ( kk = 0; kk < L_Ak.size(); ++kk ) {
           indexType              j = L_Jk(kk);
-          Vector<valueType> & U_Aj = U_A(j);
+          Vector<storeType> & U_Aj = U_A(j);
           Vector<indexType> & U_Ij = U_I(j);
           valueType bf = 0;
-          for ( indexType jj = 0; jj < U_Aj.size(); ++jj ) bf += W(U_Ij(jj))*U_Aj(jj);
+          for ( indexType jj = 0; jj < U_Aj.size(); ++jj ) bf += W(U_Ij(jj))*valueType(U_Aj(jj));
           W(j) -= bf;
         }
         // l^T = D^(-1) W;   W = 0 ---- l^T = D^(-1)U^(-T) M21^T
         for ( kk = 0; kk < L_Ak.size(); ++kk )
-          { indexType j = L_Jk(kk); L_Ak(kk) = W(j) / D(j); W(j) = 0; }
+          { indexType j = L_Jk(kk); L_Ak(kk) = W(j) / valueType(D(j)); W(j) = 0; }
 
         // W = M12  ----  u = D^(-1)L^(-1) M12
         for ( kk = 0; kk < U_Ak.size(); ++kk ) W(U_Ik(kk)) = U_Ak(kk);
@@ -158,64 +227,109 @@ namespace SparseTool {
         // W = L^(-1) W  ----  u = D^(-1)L^(-1) M12
         for ( kk = 0; kk < U_Ak.size(); ++kk ) {
           indexType              i = U_Ik(kk);
-          Vector<valueType> & L_Ai = L_A(i);
+          Vector<storeType> & L_Ai = L_A(i);
           Vector<indexType> & L_Ji = L_J(i);
           valueType bf = 0;
-          for ( indexType ii = 0; ii < L_Ai.size(); ++ii ) bf += W(L_Ji(ii))*L_Ai(ii);
+          for ( indexType ii = 0; ii < L_Ai.size(); ++ii ) bf += W(L_Ji(ii))*valueType(L_Ai(ii));
           W(i) -= bf;
         }
 
         valueType bf = 0;
-        for ( kk = 0; kk < L_Ak.size(); ++kk ) bf += L_Ak(kk) * W(L_Jk(kk));
+        for ( kk = 0; kk < L_Ak.size(); ++kk ) bf += valueType(L_Ak(kk)) * W(L_Jk(kk));
         D(k) -= bf;
 
         for ( kk = 0; kk < U_Ak.size(); ++kk )
-          { indexType i = U_Ik(kk); U_Ak(kk) = W(i) / D(i); W(i) = 0; }
+          { indexType i = U_Ik(kk); U_Ak(kk) = W(i) / valueType(D(i)); W(i) = 0; }
 
-        SPARSETOOL_ASSERT( D(k) != valueType(0), "ILDUKpreconditioner found D(" << k << ") == 0!" );
+        SPARSETOOL_ASSERT( D(k) != storeType(0), "ILDUKpreconditioner found D(" << k << ") == 0!" );
       }
+
+      reload_schedule();
+    }
+
+    //! build incomplete LDU decomposition with the pattern of \c A
+    template <typename MAT>
+    void
+    build_ILDU( MAT const & A ) {
+      analyze_ILDU(A);
+      refactor_ILDU(A);
     }
 
   public:
 
-    ILDUKpreconditioner(void) : Preco<ILDUKPRECO>() {}
+    ILDUKpreconditioner(void) : Preco<ILDUKPRECO>(), nThreads(1) {}
     
     template <typename MAT>
-    ILDUKpreconditioner( MAT const & M ) : Preco<ILDUKPRECO>() 
+    ILDUKpreconditioner( MAT const & M ) : Preco<ILDUKPRECO>(), nThreads(1)
     { build_ILDU( M ); }
 
+    /*!
+     *  Solve the triangular factors with \c nt threads, 1 (default) is
+     *  the sequential solve.  With more threads the level scheduling
+     *  analysis is done here if already built or at each \c build.
+     */
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "ILDUKpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      if ( PRECO::pr_size > 0 ) build_schedule();
+    }
+
+    //! number of threads used by \c assPreco
+    indexType numThreads() const { return nThreads; }
+
     //! build the preconditioner from matrix \c M
     template <typename MAT>
     void
     build( MAT const & M )
     { build_ILDU(M); }
 
+    //! compute the structure of the factors from the pattern of \c P, the values are computed by \c refactor
+    template <typename PRE>
+    void
+    analyze( PRE const & P )
+    { analyze_ILDU(P); }
+
+    /*!
+     *  Compute the factors of matrix \c M on the structure of the last
+     *  \c analyze or \c build: no memory is allocated and the pattern
+     *  is not recomputed, only the values.  \c M must have the analyzed
+     *  pattern.
+     */
+    template <typename MAT>
+    void
+    refactor( MAT const & M )
+    { refactor_ILDU(M); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
     assPreco( VECTOR & res, VECTOR const & v ) const {
       res = v;
+
+      if ( nThreads > 1 ) { schedule.apply( res, D ); return; }
+
       indexType k = 0;
       // solve L
       while ( ++k < PRECO::pr_size ) {
         indexType i_cnt = L_A(k).size();
-        valueType const * pA = &L_A(k).front();
+        storeType const * pA = &L_A(k).front();
         indexType const * pJ = &L_J(k).front();
         valueType bf = 0;
-        while ( i_cnt-- > 0 ) bf += *pA++ * res(*pJ++);
+        while ( i_cnt-- > 0 ) bf += valueType(*pA++) * res(*pJ++);
         res(k) -= bf;
       }
 
       // solve D
-      for ( k = 0; k < PRECO::pr_size; ++k ) res(k) /= D(k);
+      for ( k = 0; k < PRECO::pr_size; ++k ) res(k) /= valueType(D(k));
 
       // solve U
       do {
         typename VECTOR::valueType resk = res(--k);
         indexType i_cnt = U_A(k).size();
-        valueType const * pA = &U_A(k).front();
+        storeType const * pA = &U_A(k).front();
         indexType const * pI = &U_I(k).front();
-        while ( i_cnt-- > 0 ) res(*pI++) -= *pA++ * resk;
+        while ( i_cnt-- > 0 ) res(*pI++) -= valueType(*pA++) * resk;
       } while ( k > 1 );
 
     }
@@ -223,10 +337,10 @@ namespace SparseTool {
   };
 
   //! \cond NODOC
-  template <typename T, typename TP> inline
-  Vector_V_div_P<Vector<T>,ILDUKpreconditioner<TP> >
-  operator / (Vector<T> const & v, ILDUKpreconditioner<TP> const & P)
-  { return Vector_V_div_P<Vector<T>,ILDUKpreconditioner<TP> >(v,P); }
+  template <typename T, typename TP, typename SP> inline
+  Vector_V_div_P<Vector<T>,ILDUKpreconditioner<TP,SP> >
+  operator / (Vector<T> const & v, ILDUKpreconditioner<TP,SP> const & P)
+  { return Vector_V_div_P<Vector<T>,ILDUKpreconditioner<TP,SP> >(v,P); }
   //! \endcond
 
 }
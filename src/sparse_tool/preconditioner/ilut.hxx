@@ -0,0 +1,300 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_ILUT_HH
+#define SPARSETOOL_ITERATIVE_PRECO_ILUT_HH
+
+#include <cmath>
+#include <functional>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  ### #       #     # #######
+  //   #  #       #     #    #
+  //   #  #       #     #    #
+  //   #  #       #     #    #
+  //   #  #       #     #    #
+  //   #  #       #     #    #
+  //  ### #######  #####     #
+  */
+  /*!
+   *  Incomplete \c LU preconditioner with threshold, \c ILUT(tau,p) of Saad.
+   *
+   *  Row \c i is eliminated in a dense work vector with the list of its
+   *  nonzeros, the pivots are extracted in increasing column order from a
+   *  heap.  An entry is dropped if smaller than \c tau times the norm of
+   *  row \c i of \c A; of the survivors only the \c p largest of the
+   *  \c L part and the \c p largest of the \c U part are kept (partial
+   *  sort), so the memory is bounded by magnitude and not by pattern.
+   *  The factors are stored as \f$ L D U \f$ with unit \f$ L \f$ and
+   *  \f$ U \f$, both by rows.
+   */
+  template <typename T>
+  class ILUTpreconditioner : public Preco<ILUTpreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef ILUTpreconditioner<T> ILUTPRECO;
+    typedef Preco<ILUTPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    Vector<indexType> L_R;
+    Vector<indexType> L_J;
+    Vector<valueType> L_A;
+
+    Vector<indexType> U_R;
+    Vector<indexType> U_J;
+    Vector<valueType> U_A;
+
+    Vector<valueType> D;
+
+    indexType                   nThreads;
+    LDUlevelSchedule<valueType> schedule;
+
+    //! copy the factors in the level scheduled solver when \c nThreads > 1
+    void
+    build_schedule() {
+      if ( nThreads < 2 ) { schedule.clear(); return; }
+      schedule.init( PRECO::pr_size, nThreads );
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        schedule.countL( k, L_R(k+1) - L_R(k) );
+        schedule.countU( k, U_R(k+1) - U_R(k) );
+      }
+      schedule.allocate();
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk ) schedule.pushL( k, L_J(kk), L_A(kk) );
+        for ( indexType kk = U_R(k); kk < U_R(k+1); ++kk ) schedule.pushU( k, U_J(kk), U_A(kk) );
+      }
+      schedule.analyze();
+    }
+
+    //! keep the \c p largest entries of \c idx (values in \c w)
+    void
+    keep_largest( vector<indexType> & idx, Vector<valueType> const & w, indexType p ) const {
+      using ::SparseToolFun::absval;
+      if ( idx.size() <= p ) return;
+      std::nth_element(
+        idx.begin(), idx.begin()+p, idx.end(),
+        [&w]( indexType a, indexType b ) { return absval(w(a)) > absval(w(b)); }
+      );
+      idx.resize(p);
+    }
+
+    //! build the \c ILUT(tau,p) factorization of \c A
+    template <typename MAT, typename REAL>
+    void
+    build_ILUT( MAT const & A, REAL tau, indexType p ) {
+
+      using ::SparseToolFun::absval;
+
+      SPARSETOOL_ASSERT(
+        A.isOrdered(),
+        "ILUTpreconditioner::build_ILUT pattern must be ordered before use"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == A.numCols(),
+        "ILUTpreconditioner::build_ILUT only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() > 0,
+        "ILUTpreconditioner::build_ILUT empty matrix"
+      )
+
+      indexType const none = indexType(-1);
+      PRECO::pr_size = A.numRows();
+      indexType n = PRECO::pr_size;
+
+      // step 0: copy the matrix by rows
+      Vector<indexType> A_R(n+1), A_J;
+      Vector<valueType> A_A;
+      A_R = 0;
+      for ( A.Begin(); A.End(); A.Next() ) ++A_R(A.row()+1);
+      for ( indexType i = 0; i < n; ++i ) A_R(i+1) += A_R(i);
+      A_J.resize(A_R(n));
+      A_A.resize(A_R(n));
+      {
+        Vector<indexType> fill(n);
+        for ( indexType i = 0; i < n; ++i ) fill(i) = A_R(i);
+        for ( A.Begin(); A.End(); A.Next() ) {
+          indexType pos = fill(A.row())++;
+          A_J(pos) = A.column();
+          A_A(pos) = A.value();
+        }
+      }
+
+      // step 1: initialize structure, at most p entries per row and factor
+      L_R.resize(n+1);
+      U_R.resize(n+1);
+      L_R(0) = U_R(0) = 0;
+      L_J.clear(); L_A.clear();
+      U_J.clear(); U_A.clear();
+      L_J.reserve( A_R(n) ); L_A.reserve( A_R(n) );
+      U_J.reserve( A_R(n) ); U_A.reserve( A_R(n) );
+      D.resize(n);
+
+      // sparse accumulator: dense work vector, position map, nonzero lists
+      Vector<valueType> w(n);
+      Vector<indexType> mark(n);
+      w    = valueType(0);
+      mark = none;
+      vector<indexType> lower, upper, heap, touched;
+
+      for ( indexType i = 0; i < n; ++i ) {
+
+        // step 2: scatter row i
+        REAL nrm  = 0;
+        bool diag = false;
+        lower.clear(); upper.clear(); heap.clear(); touched.clear();
+        for ( indexType kk = A_R(i); kk < A_R(i+1); ++kk ) {
+          indexType j = A_J(kk);
+          w(j)   += A_A(kk);
+          nrm    += absval(A_A(kk))*absval(A_A(kk));
+          if ( mark(j) == i ) continue;
+          mark(j) = i;
+          touched.push_back(j);
+          if      ( j < i ) heap.push_back(j);
+          else if ( j > i ) upper.push_back(j);
+          else              diag = true;
+        }
+        REAL tol = tau * std::sqrt( nrm / REAL(A_R(i+1)-A_R(i)) );
+        std::make_heap( heap.begin(), heap.end(), std::greater<indexType>() );
+
+        // step 3: eliminate with the previous rows in increasing column order
+        while ( !heap.empty() ) {
+          std::pop_heap( heap.begin(), heap.end(), std::greater<indexType>() );
+          indexType k = heap.back();
+          heap.pop_back();
+          valueType wk = w(k);
+          if ( absval(wk/D(k)) < tol ) { w(k) = valueType(0); continue; }
+          w(k) = wk/D(k);
+          lower.push_back(k);
+          for ( indexType kk = U_R(k); kk < U_R(k+1); ++kk ) {
+            indexType j = U_J(kk);
+            w(j) -= wk * U_A(kk);
+            if ( mark(j) == i ) continue;
+            mark(j) = i;
+            touched.push_back(j);
+            if      ( j < i ) { heap.push_back(j); std::push_heap( heap.begin(), heap.end(), std::greater<indexType>() ); }
+            else if ( j > i ) upper.push_back(j);
+            else              diag = true;
+          }
+        }
+
+        // step 4: drop by magnitude and keep the p largest of L and of U
+        valueType d = diag ? w(i) : valueType(0);
+        if ( absval(d) == 0 ) d = valueType( tol > 0 ? tol : REAL(1) );
+        w(i) = valueType(0);
+        D(i) = d;
+
+        indexType nu = 0;
+        for ( indexType kk = 0; kk < upper.size(); ++kk ) {
+          indexType j = upper[kk];
+          if ( absval(w(j)) >= tol ) upper[nu++] = j;
+          else                       w(j) = valueType(0);
+        }
+        upper.resize(nu);
+
+        keep_largest( lower, w, p );
+        keep_largest( upper, w, p );
+        std::sort( lower.begin(), lower.end() );
+        std::sort( upper.begin(), upper.end() );
+
+        // step 5: store row i, U scaled by the pivot
+        for ( indexType kk = 0; kk < lower.size(); ++kk ) {
+          L_J.push_back(lower[kk]);
+          L_A.push_back(w(lower[kk]));
+        }
+        for ( indexType kk = 0; kk < upper.size(); ++kk ) {
+          U_J.push_back(upper[kk]);
+          U_A.push_back(w(upper[kk])/d);
+        }
+        L_R(i+1) = L_J.size();
+        U_R(i+1) = U_J.size();
+
+        // clear the accumulator
+        for ( indexType kk = 0; kk < touched.size(); ++kk ) w(touched[kk]) = valueType(0);
+      }
+
+      build_schedule();
+    }
+
+  public:
+
+    ILUTpreconditioner(void) : Preco<ILUTPRECO>(), nThreads(1) {}
+
+    template <typename MAT, typename REAL>
+    ILUTpreconditioner( MAT const & M, REAL tau, indexType p ) : Preco<ILUTPRECO>(), nThreads(1)
+    { build_ILUT( M, tau, p ); }
+
+    /*!
+     *  build the preconditioner from matrix \c M,
+     *  \c tau is the relative drop tolerance and \c p the maximum
+     *  number of entries kept in each row of \f$ L \f$ and of \f$ U \f$
+     */
+    template <typename MAT, typename REAL>
+    void
+    build( MAT const & M, REAL tau, indexType p )
+    { build_ILUT( M, tau, p ); }
+
+    //! solve the triangular factors with \c nt threads (see \c ILDUpreconditioner)
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "ILUTpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      if ( PRECO::pr_size > 0 ) build_schedule();
+    }
+
+    //! number of threads used by \c assPreco
+    indexType numThreads() const { return nThreads; }
+
+    //! number of stored entries, diagonal included
+    indexType nnz() const { return L_R(PRECO::pr_size) + U_R(PRECO::pr_size) + PRECO::pr_size; }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typedef typename VECTOR::valueType vType;
+      res = v;
+
+      if ( nThreads > 1 ) { schedule.apply( res, D ); return; }
+
+      // solve L
+      for ( indexType k = 1; k < PRECO::pr_size; ++k ) {
+        vType tmp(0);
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk )
+          tmp += L_A(kk) * res(L_J(kk));
+        res(k) -= tmp;
+      }
+
+      // solve D U
+      indexType k = PRECO::pr_size;
+      do {
+        --k;
+        vType tmp = res(k) / D(k);
+        for ( indexType kk = U_R(k); kk < U_R(k+1); ++kk )
+          tmp -= U_A(kk) * res(U_J(kk));
+        res(k) = tmp;
+      } while ( k > 0 );
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,ILUTpreconditioner<TP> >
+  operator / (Vector<T> const & v, ILUTpreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,ILUTpreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::ILUTpreconditioner;
+}
+
+#endif
@@ -37,7 +37,7 @@ namespace SparseTool {
 
     Vector<valueType> D;
 
-    mutable Vector<valueType> TMP;
+    PrecoScratch<Vector<valueType> > scratch;
 
     Vector<indexType> LUnnz;
 
@@ -67,7 +67,7 @@ namespace SparseTool {
       PRECO::pr_size = A.numRows();
       LUnnz . resize( PRECO::pr_size );
       D     . resize( PRECO::pr_size );
-      TMP   . resize( PRECO::pr_size );
+      scratch.setup().resize( PRECO::pr_size );
 
       LUnnz . setZero();
       D     . setZero();
@@ -141,10 +141,18 @@ namespace SparseTool {
     build( MAT const & M, valueType _omega, indexType _maxIter )
     { build_JACOBI( M, _omega, _maxIter ); }
 
+    //! concurrent \c assPreco on this object, each with its own work vector
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
     assPreco( VECTOR & x, VECTOR const & b ) const {
+      typename PrecoScratch<Vector<valueType> >::Lease ws( scratch );
+      Vector<valueType> & TMP = *ws;
       x = omega*(b/D);
       for ( indexType ii = 0; ii < maxIter; ++ii ) {
 
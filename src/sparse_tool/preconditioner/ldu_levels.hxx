@@ -0,0 +1,362 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_LDU_LEVELS_HH
+#define SPARSETOOL_ITERATIVE_PRECO_LDU_LEVELS_HH
+
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  #       ######  #     #       #
+  //  #       #     # #     #       #       ###### #    # ###### #       ####
+  //  #       #     # #     #       #       #      #    # #      #      #
+  //  #       #     # #     #       #       #####  #    # #####  #       ####
+  //  #       #     # #     #       #       #      #    # #      #           #
+  //  #       #     # #     #       #       #       #  #  #      #      #    #
+  //  ####### ######   #####  ##### ####### ######   ##   ###### ######  ####
+  */
+  /*!
+   *  Level scheduled solution of \f$ L D U x = v \f$ for the incomplete
+   *  factorizations, \f$ L \f$ and \f$ U \f$ with unit diagonal.
+   *
+   *  The strict lower and upper factors are copied row by row and the
+   *  rows are grouped in levels: the rows of one level depend only on
+   *  rows of the previous levels and are solved concurrently.
+   *  Runs of levels too small to be split among the threads are merged
+   *  and solved by a single thread, so a barrier is paid only between
+   *  groups of rows and not for each level.
+   *  The analysis is done once by \c analyze, each \c apply only
+   *  wakes the threads of a persistent \c ThreadPool and sweeps the
+   *  groups.
+   *  The factors are stored as \c S and promoted to \c T in the sweeps.
+   */
+  template <typename T, typename S = T>
+  class LDUlevelSchedule {
+  public:
+    typedef T valueType; //!< type of the arithmetic of the solve
+    typedef S storeType; //!< type of the stored elements of the factors
+
+  private:
+
+    //! minimum number of rows of a level for each thread to solve it concurrently
+    static indexType const minRowsPerThread = 64;
+
+    indexType nr, nThreads;
+    mutable ThreadPool pool;
+
+    Vector<indexType> L_R, L_J, L_fill;
+    Vector<storeType> L_A;
+
+    Vector<indexType> U_R, U_J, U_fill;
+    Vector<storeType> U_A;
+
+    Vector<indexType> L_perm, L_group, L_par, U_perm, U_group, U_par;
+    indexType         L_levels, U_levels;
+
+    // level of each row, rows ordered by level, groups of levels
+    void
+    levels( Vector<indexType> const & R,
+            Vector<indexType> const & J,
+            bool                      lower,
+            Vector<indexType>       & perm,
+            Vector<indexType>       & group,
+            Vector<indexType>       & par,
+            indexType               & nlev ) {
+      Vector<indexType> lev(nr);
+      nlev = 0;
+      for ( indexType kk = 0; kk < nr; ++kk ) {
+        indexType i = lower ? kk : nr-1-kk;
+        indexType l = 0;
+        for ( indexType jj = R(i); jj < R(i+1); ++jj ) {
+          indexType lj = lev(J(jj))+1;
+          if ( lj > l ) l = lj;
+        }
+        lev(i) = l;
+        if ( l >= nlev ) nlev = l+1;
+      }
+
+      // counting sort of the rows by level, increasing index inside a level
+      Vector<indexType> ptr(nlev+1);
+      ptr = 0;
+      for ( indexType i = 0; i < nr; ++i ) ++ptr(lev(i)+1);
+      for ( indexType l = 0; l < nlev; ++l ) ptr(l+1) += ptr(l);
+      perm.resize(nr);
+      for ( indexType i = 0; i < nr; ++i ) perm(ptr(lev(i))++) = i;
+      for ( indexType l = nlev; l > 0; --l ) ptr(l) = ptr(l-1);
+      ptr(0) = 0;
+
+      // a large level is a parallel group, consecutive small levels a serial one
+      indexType minRows = nThreads * minRowsPerThread;
+      group.clear();
+      par.clear();
+      for ( indexType l = 0; l < nlev; ++l ) {
+        bool p = ptr(l+1) - ptr(l) >= minRows;
+        if ( p || par.empty() || par.back() != 0 ) {
+          group.push_back(ptr(l));
+          par.push_back(p ? 1 : 0);
+        }
+      }
+      group.push_back(nr);
+    }
+
+    template <typename VECTOR>
+    void
+    sweep( VECTOR                  & res,
+           Vector<storeType> const & D,
+           indexType                 tid,
+           SweepBarrier            & barrier ) const {
+      typedef typename VECTOR::valueType vType;
+      bool local_sense = false;
+
+      // solve L, rows in increasing levels
+      for ( indexType g = 0; g < L_par.size(); ++g ) {
+        indexType lo = L_group(g);
+        indexType hi = L_group(g+1);
+        if ( L_par(g) != 0 ) {
+          indexType len = hi - lo;
+          hi  = lo + (len*(tid+1))/nThreads;
+          lo += (len*tid)/nThreads;
+        } else if ( tid != 0 ) {
+          hi = lo;
+        }
+        for ( indexType kk = lo; kk < hi; ++kk ) {
+          indexType i = L_perm(kk);
+          vType tmp(0);
+          for ( indexType jj = L_R(i); jj < L_R(i+1); ++jj )
+            tmp += valueType(L_A(jj)) * res(L_J(jj));
+          res(i) -= tmp;
+        }
+        barrier.wait(local_sense);
+      }
+
+      // solve D and U together, U rows in increasing levels from the bottom
+      for ( indexType g = 0; g < U_par.size(); ++g ) {
+        indexType lo = U_group(g);
+        indexType hi = U_group(g+1);
+        if ( U_par(g) != 0 ) {
+          indexType len = hi - lo;
+          hi  = lo + (len*(tid+1))/nThreads;
+          lo += (len*tid)/nThreads;
+        } else if ( tid != 0 ) {
+          hi = lo;
+        }
+        for ( indexType kk = lo; kk < hi; ++kk ) {
+          indexType i = U_perm(kk);
+          vType tmp = res(i) / valueType(D(i));
+          for ( indexType jj = U_R(i); jj < U_R(i+1); ++jj )
+            tmp -= valueType(U_A(jj)) * res(U_J(jj));
+          res(i) = tmp;
+        }
+        if ( g+1 < U_par.size() ) barrier.wait(local_sense);
+      }
+    }
+
+    // push L compressed by rows and U compressed by columns
+    void
+    push( Vector<indexType> const & LR,
+          Vector<indexType> const & LJ,
+          Vector<storeType> const & LA,
+          Vector<indexType> const & UC,
+          Vector<indexType> const & UI,
+          Vector<storeType> const & UA ) {
+      for ( indexType k = 0; k < nr; ++k ) {
+        for ( indexType kk = LR(k); kk < LR(k+1); ++kk ) pushL( k, LJ(kk), LA(kk) );
+        for ( indexType kk = UC(k); kk < UC(k+1); ++kk ) pushU( UI(kk), k, UA(kk) );
+      }
+    }
+
+    // push L by rows and U by columns, one vector each
+    void
+    push( Vector<Vector<indexType> > const & LJ,
+          Vector<Vector<storeType> > const & LA,
+          Vector<Vector<indexType> > const & UI,
+          Vector<Vector<storeType> > const & UA ) {
+      for ( indexType k = 0; k < nr; ++k ) {
+        for ( indexType kk = 0; kk < LA(k).size(); ++kk ) pushL( k, LJ(k)(kk), LA(k)(kk) );
+        for ( indexType kk = 0; kk < UA(k).size(); ++kk ) pushU( UI(k)(kk), k, UA(k)(kk) );
+      }
+    }
+
+  public:
+
+    LDUlevelSchedule() : nr(0), nThreads(1), L_levels(0), U_levels(0) {}
+
+    //! release the factors and the analysis
+    void
+    clear() {
+      nr = 0;
+      L_levels = U_levels = 0;
+      L_R.clear(); L_J.clear(); L_A.clear(); L_fill.clear();
+      U_R.clear(); U_J.clear(); U_A.clear(); U_fill.clear();
+      L_perm.clear(); L_group.clear(); L_par.clear();
+      U_perm.clear(); U_group.clear(); U_par.clear();
+    }
+
+    //! start loading factors of size \c n to be solved with \c nt threads
+    void
+    init( indexType n, indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "LDUlevelSchedule::init number of threads must be positive" )
+      clear();
+      nr       = n;
+      nThreads = nt;
+      pool.resize(nt);
+      L_fill.resize(nr);
+      U_fill.resize(nr);
+      L_fill = 0;
+      U_fill = 0;
+    }
+
+    //! reserve \c cnt entries in row \c i of \f$ L \f$
+    void countL( indexType i, indexType cnt = 1 ) { L_fill(i) += cnt; }
+
+    //! reserve \c cnt entries in row \c i of \f$ U \f$
+    void countU( indexType i, indexType cnt = 1 ) { U_fill(i) += cnt; }
+
+    //! allocate the rows counted with \c countL and \c countU
+    void
+    allocate() {
+      L_R.resize(nr+1);
+      U_R.resize(nr+1);
+      L_R(0) = U_R(0) = 0;
+      for ( indexType i = 0; i < nr; ++i ) {
+        L_R(i+1) = L_R(i) + L_fill(i);
+        U_R(i+1) = U_R(i) + U_fill(i);
+        L_fill(i) = L_R(i);
+        U_fill(i) = U_R(i);
+      }
+      L_J.resize(L_R(nr));
+      L_A.resize(L_R(nr));
+      U_J.resize(U_R(nr));
+      U_A.resize(U_R(nr));
+    }
+
+    //! store \f$ L_{ij} = a \f$, \f$ i > j \f$
+    void
+    pushL( indexType i, indexType j, storeType const & a ) {
+      indexType kk = L_fill(i)++;
+      L_J(kk) = j;
+      L_A(kk) = a;
+    }
+
+    //! store \f$ U_{ij} = a \f$, \f$ i < j \f$
+    void
+    pushU( indexType i, indexType j, storeType const & a ) {
+      indexType kk = U_fill(i)++;
+      U_J(kk) = j;
+      U_A(kk) = a;
+    }
+
+    //! compute the levels of the loaded factors
+    void
+    analyze() {
+      levels( L_R, L_J, true,  L_perm, L_group, L_par, L_levels );
+      levels( U_R, U_J, false, U_perm, U_group, U_par, U_levels );
+    }
+
+    /*!
+     *  Restart loading the values of factors with the pattern already
+     *  analyzed: \c pushL and \c pushU must be called in the same order,
+     *  the levels are kept.
+     */
+    void
+    reload() {
+      for ( indexType i = 0; i < nr; ++i ) {
+        L_fill(i) = L_R(i);
+        U_fill(i) = U_R(i);
+      }
+    }
+
+    /*!
+     *  Load and analyze the factors of size \c n to be solved with \c nt
+     *  threads, \f$ L \f$ compressed by rows in \c LR, \c LJ, \c LA and
+     *  \f$ U \f$ compressed by columns in \c UC, \c UI, \c UA.
+     */
+    void
+    load( indexType                 n,
+          indexType                 nt,
+          Vector<indexType> const & LR,
+          Vector<indexType> const & LJ,
+          Vector<storeType> const & LA,
+          Vector<indexType> const & UC,
+          Vector<indexType> const & UI,
+          Vector<storeType> const & UA ) {
+      init( n, nt );
+      for ( indexType k = 0; k < nr; ++k ) {
+        countL( k, LR(k+1) - LR(k) );
+        for ( indexType kk = UC(k); kk < UC(k+1); ++kk ) countU( UI(kk) );
+      }
+      allocate();
+      push( LR, LJ, LA, UC, UI, UA );
+      analyze();
+    }
+
+    //! same as \c load with the row \c k of \f$ L \f$ in \c LJ(k), \c LA(k) and the column \c k of \f$ U \f$ in \c UI(k), \c UA(k)
+    void
+    load( indexType                          n,
+          indexType                          nt,
+          Vector<Vector<indexType> > const & LJ,
+          Vector<Vector<storeType> > const & LA,
+          Vector<Vector<indexType> > const & UI,
+          Vector<Vector<storeType> > const & UA ) {
+      init( n, nt );
+      for ( indexType k = 0; k < nr; ++k ) {
+        countL( k, LA(k).size() );
+        for ( indexType kk = 0; kk < UI(k).size(); ++kk ) countU( UI(k)(kk) );
+      }
+      allocate();
+      push( LJ, LA, UI, UA );
+      analyze();
+    }
+
+    //! new values of the factors given to \c load, the pattern and the levels are kept
+    void
+    reload( Vector<indexType> const & LR,
+            Vector<indexType> const & LJ,
+            Vector<storeType> const & LA,
+            Vector<indexType> const & UC,
+            Vector<indexType> const & UI,
+            Vector<storeType> const & UA ) {
+      reload();
+      push( LR, LJ, LA, UC, UI, UA );
+    }
+
+    //! new values of the factors given to \c load, the pattern and the levels are kept
+    void
+    reload( Vector<Vector<indexType> > const & LJ,
+            Vector<Vector<storeType> > const & LA,
+            Vector<Vector<indexType> > const & UI,
+            Vector<Vector<storeType> > const & UA ) {
+      reload();
+      push( LJ, LA, UI, UA );
+    }
+
+    //! size of the loaded factors, 0 if cleared
+    indexType size() const { return nr; }
+
+    //! number of threads used by \c apply
+    indexType numThreads() const { return nThreads; }
+
+    //! number of levels of \f$ L \f$
+    indexType numLevelsL() const { return L_levels; }
+
+    //! number of levels of \f$ U \f$
+    indexType numLevelsU() const { return U_levels; }
+
+    //! overwrite \c res with \f$ (LDU)^{-1} \f$ \c res
+    template <typename VECTOR>
+    void
+    apply( VECTOR & res, Vector<storeType> const & D ) const {
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        sweep( res, D, tid, barrier );
+      } );
+    }
+
+  };
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::LDUlevelSchedule;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_MULTICOLOR_HH
+#define SPARSETOOL_ITERATIVE_PRECO_MULTICOLOR_HH
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //  #     #
+  //  ##   ## #    # #      ##### #  ####   ####  #       ####  #####
+  //  # # # # #    # #        #   # #    # #    # #      #    # #    #
+  //  #  #  # #    # #        #   # #      #    # #      #    # #    #
+  //  #     # #    # #        #   # #      #    # #      #    # #####
+  //  #     # #    # #        #   # #    # #    # #      #    # #   #
+  //  #     #  ####  ######   #   #  ####   ####  ######  ####  #    #
+  */
+  /*!
+   *  Multicolor Gauss-Seidel/SOR sweeps for the SOR family of
+   *  preconditioners.
+   *
+   *  The off diagonal part of the matrix is copied row by row and the
+   *  rows are colored greedily so that no two rows of the same color are
+   *  coupled (in either direction).  A sweep visits the colors in order
+   *  (or in reverse order for the backward sweep) and all the rows of one
+   *  color are updated concurrently with the values of the other colors,
+   *  which is the natural order SOR of the matrix permuted by colors.
+   *  The coloring is done once by \c analyze.
+   */
+  template <typename T>
+  class MulticolorSweep {
+  public:
+    typedef T valueType; //!< type of the elements of the matrix
+
+  private:
+
+    indexType nr, nThreads, nColors;
+    mutable ThreadPool pool;
+
+    Vector<indexType> A_R, A_J, A_fill;
+    Vector<valueType> A_A;
+
+    Vector<indexType> C_ptr, C_perm;
+
+  public:
+
+    MulticolorSweep() : nr(0), nThreads(1), nColors(0) {}
+
+    //! release the matrix and the coloring
+    void
+    clear() {
+      nr = nColors = 0;
+      A_R.clear(); A_J.clear(); A_A.clear(); A_fill.clear();
+      C_ptr.clear(); C_perm.clear();
+    }
+
+    //! start loading an \c n x \c n matrix to be swept with \c nt threads
+    void
+    init( indexType n, indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "MulticolorSweep::init number of threads must be positive" )
+      clear();
+      nr       = n;
+      nThreads = nt;
+      pool.resize(nt);
+      A_fill.resize(nr);
+      A_fill = 0;
+    }
+
+    //! reserve \c cnt off diagonal entries in row \c i
+    void count( indexType i, indexType cnt = 1 ) { A_fill(i) += cnt; }
+
+    //! allocate the rows counted with \c count
+    void
+    allocate() {
+      A_R.resize(nr+1);
+      A_R(0) = 0;
+      for ( indexType i = 0; i < nr; ++i ) {
+        A_R(i+1)  = A_R(i) + A_fill(i);
+        A_fill(i) = A_R(i);
+      }
+      A_J.resize(A_R(nr));
+      A_A.resize(A_R(nr));
+    }
+
+    //! store \f$ A_{ij} = a \f$, \f$ i \neq j \f$
+    void
+    push( indexType i, indexType j, valueType const & a ) {
+      indexType kk = A_fill(i)++;
+      A_J(kk) = j;
+      A_A(kk) = a;
+    }
+
+    //! greedy coloring of the loaded matrix
+    void
+    analyze() {
+      // transposed pattern, the coupling graph must be symmetric
+      Vector<indexType> T_C(nr+1), T_I(A_R(nr));
+      T_C = 0;
+      for ( indexType kk = 0; kk < A_R(nr); ++kk ) ++T_C(A_J(kk)+1);
+      for ( indexType i = 0; i < nr; ++i ) T_C(i+1) += T_C(i);
+      for ( indexType i = 0; i < nr; ++i ) A_fill(i) = T_C(i);
+      for ( indexType i = 0; i < nr; ++i )
+        for ( indexType kk = A_R(i); kk < A_R(i+1); ++kk ) T_I(A_fill(A_J(kk))++) = i;
+      A_fill.clear();
+
+      // first fit: smallest color not used by a colored neighbour
+      indexType const none = indexType(-1);
+      Vector<indexType> color(nr), mark;
+      color   = none;
+      nColors = 0;
+      for ( indexType i = 0; i < nr; ++i ) {
+        mark.resize(nColors+1);
+        for ( indexType kk = A_R(i); kk < A_R(i+1); ++kk ) {
+          indexType c = color(A_J(kk));
+          if ( c != none ) mark(c) = i+1;
+        }
+        for ( indexType kk = T_C(i); kk < T_C(i+1); ++kk ) {
+          indexType c = color(T_I(kk));
+          if ( c != none ) mark(c) = i+1;
+        }
+        indexType c = 0;
+        while ( c < nColors && mark(c) == i+1 ) ++c;
+        color(i) = c;
+        if ( c == nColors ) ++nColors;
+      }
+
+      // rows ordered by color, increasing index inside a color
+      C_ptr.resize(nColors+1);
+      C_ptr = 0;
+      for ( indexType i = 0; i < nr; ++i ) ++C_ptr(color(i)+1);
+      for ( indexType c = 0; c < nColors; ++c ) C_ptr(c+1) += C_ptr(c);
+      C_perm.resize(nr);
+      for ( indexType i = 0; i < nr; ++i ) C_perm(C_ptr(color(i))++) = i;
+      for ( indexType c = nColors; c > 0; --c ) C_ptr(c) = C_ptr(c-1);
+      C_ptr(0) = 0;
+    }
+
+    //! number of threads used by \c run
+    indexType numThreads() const { return nThreads; }
+
+    //! number of colors found by \c analyze
+    indexType numColors() const { return nColors; }
+
+    //! restrict the range \c [lo,hi) to the slice processed by thread \c tid
+    void
+    split( indexType & lo, indexType & hi, indexType tid ) const {
+      indexType len = hi - lo;
+      hi  = lo + (len*(tid+1))/nThreads;
+      lo += (len*tid)/nThreads;
+    }
+
+    /*!
+     *  Call <tt> fun(tid,barrier) </tt> from \c nThreads threads,
+     *  \c tid = 0 is the calling thread; the threads are kept alive
+     *  between the calls.
+     */
+    template <typename FUN>
+    void
+    run( FUN fun ) const
+    { pool.run( fun ); }
+
+    /*!
+     *  One SOR sweep on the rows of thread \c tid:
+     *  \f$ x_i \leftarrow (1-\omega) x_i +
+     *      \omega (b_i - \sum_{j\neq i} A_{ij} x_j)/D_i \f$,
+     *  colors in increasing order if \c forward, decreasing otherwise.
+     *  Must be called by all the threads of \c run.
+     */
+    template <typename VX, typename VB>
+    void
+    sweep( VX                      & x,
+           VB                const & b,
+           Vector<valueType> const & D,
+           valueType                 omega,
+           bool                      forward,
+           indexType                 tid,
+           SweepBarrier            & barrier,
+           bool                    & local_sense ) const {
+      typedef typename VX::valueType vType;
+      valueType omega1 = valueType(1) - omega;
+      for ( indexType cc = 0; cc < nColors; ++cc ) {
+        indexType c  = forward ? cc : nColors-1-cc;
+        indexType lo = C_ptr(c);
+        indexType hi = C_ptr(c+1);
+        split( lo, hi, tid );
+        for ( indexType kk = lo; kk < hi; ++kk ) {
+          indexType i = C_perm(kk);
+          vType tmp = b(i);
+          for ( indexType jj = A_R(i); jj < A_R(i+1); ++jj )
+            tmp -= A_A(jj) * x(A_J(jj));
+          x(i) = omega1 * x(i) + omega * tmp / D(i);
+        }
+        barrier.wait(local_sense);
+      }
+    }
+
+  };
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::MulticolorSweep;
+}
+
+#endif
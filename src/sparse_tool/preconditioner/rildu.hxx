@@ -14,57 +14,74 @@ namespace SparseTool {
   //  #    #   #  #       #     # #     # 
   //  #     # ### ####### ######   #####  
   */
-  //! Incomplete \c LDU preconditioner for the real part obly of a complex matrix
-  template <typename T>
-  class RILDUpreconditioner : public Preco<RILDUpreconditioner<T> > {
+  /*!
+   *  Incomplete \c LDU preconditioner for the real part obly of a complex matrix.
+   *  The factors are stored as \c S and the arithmetic is done in \c T.
+   */
+  template <typename T, typename S = T>
+  class RILDUpreconditioner : public Preco<RILDUpreconditioner<T,S> > {
   public:
 
     //! \cond NODOC
-    typedef RILDUpreconditioner<T> RILDUPRECO;
+    typedef RILDUpreconditioner<T,S> RILDUPRECO;
     typedef Preco<RILDUPRECO>      PRECO;
 
     //! \endcond
     typedef T valueType; //!< type of the elements of the preconditioner
+    typedef S storeType; //!< type of the stored elements of the factors
 
   private:
 
     Vector<indexType> L_R;
     Vector<indexType> L_J;
-    Vector<valueType> L_A;
+    Vector<storeType> L_A;
 
     Vector<indexType> U_C;
     Vector<indexType> U_I;
-    Vector<valueType> U_A;
+    Vector<storeType> U_A;
 
     Vector<valueType> W;
-    Vector<valueType> D;
+    Vector<storeType> D;
 
     Vector<indexType> Lnnz, Unnz;
 
-    //! build incomplete LDU decomposition with specified pattern \c P
-    template <typename MAT, typename PAT>
+    indexType                   nThreads;
+    LDUlevelSchedule<valueType,storeType> schedule;
+
+    //! copy the factors in the level scheduled solver when \c nThreads > 1
     void
-    build_RILDU( MAT const & A, PAT const & P ) {
+    build_schedule() {
+      if ( nThreads < 2 ) { schedule.clear(); return; }
+      schedule.load( PRECO::pr_size, nThreads, L_R, L_J, L_A, U_C, U_I, U_A );
+    }
+
+    //! copy the new values of the factors in the level scheduled solver
+    void
+    reload_schedule() {
+      if ( schedule.size() != PRECO::pr_size ) { build_schedule(); return; }
+      schedule.reload( L_R, L_J, L_A, U_C, U_I, U_A );
+    }
+
+    //! structure of the incomplete LDU decomposition with pattern \c P
+    template <typename PAT>
+    void
+    analyze_RILDU( PAT const & P ) {
 
       SPARSETOOL_ASSERT(
         P.isOrdered(),
-        "RILDUpreconditioner::build_LDU pattern must be ordered before use"
-      )
-      SPARSETOOL_ASSERT(
-        P.numRows() == A.numRows() && P.numCols() == A.numCols(),
-        "RILDUpreconditioner::build_LDU pattern do not match matrix size"
+        "RILDUpreconditioner::analyze pattern must be ordered before use"
       )
       SPARSETOOL_ASSERT(
         P.numRows() == P.numCols(),
-        "RILDUpreconditioner::build_LDU only square matrix allowed"
+        "RILDUpreconditioner::analyze only square matrix allowed"
       )
       SPARSETOOL_ASSERT(
         P.numRows() > 0,
-        "RILDUpreconditioner::build_LDU empty matrix"
+        "RILDUpreconditioner::analyze empty matrix"
       )
 
       // step 0: compute necessary memory
-      PRECO::pr_size = A.numRows();
+      PRECO::pr_size = P.numRows();
       Lnnz.resize( PRECO::pr_size );
       Unnz.resize( PRECO::pr_size );
 
@@ -97,12 +114,8 @@ namespace SparseTool {
 
       D.resize( PRECO::pr_size );
       W.resize( PRECO::pr_size );
+      W = valueType(0);
 
-      D   = valueType(1);
-      W   = valueType(0);
-      L_A = valueType(0);
-      U_A = valueType(0);
-      
       // step 3: fill structure
       for ( P.Begin(); P.End(); P.Next() ) {
         indexType i = P.row();
@@ -117,6 +130,27 @@ namespace SparseTool {
         sort( &U_I(U_C(i)), &U_I(U_C(i+1)) );
       }
 
+      schedule.clear();
+    }
+
+    //! incomplete LDU decomposition of \c A on the structure built by \c analyze_RILDU
+    template <typename MAT>
+    void
+    refactor_RILDU( MAT const & A ) {
+
+      SPARSETOOL_ASSERT(
+        PRECO::pr_size > 0,
+        "RILDUpreconditioner::refactor pattern not analyzed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == PRECO::pr_size && A.numCols() == PRECO::pr_size,
+        "RILDUpreconditioner::refactor matrix do not match the analyzed pattern"
+      )
+
+      D   = storeType(1);
+      L_A = storeType(0);
+      U_A = storeType(0);
+
       // insert values
       for ( A.Begin(); A.End(); A.Next() ) {
         indexType i   = A.row();
@@ -193,14 +227,14 @@ namespace SparseTool {
           indexType UCj  = U_C(j);
           indexType UCj1 = U_C(j+1);
           valueType bf   = 0;
-          for ( indexType jj = UCj; jj < UCj1; ++jj ) bf += W(U_I(jj))*U_A(jj);
+          for ( indexType jj = UCj; jj < UCj1; ++jj ) bf += W(U_I(jj))*valueType(U_A(jj));
           W(j) -= bf;
         }
         //  l^T = D^(-1) W;   W = 0---- l^T = D^(-1)U^(-T) M21^T
         #ifdef LDU_FAST
-        for ( kk = LRk; kk < LRk1; ++kk ) { indexType j = L_J(kk); L_A(kk) = W(j) / D(j); W(j) = 0; }
+        for ( kk = LRk; kk < LRk1; ++kk ) { indexType j = L_J(kk); L_A(kk) = W(j) / valueType(D(j)); W(j) = 0; }
         #else
-        for ( kk = LRk; kk < LRk1; ++kk ) L_A(kk) = W(L_J(kk)) / D(L_J(kk));
+        for ( kk = LRk; kk < LRk1; ++kk ) L_A(kk) = W(L_J(kk)) / valueType(D(L_J(kk)));
         W = 0;
         #endif
         
@@ -217,37 +251,66 @@ namespace SparseTool {
           indexType LRi  = L_R(i);
           indexType LRi1 = L_R(i+1);
           valueType bf = 0;
-          for ( indexType ii = LRi; ii < LRi1; ++ii ) bf += W(L_J(ii))*L_A(ii);
+          for ( indexType ii = LRi; ii < LRi1; ++ii ) bf += W(L_J(ii))*valueType(L_A(ii));
           W(i) -= bf;
         }
 
         valueType bf = 0;
-        for ( kk = LRk; kk < LRk1; ++kk ) bf += L_A(kk) * W(L_J(kk));
+        for ( kk = LRk; kk < LRk1; ++kk ) bf += valueType(L_A(kk)) * W(L_J(kk));
         D(k) -= bf;
 
         #ifdef LDU_FAST
-        for ( kk = UCk; kk < UCk1; ++kk ) { indexType i = U_I(kk); U_A(kk) = W(i) / D(i); W(i) = 0; }
+        for ( kk = UCk; kk < UCk1; ++kk ) { indexType i = U_I(kk); U_A(kk) = W(i) / valueType(D(i)); W(i) = 0; }
         #else
-        for ( kk = UCk; kk < UCk1; ++kk ) U_A(kk) = W(U_I(kk)) / D(U_I(kk));
+        for ( kk = UCk; kk < UCk1; ++kk ) U_A(kk) = W(U_I(kk)) / valueType(D(U_I(kk)));
         W = 0;
         #endif
 
-        SPARSETOOL_ASSERT( D(k) != valueType(0), "ILDUpreconditioner found D(" << k << ") == 0!" );
+        SPARSETOOL_ASSERT( D(k) != storeType(0), "ILDUpreconditioner found D(" << k << ") == 0!" );
       }
+
+      reload_schedule();
+    }
+
+    //! build incomplete LDU decomposition with specified pattern \c P
+    template <typename MAT, typename PAT>
+    void
+    build_RILDU( MAT const & A, PAT const & P ) {
+      SPARSETOOL_ASSERT(
+        P.numRows() == A.numRows() && P.numCols() == A.numCols(),
+        "RILDUpreconditioner::build_LDU pattern do not match matrix size"
+      )
+      analyze_RILDU(P);
+      refactor_RILDU(A);
     }
 
   public:
 
-    RILDUpreconditioner(void) : Preco<RILDUPRECO>() {}
+    RILDUpreconditioner(void) : Preco<RILDUPRECO>(), nThreads(1) {}
     
     template <typename MAT>
-    RILDUpreconditioner( MAT const & M ) : Preco<RILDUPRECO>() 
+    RILDUpreconditioner( MAT const & M ) : Preco<RILDUPRECO>(), nThreads(1)
     { build_RILDU( M, M ); }
 
     template <typename MAT, typename PRE>
-    RILDUpreconditioner( MAT const & M, PRE const & P ) : Preco<RILDUPRECO>() 
+    RILDUpreconditioner( MAT const & M, PRE const & P ) : Preco<RILDUPRECO>(), nThreads(1)
     { build_RILDU(M,P); }
 
+    /*!
+     *  Solve the triangular factors with \c nt threads, 1 (default) is
+     *  the sequential solve.  With more threads the level scheduling
+     *  analysis is done here if already built or at each \c build.
+     */
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "RILDUpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      if ( PRECO::pr_size > 0 ) build_schedule();
+    }
+
+    //! number of threads used by \c assPreco
+    indexType numThreads() const { return nThreads; }
+
     //! build the preconditioner from matrix \c M
     template <typename MAT>
     void
@@ -260,39 +323,58 @@ namespace SparseTool {
     build( MAT const & M, PRE const & P )
     { build_RILDU(M,P); }
 
+    //! compute the structure of the factors from the pattern \c P, the values are computed by \c refactor
+    template <typename PRE>
+    void
+    analyze( PRE const & P )
+    { analyze_RILDU(P); }
+
+    /*!
+     *  Compute the factors of matrix \c M on the structure of the last
+     *  \c analyze or \c build: no memory is allocated and the pattern
+     *  is not recomputed, only the values.  The entries of \c M must
+     *  be in the analyzed pattern.
+     */
+    template <typename MAT>
+    void
+    refactor( MAT const & M )
+    { refactor_RILDU(M); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
     assPreco( VECTOR & res, VECTOR const & v ) const {
       res = v;
 
+      if ( nThreads > 1 ) { schedule.apply( res, D ); return; }
+
       // solve L
       indexType const * pR  = & L_R.front();
       indexType const * pJ  = & L_J.front();
-      valueType const * pLA = & L_A.front();
+      storeType const * pLA = & L_A.front();
       indexType k;
 
       for ( k=1; k < PRECO::pr_size; ++k ) {
         ++pR;
         typename VECTOR::valueType tmp(0);
         for ( indexType i_cnt = pR[1] - pR[0]; i_cnt > 0; --i_cnt )
-          tmp += *pLA++ * res(*pJ++);
+          tmp += valueType(*pLA++) * res(*pJ++);
         res(k) -= tmp;
       };
 
       // solve D
-      for ( k = 0; k < PRECO::pr_size; ++k ) res(k) /= D(k);
+      for ( k = 0; k < PRECO::pr_size; ++k ) res(k) /= valueType(D(k));
 
       // solve U
       indexType const * pC  = & U_C.front() + PRECO::pr_size;
       indexType const * pI  = & U_I.front() + *pC;
-      valueType const * pUA = & U_A.front() + *pC;
+      storeType const * pUA = & U_A.front() + *pC;
 
       do {
         typename VECTOR::valueType resk = res(--k);
         --pC;
         for ( indexType i_cnt = pC[1] - pC[0]; i_cnt > 0; --i_cnt )
-          res(*--pI) -= *--pUA * resk;
+          res(*--pI) -= valueType(*--pUA) * resk;
       } while ( k > 1 );
 
     }
@@ -300,10 +382,10 @@ namespace SparseTool {
   };
 
   //! \cond NODOC
-  template <typename T, typename TP> inline
-  Vector_V_div_P<Vector<T>,RILDUpreconditioner<TP> >
-  operator / (Vector<T> const & v, RILDUpreconditioner<TP> const & P)
-  { return Vector_V_div_P<Vector<T>,RILDUpreconditioner<TP> >(v,P); }
+  template <typename T, typename TP, typename SP> inline
+  Vector_V_div_P<Vector<T>,RILDUpreconditioner<TP,SP> >
+  operator / (Vector<T> const & v, RILDUpreconditioner<TP,SP> const & P)
+  { return Vector_V_div_P<Vector<T>,RILDUpreconditioner<TP,SP> >(v,P); }
   //! \endcond
 
 }
@@ -0,0 +1,438 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_SCHWARZ_HH
+#define SPARSETOOL_ITERATIVE_PRECO_SCHWARZ_HH
+
+#include <atomic>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //   #####
+  //  #     #  ####  #    # #    #   ##   #####  ######
+  //  #       #    # #    # #    #  #  #  #    #     #
+  //   #####  #      ###### #    # #    # #    #    #
+  //        # #      #    # # ## # ###### #####    #
+  //  #     # #    # #    # ##  ## #    # #   #   #
+  //   #####   ####  #    # #    # #    # #    # ######
+  */
+  //! \cond NODOC
+
+  // solutions of all the blocks and right hand side/solution of the sparse ones
+  template <typename T>
+  struct SchwarzWork {
+    Vector<T>          work;
+    Vector<Vector<T> > rhs, sol;
+  };
+
+  //! \endcond
+
+  /*!
+   *  Additive Schwarz (overlapping block Jacobi) preconditioner
+   *  \f$ P^{-1} = \sum_b R_b^T A_b^{-1} R_b \f$.
+   *
+   *  The unknowns are split in subdomains, given by the user or cut from
+   *  a breadth first visit of the pattern, and each subdomain is
+   *  extended by \c overlap layers of neighbours.  The local blocks
+   *  \f$ A_b \f$ are factored with \c lapack_wrapper::LU when small and
+   *  with \c ILUTpreconditioner otherwise (see \c setLocalSolver).
+   *  ILUT is an incomplete factorization: with subdomains larger than
+   *  the dense limit the local solves, and so the preconditioner, are
+   *  inexact and the convergence depends on \c tau and \c p.  With
+   *  \c setExactLocalSolver the large blocks are instead renumbered by
+   *  reverse Cuthill-McKee and factored exactly with
+   *  \c lapack_wrapper::BandedLU, at the cost of the fill of the band.
+   *  The blocks are factored and solved concurrently (dynamic assignment
+   *  of the blocks to the threads), then each thread gathers a slice of
+   *  the result.  With \c setRestricted(true) each unknown takes only
+   *  the value of the subdomain owning it (restricted additive Schwarz,
+   *  usually faster but not symmetric).
+   */
+  template <typename T>
+  class SchwarzPreconditioner : public Preco<SchwarzPreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef SchwarzPreconditioner<T> SCHWARZPRECO;
+    typedef Preco<SCHWARZPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    indexType nBlocks, nThreads, maxDense, ilutP;
+    mutable ThreadPool pool;
+    double    ilutTau;
+    bool      restricted;
+    bool      exactSparse;
+
+    // unknowns of block b (sorted): B_idx[B_ptr(b)..B_ptr(b+1))
+    Vector<indexType> B_ptr, B_idx;
+
+    // positions in the block storage of the copies of unknown i, owner first
+    Vector<indexType> G_ptr, G_pos;
+
+    // local solvers, sparse(b) is the index in ilut (or band) or none
+    vector<lapack_wrapper::LU<valueType> >       lu;
+    vector<ILUTpreconditioner<valueType> >       ilut;
+    vector<lapack_wrapper::BandedLU<valueType> > band;
+    Vector<indexType>                            sparse;
+
+    PrecoScratch<SchwarzWork<valueType> > scratch;
+
+    //! cut a breadth first order of the pattern in \c nb slices
+    void
+    partition( CRowMatrix<valueType> const & A,
+               indexType                     nb,
+               Vector<indexType>           & part ) const {
+      indexType const none = indexType(-1);
+      indexType n = A.numRows();
+      Vector<indexType> const & R = A.getR();
+      Vector<indexType> const & J = A.getJ();
+      Vector<indexType> order;
+      order.reserve(n);
+      part.resize(n);
+      part = none;
+      for ( indexType seed = 0; seed < n; ++seed ) {
+        if ( part(seed) != none ) continue;
+        indexType head = order.size();
+        order.push_back(seed);
+        part(seed) = 0;
+        while ( head < order.size() ) {
+          indexType i = order(head++);
+          for ( indexType kk = R(i); kk < R(i+1); ++kk ) {
+            indexType j = J(kk);
+            if ( part(j) == none ) { part(j) = 0; order.push_back(j); }
+          }
+        }
+      }
+      for ( indexType k = 0; k < n; ++k )
+        part(order(k)) = indexType( (uint64_t(k)*nb)/n );
+    }
+
+    //! factor the local block \c b
+    void
+    factor_block( CRowMatrix<valueType> const & A, indexType b ) {
+      Vector<indexType> const & R = A.getR();
+      Vector<indexType> const & J = A.getJ();
+      Vector<valueType> const & V = A.getA();
+      indexType const * idx = &B_idx.front() + B_ptr(b);
+      indexType         nl  = B_ptr(b+1) - B_ptr(b);
+      if ( sparse(b) == indexType(-1) ) {
+        vector<valueType> dense(size_t(nl)*nl, valueType(0));
+        for ( indexType il = 0; il < nl; ++il ) {
+          indexType i = idx[il];
+          for ( indexType kk = R(i); kk < R(i+1); ++kk ) {
+            indexType const * p = std::lower_bound( idx, idx+nl, J(kk) );
+            if ( p != idx+nl && *p == J(kk) ) dense[il+size_t(p-idx)*nl] += V(kk);
+          }
+        }
+        lu[b].factorize( "SchwarzPreconditioner::factor_block", nl, nl, &dense.front(), nl );
+      } else if ( exactSparse ) {
+        indexType nnz = 0;
+        for ( indexType il = 0; il < nl; ++il ) nnz += R(idx[il]+1) - R(idx[il]);
+        typedef lapack_wrapper::integer integer;
+        integer ni = integer(nl);
+        lapack_wrapper::SparseCCOOR<valueType> Al( ni, ni, integer(nnz), false );
+        for ( indexType il = 0; il < nl; ++il ) {
+          indexType i = idx[il];
+          for ( indexType kk = R(i); kk < R(i+1); ++kk ) {
+            indexType const * p = std::lower_bound( idx, idx+nl, J(kk) );
+            if ( p != idx+nl && *p == J(kk) )
+              Al.push_value_C( integer(il), integer(p-idx), V(kk) );
+          }
+        }
+        lapack_wrapper::BandedLU<valueType> & S = band[sparse(b)];
+        S.setup( Al, true );
+        S.factorize( "SchwarzPreconditioner::factor_block" );
+      } else {
+        indexType nnz = 0;
+        for ( indexType il = 0; il < nl; ++il ) nnz += R(idx[il]+1) - R(idx[il]);
+        CCoorMatrix<valueType> Al( nl, nl, nnz );
+        for ( indexType il = 0; il < nl; ++il ) {
+          indexType i = idx[il];
+          for ( indexType kk = R(i); kk < R(i+1); ++kk ) {
+            indexType const * p = std::lower_bound( idx, idx+nl, J(kk) );
+            if ( p != idx+nl && *p == J(kk) ) Al.insert( il, indexType(p-idx) ) = V(kk);
+          }
+        }
+        Al.internalOrder();
+        ILUTpreconditioner<valueType> & S = ilut[sparse(b)];
+        S.build( Al, ilutTau, ilutP );
+      }
+    }
+
+    //! build the blocks of the partition \c part extended by \c overlap layers
+    void
+    build_Schwarz( CRowMatrix<valueType> const & A,
+                   Vector<indexType>     const & part,
+                   indexType                     overlap ) {
+
+      SPARSETOOL_ASSERT(
+        A.numRows() == A.numCols(),
+        "SchwarzPreconditioner::build_Schwarz only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() > 0,
+        "SchwarzPreconditioner::build_Schwarz empty matrix"
+      )
+      SPARSETOOL_ASSERT(
+        part.size() == A.numRows(),
+        "SchwarzPreconditioner::build_Schwarz partition of size " << part.size() <<
+        " expected " << A.numRows()
+      )
+
+      indexType const none = indexType(-1);
+      PRECO::pr_size = A.numRows();
+      indexType n = PRECO::pr_size;
+      Vector<indexType> const & R = A.getR();
+      Vector<indexType> const & J = A.getJ();
+
+      // step 0: subdomains
+      nBlocks = 0;
+      for ( indexType i = 0; i < n; ++i ) if ( part(i) >= nBlocks ) nBlocks = part(i)+1;
+      B_ptr.resize(nBlocks+1);
+      B_ptr = 0;
+      for ( indexType i = 0; i < n; ++i ) ++B_ptr(part(i)+1);
+      for ( indexType b = 0; b < nBlocks; ++b ) {
+        SPARSETOOL_ASSERT(
+          B_ptr(b+1) > 0,
+          "SchwarzPreconditioner::build_Schwarz empty subdomain " << b
+        )
+        B_ptr(b+1) += B_ptr(b);
+      }
+      Vector<indexType> own(n);
+      {
+        Vector<indexType> fill(nBlocks);
+        for ( indexType b = 0; b < nBlocks; ++b ) fill(b) = B_ptr(b);
+        for ( indexType i = 0; i < n; ++i ) own(fill(part(i))++) = i;
+      }
+
+      // step 1: extend each subdomain by overlap layers of neighbours
+      Vector<indexType> mark(n), ptr(nBlocks+1);
+      mark = none;
+      ptr(0) = 0;
+      B_idx.clear();
+      for ( indexType b = 0; b < nBlocks; ++b ) {
+        indexType first = B_idx.size();
+        for ( indexType kk = B_ptr(b); kk < B_ptr(b+1); ++kk ) {
+          mark(own(kk)) = b;
+          B_idx.push_back(own(kk));
+        }
+        indexType lo = first;
+        for ( indexType l = 0; l < overlap; ++l ) {
+          indexType hi = B_idx.size();
+          for ( indexType kk = lo; kk < hi; ++kk ) {
+            indexType i = B_idx(kk);
+            for ( indexType jj = R(i); jj < R(i+1); ++jj ) {
+              indexType j = J(jj);
+              if ( mark(j) != b ) { mark(j) = b; B_idx.push_back(j); }
+            }
+          }
+          lo = hi;
+        }
+        std::sort( B_idx.begin()+first, B_idx.end() );
+        ptr(b+1) = B_idx.size();
+      }
+      B_ptr = ptr;
+
+      // step 2: copies of each unknown, the owner first
+      G_ptr.resize(n+1);
+      G_ptr = 0;
+      for ( indexType kk = 0; kk < B_idx.size(); ++kk ) ++G_ptr(B_idx(kk)+1);
+      for ( indexType i = 0; i < n; ++i ) G_ptr(i+1) += G_ptr(i);
+      G_pos.resize(B_idx.size());
+      {
+        Vector<indexType> fill(n);
+        for ( indexType i = 0; i < n; ++i ) fill(i) = G_ptr(i)+1;
+        for ( indexType b = 0; b < nBlocks; ++b )
+          for ( indexType kk = B_ptr(b); kk < B_ptr(b+1); ++kk ) {
+            indexType i = B_idx(kk);
+            if ( part(i) == b ) G_pos(G_ptr(i)) = kk;
+            else                G_pos(fill(i)++) = kk;
+          }
+      }
+
+      // step 3: factor the blocks concurrently
+      {
+        vector<lapack_wrapper::LU<valueType> > tmp(nBlocks);
+        lu.swap(tmp);
+      }
+      sparse.resize(nBlocks);
+      indexType ns = 0;
+      for ( indexType b = 0; b < nBlocks; ++b )
+        sparse(b) = B_ptr(b+1) - B_ptr(b) > maxDense ? ns++ : none;
+      ilut.clear();
+      {
+        vector<lapack_wrapper::BandedLU<valueType> > tmp( exactSparse ? ns : 0 );
+        band.swap(tmp);
+      }
+      if ( !exactSparse ) ilut.resize(ns);
+
+      atomic<indexType> next(0);
+      pool.run( [&]( indexType, SweepBarrier & ) {
+        for ( indexType b = next++; b < nBlocks; b = next++ ) factor_block( A, b );
+      } );
+
+      // step 4: work vectors
+      SchwarzWork<valueType> & ws = scratch.setup();
+      ws.work.resize(B_idx.size());
+      ws.rhs.resize( exactSparse ? 0 : ns );
+      ws.sol.resize( exactSparse ? 0 : ns );
+      for ( indexType b = 0; b < nBlocks; ++b ) {
+        if ( sparse(b) == none || exactSparse ) continue;
+        ws.rhs(sparse(b)).resize(blockSize(b));
+        ws.sol(sparse(b)).resize(blockSize(b));
+      }
+    }
+
+  public:
+
+    SchwarzPreconditioner(void)
+    : Preco<SCHWARZPRECO>()
+    , nBlocks(0), nThreads(1), maxDense(500), ilutP(50), ilutTau(1e-4)
+    , restricted(false), exactSparse(false)
+    {}
+
+    SchwarzPreconditioner( CRowMatrix<valueType> const & A, indexType nb, indexType overlap = 1 )
+    : Preco<SCHWARZPRECO>()
+    , nBlocks(0), nThreads(1), maxDense(500), ilutP(50), ilutTau(1e-4)
+    , restricted(false), exactSparse(false)
+    { build( A, nb, overlap ); }
+
+    //! build \c nb subdomains with the built-in partitioner, extended by \c overlap layers
+    void
+    build( CRowMatrix<valueType> const & A, indexType nb, indexType overlap = 1 ) {
+      SPARSETOOL_ASSERT(
+        nb > 0 && nb <= A.numRows(),
+        "SchwarzPreconditioner::build bad number of blocks " << nb
+      )
+      Vector<indexType> part;
+      partition( A, nb, part );
+      build_Schwarz( A, part, overlap );
+    }
+
+    /*!
+     *  build the subdomains of a user partition, \c part(i) is the
+     *  subdomain of unknown \c i, extended by \c overlap layers
+     */
+    void
+    build( CRowMatrix<valueType> const & A, Vector<indexType> const & part, indexType overlap = 1 )
+    { build_Schwarz( A, part, overlap ); }
+
+    //! factor and apply the blocks with \c nt threads (set before \c build to factor in parallel)
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "SchwarzPreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      pool.resize(nt);
+    }
+
+    //! number of threads used by \c build and \c assPreco
+    indexType numThreads() const { return nThreads; }
+
+    //! restricted additive Schwarz: each unknown is taken from its own subdomain only
+    void setRestricted( bool yes ) { restricted = yes; }
+
+    //! \c true if restricted additive Schwarz
+    bool isRestricted() const { return restricted; }
+
+    /*!
+     *  blocks larger than \c maxDenseSize are factored by
+     *  \c ILUTpreconditioner with parameters \c tau and \c p
+     *  (used by the next \c build), their solves are inexact
+     */
+    void
+    setLocalSolver( indexType maxDenseSize, double tau, indexType p ) {
+      maxDense    = maxDenseSize;
+      ilutTau     = tau;
+      ilutP       = p;
+      exactSparse = false;
+    }
+
+    /*!
+     *  blocks larger than \c maxDenseSize are renumbered by reverse
+     *  Cuthill-McKee and factored exactly by \c lapack_wrapper::BandedLU
+     *  (used by the next \c build)
+     */
+    void
+    setExactLocalSolver( indexType maxDenseSize ) {
+      maxDense    = maxDenseSize;
+      exactSparse = true;
+    }
+
+    //! \c true if all the local solves are exact
+    bool hasExactLocalSolver() const { return exactSparse; }
+
+    //! number of subdomains
+    indexType numBlocks() const { return nBlocks; }
+
+    //! number of unknowns of block \c b, overlap included
+    indexType blockSize( indexType b ) const { return B_ptr(b+1) - B_ptr(b); }
+
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typedef typename VECTOR::valueType vType;
+      typename PrecoScratch<SchwarzWork<valueType> >::Lease ws( scratch );
+      Vector<valueType> & work = ws->work;
+      atomic<indexType> next(0);
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        // local solves, the blocks write disjoint slices of work
+        for ( indexType b = next++; b < nBlocks; b = next++ ) {
+          indexType lo = B_ptr(b);
+          indexType nl = B_ptr(b+1) - lo;
+          if ( sparse(b) == indexType(-1) ) {
+            for ( indexType kk = 0; kk < nl; ++kk ) work(lo+kk) = v(B_idx(lo+kk));
+            lu[b].solve( &work.front() + lo );
+          } else if ( !band.empty() ) {
+            for ( indexType kk = 0; kk < nl; ++kk ) work(lo+kk) = v(B_idx(lo+kk));
+            band[sparse(b)].solve( &work.front() + lo );
+          } else {
+            Vector<valueType> & rhs = ws->rhs(sparse(b));
+            Vector<valueType> & sol = ws->sol(sparse(b));
+            for ( indexType kk = 0; kk < nl; ++kk ) rhs(kk) = v(B_idx(lo+kk));
+            ilut[sparse(b)].assPreco( sol, rhs );
+            for ( indexType kk = 0; kk < nl; ++kk ) work(lo+kk) = sol(kk);
+          }
+        }
+        bool local_sense = false;
+        barrier.wait(local_sense);
+
+        // gather a slice of the result
+        indexType lo = (PRECO::pr_size*tid)/nThreads;
+        indexType hi = (PRECO::pr_size*(tid+1))/nThreads;
+        for ( indexType i = lo; i < hi; ++i ) {
+          vType tmp = work(G_pos(G_ptr(i)));
+          if ( !restricted )
+            for ( indexType kk = G_ptr(i)+1; kk < G_ptr(i+1); ++kk )
+              tmp += work(G_pos(kk));
+          res(i) = tmp;
+        }
+      } );
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,SchwarzPreconditioner<TP> >
+  operator / (Vector<T> const & v, SchwarzPreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,SchwarzPreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::SchwarzPreconditioner;
+}
+
+#endif
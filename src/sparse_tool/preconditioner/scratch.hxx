@@ -0,0 +1,103 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_SCRATCH_HH
+#define SPARSETOOL_ITERATIVE_PRECO_SCRATCH_HH
+
+#include <mutex>
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //   #####
+  //  #     #  ####  #####    ##   #####  ####  #    #
+  //  #       #    # #    #  #  #    #   #    # #    #
+  //   #####  #      #    # #    #   #   #      ######
+  //        # #      #####  ######   #   #      #    #
+  //  #     # #    # #   #  #    #   #   #    # #    #
+  //   #####   ####  #    # #    #   #    ####  #    #
+  */
+  //! \cond NODOC
+
+  /*
+  // Work vectors of a preconditioner apply.
+  // The set returned by setup() is sized by build, so an apply never
+  // allocates.  In thread safe mode each apply leases a set from a pool;
+  // the pool grows, by copy of the set of build that is never written
+  // again, only when more applies run concurrently than sets exist, so
+  // one preconditioner can serve concurrent solves and still does not
+  // allocate after warm-up.
+  */
+  template <typename W>
+  class PrecoScratch {
+    mutable W          first;
+    mutable mutex      mtx;
+    mutable vector<W*> pool, owned;
+    bool               safe;
+
+    void
+    reset_pool() {
+      for ( typename vector<W*>::size_type k = 0; k < owned.size(); ++k ) delete owned[k];
+      owned.clear();
+      pool.clear();
+    }
+
+  public:
+
+    PrecoScratch() : safe(false) {}
+
+    PrecoScratch( PrecoScratch const & s ) : first(s.first), safe(s.safe)
+    { reset_pool(); }
+
+    PrecoScratch &
+    operator = ( PrecoScratch const & s ) {
+      if ( this != &s ) { first = s.first; safe = s.safe; reset_pool(); }
+      return *this;
+    }
+
+    ~PrecoScratch() { reset_pool(); }
+
+    // the work vectors to be sized by build, drops the pool
+    W & setup() { reset_pool(); return first; }
+
+    void setThreadSafe( bool yes ) { safe = yes; reset_pool(); }
+    bool isThreadSafe() const { return safe; }
+
+    W *
+    acquire() const {
+      if ( !safe ) return &first;
+      lock_guard<mutex> lock(mtx);
+      if ( pool.empty() ) {
+        owned.push_back( new W(first) );
+        return owned.back();
+      }
+      W * w = pool.back();
+      pool.pop_back();
+      return w;
+    }
+
+    void
+    release( W * w ) const {
+      if ( !safe ) return;
+      lock_guard<mutex> lock(mtx);
+      pool.push_back(w);
+    }
+
+    // work vectors held for the scope of one apply
+    class Lease {
+      PrecoScratch const & s;
+      W                  * w;
+      Lease( Lease const & );
+      Lease & operator = ( Lease const & );
+    public:
+      explicit Lease( PrecoScratch const & _s ) : s(_s), w(_s.acquire()) {}
+      ~Lease() { s.release(w); }
+      W & operator * () const { return *w; }
+      W * operator -> () const { return w; }
+    };
+  };
+
+  //! \endcond
+
+}
+
+#endif
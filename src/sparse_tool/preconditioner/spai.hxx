@@ -0,0 +1,247 @@
+#ifndef SPARSETOOL_ITERATIVE_PRECO_SPAI_HH
+#define SPARSETOOL_ITERATIVE_PRECO_SPAI_HH
+
+#include <atomic>
+
+#include "apinv_pattern.hxx"
+
+using namespace std;
+
+namespace SparseTool {
+
+  /*
+  //   #####  ######     #    ###
+  //  #     # #     #   # #    #
+  //  #       #     #  #   #   #
+  //   #####  ######  #     #  #
+  //        # #       #######  #
+  //  #     # #       #     #  #
+  //   #####  #       #     # ###
+  */
+  /*!
+   *  Sparse approximate inverse preconditioner \f$ M \approx A^{-1} \f$
+   *  for general matrices, minimizing \f$ \| A M - I \|_F \f$ on the
+   *  pattern of \f$ |A|^p \f$ (static pattern SPAI).
+   *
+   *  Each column \f$ m_j \f$ is the solution of the small least squares
+   *  problem \f$ \min \| A(I,J) m_j(J) - e_j(I) \| \f$, \f$ J \f$ the
+   *  pattern of the column and \f$ I \f$ the rows touched by the columns
+   *  \f$ J \f$ of \f$ A \f$, solved with \c lapack_wrapper::QR.  The
+   *  columns are independent and are computed concurrently; the
+   *  application is one sparse matrix-vector product, split by rows
+   *  among the threads.
+   */
+  template <typename T>
+  class SPAIpreconditioner : public Preco<SPAIpreconditioner<T> > {
+  public:
+
+    //! \cond NODOC
+    typedef SPAIpreconditioner<T> SPAIPRECO;
+    typedef Preco<SPAIPRECO>      PRECO;
+
+    //! \endcond
+    typedef T valueType; //!< type of the elements of the preconditioner
+
+  private:
+
+    // M by rows, for the product
+    Vector<indexType> M_R;
+    Vector<indexType> M_J;
+    Vector<valueType> M_A;
+
+    indexType nThreads;
+    mutable ThreadPool pool;
+
+    PrecoScratch<Vector<valueType> > scratch;
+
+    //! build the \c SPAI of \c A on the pattern of \f$ |A|^p \f$
+    template <typename MAT>
+    void
+    build_SPAI( MAT const & A, indexType p ) {
+
+      SPARSETOOL_ASSERT(
+        A.isOrdered(),
+        "SPAIpreconditioner::build_SPAI pattern must be ordered before use"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() == A.numCols(),
+        "SPAIpreconditioner::build_SPAI only square matrix allowed"
+      )
+      SPARSETOOL_ASSERT(
+        A.numRows() > 0,
+        "SPAIpreconditioner::build_SPAI empty matrix"
+      )
+      SPARSETOOL_ASSERT(
+        p > 0,
+        "SPAIpreconditioner::build_SPAI pattern power must be positive"
+      )
+
+      PRECO::pr_size = A.numRows();
+      indexType n = PRECO::pr_size;
+      indexType const none = indexType(-1);
+
+      // step 0: copy the matrix by columns (ordered: increasing rows in each column)
+      Vector<indexType> C_C(n+1), C_I;
+      Vector<valueType> C_A;
+      C_C = 0;
+      for ( A.Begin(); A.End(); A.Next() ) ++C_C(A.column()+1);
+      for ( indexType j = 0; j < n; ++j ) C_C(j+1) += C_C(j);
+      C_I.resize(C_C(n));
+      C_A.resize(C_C(n));
+      {
+        Vector<indexType> fill(n);
+        for ( indexType j = 0; j < n; ++j ) fill(j) = C_C(j);
+        for ( A.Begin(); A.End(); A.Next() ) {
+          indexType pos = fill(A.column())++;
+          C_I(pos) = A.row();
+          C_A(pos) = A.value();
+        }
+      }
+
+      // step 1: pattern of the columns of M, the columns of |A|^p
+      Vector<indexType> S_C(n+1), S_I;
+      {
+        Vector<indexType> mark(n);
+        vector<indexType> list;
+        mark = none;
+        S_C(0) = 0;
+        S_I.reserve( C_C(n) );
+        for ( indexType j = 0; j < n; ++j ) {
+          apinv_pattern( C_C, C_I, j, p, n, mark, list );
+          for ( indexType kk = 0; kk < list.size(); ++kk ) S_I.push_back(list[kk]);
+          S_C(j+1) = S_I.size();
+        }
+      }
+      Vector<valueType> S_A(S_C(n));
+
+      // step 2: least squares for the columns, concurrently
+      atomic<indexType> next(0);
+      pool.run( [&]( indexType, SweepBarrier & ) {
+        lapack_wrapper::QR<valueType> qr;
+        vector<indexType> I;
+        vector<valueType> Ad, x;
+        for ( indexType j = next++; j < n; j = next++ ) {
+          indexType const * Jp = &S_I.front() + S_C(j);
+          indexType         nj = S_C(j+1) - S_C(j);
+          // rows touched by the columns J
+          I.clear();
+          for ( indexType b = 0; b < nj; ++b )
+            for ( indexType kk = C_C(Jp[b]); kk < C_C(Jp[b]+1); ++kk )
+              I.push_back(C_I(kk));
+          std::sort( I.begin(), I.end() );
+          I.erase( std::unique( I.begin(), I.end() ), I.end() );
+          indexType ni = indexType(I.size());
+          vector<indexType>::const_iterator ij = std::lower_bound( I.begin(), I.end(), j );
+          if ( ni < nj || ij == I.end() || *ij != j ) {
+            // structurally singular column: keep the identity
+            for ( indexType b = 0; b < nj; ++b ) S_A(S_C(j)+b) = Jp[b] == j ? valueType(1) : valueType(0);
+            continue;
+          }
+          Ad.assign( size_t(ni)*nj, valueType(0) );
+          for ( indexType b = 0; b < nj; ++b )
+            for ( indexType kk = C_C(Jp[b]); kk < C_C(Jp[b]+1); ++kk ) {
+              indexType a = indexType( std::lower_bound( I.begin(), I.end(), C_I(kk) ) - I.begin() );
+              Ad[a+size_t(b)*ni] += C_A(kk);
+            }
+          x.assign( ni, valueType(0) );
+          x[ij-I.begin()] = valueType(1);
+          qr.factorize( "SPAIpreconditioner::build_SPAI", ni, nj, &Ad.front(), ni );
+          qr.Qt_mul( &x.front() );
+          qr.invR_mul( &x.front() );
+          for ( indexType b = 0; b < nj; ++b ) S_A(S_C(j)+b) = x[b];
+        }
+      } );
+
+      // step 3: M by rows
+      M_R.resize(n+1);
+      M_R = 0;
+      for ( indexType kk = 0; kk < S_C(n); ++kk ) ++M_R(S_I(kk)+1);
+      for ( indexType i = 0; i < n; ++i ) M_R(i+1) += M_R(i);
+      M_J.resize(S_C(n));
+      M_A.resize(S_C(n));
+      {
+        Vector<indexType> fill(n);
+        for ( indexType i = 0; i < n; ++i ) fill(i) = M_R(i);
+        for ( indexType j = 0; j < n; ++j )
+          for ( indexType kk = S_C(j); kk < S_C(j+1); ++kk ) {
+            indexType pos = fill(S_I(kk))++;
+            M_J(pos) = j;
+            M_A(pos) = S_A(kk);
+          }
+      }
+      scratch.setup().resize(n);
+    }
+
+  public:
+
+    SPAIpreconditioner(void) : Preco<SPAIPRECO>(), nThreads(1) {}
+
+    template <typename MAT>
+    SPAIpreconditioner( MAT const & M, indexType p = 1 ) : Preco<SPAIPRECO>(), nThreads(1)
+    { build_SPAI( M, p ); }
+
+    //! build the preconditioner from matrix \c M on the pattern of \f$ |M|^p \f$
+    template <typename MAT>
+    void
+    build( MAT const & M, indexType p = 1 )
+    { build_SPAI( M, p ); }
+
+    //! build and apply with \c nt threads (set before \c build to build in parallel)
+    void
+    setNumThreads( indexType nt ) {
+      SPARSETOOL_ASSERT( nt > 0, "SPAIpreconditioner::setNumThreads bad number of threads " << nt )
+      nThreads = nt;
+      pool.resize(nt);
+    }
+
+    //! number of threads used by \c build and \c assPreco
+    indexType numThreads() const { return nThreads; }
+
+    //! number of stored entries
+    indexType nnz() const { return M_R(PRECO::pr_size); }
+
+    //! concurrent \c assPreco on this object, each with its own work vector
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
+    //! apply preconditioner to vector \c v and store result to vector \c res
+    template <typename VECTOR>
+    void
+    assPreco( VECTOR & res, VECTOR const & v ) const {
+      typedef typename VECTOR::valueType vType;
+      typename PrecoScratch<Vector<valueType> >::Lease ws( scratch );
+      Vector<valueType> & tmp = *ws;
+      pool.run( [&]( indexType tid, SweepBarrier & barrier ) {
+        indexType lo = (PRECO::pr_size*tid)/nThreads;
+        indexType hi = (PRECO::pr_size*(tid+1))/nThreads;
+        for ( indexType i = lo; i < hi; ++i ) {
+          vType s(0);
+          for ( indexType kk = M_R(i); kk < M_R(i+1); ++kk )
+            s += M_A(kk) * v(M_J(kk));
+          tmp(i) = s;
+        }
+        // res may be v: wait for all the reads
+        bool local_sense = false;
+        barrier.wait(local_sense);
+        for ( indexType i = lo; i < hi; ++i ) res(i) = tmp(i);
+      } );
+    }
+
+  };
+
+  //! \cond NODOC
+  template <typename T, typename TP> inline
+  Vector_V_div_P<Vector<T>,SPAIpreconditioner<TP> >
+  operator / (Vector<T> const & v, SPAIpreconditioner<TP> const & P)
+  { return Vector_V_div_P<Vector<T>,SPAIpreconditioner<TP> >(v,P); }
+  //! \endcond
+
+}
+
+namespace SparseToolLoad {
+  using ::SparseTool::SPAIpreconditioner;
+}
+
+#endif
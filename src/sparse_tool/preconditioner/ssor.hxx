@@ -43,6 +43,27 @@ namespace SparseTool {
 
     Vector<indexType> Lnnz, Unnz;
 
+    bool                       multicolor;
+    indexType                  nThreads;
+    MulticolorSweep<valueType> colors;
+
+    //! copy the off diagonal part in the multicolor sweeps when \c multicolor is set
+    void
+    build_colors() {
+      if ( !multicolor ) { colors.clear(); return; }
+      colors.init( PRECO::pr_size, nThreads );
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        colors.count( k, L_R(k+1) - L_R(k) );
+        for ( indexType kk = U_C(k); kk < U_C(k+1); ++kk ) colors.count( U_I(kk) );
+      }
+      colors.allocate();
+      for ( indexType k = 0; k < PRECO::pr_size; ++k ) {
+        for ( indexType kk = L_R(k); kk < L_R(k+1); ++kk ) colors.push( k, L_J(kk), L_A(kk) );
+        for ( indexType kk = U_C(k); kk < U_C(k+1); ++kk ) colors.push( U_I(kk), k, U_A(kk) );
+      }
+      colors.analyze();
+    }
+
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT>
     void
@@ -157,14 +178,16 @@ namespace SparseTool {
           D(i) != valueType(0),
           "SSORpreconditioner::D(" << i << ") = " << D(i) << " size = " << D.size()
         );
+
+      build_colors();
     }
 
   public:
 
-    SSORpreconditioner(void) : Preco<SSORPRECO>() {}
+    SSORpreconditioner(void) : Preco<SSORPRECO>(), multicolor(false), nThreads(1) {}
     
     template <typename MAT>
-    SSORpreconditioner( MAT const & M, valueType _omega, indexType _maxIter ) : Preco<SSORPRECO>()
+    SSORpreconditioner( MAT const & M, valueType _omega, indexType _maxIter ) : Preco<SSORPRECO>(), multicolor(false), nThreads(1)
     { build_SOR( M, _omega, _maxIter ); }
 
     //! build the preconditioner from matrix \c M with pattern \c P
@@ -173,6 +196,25 @@ namespace SparseTool {
     build( MAT const & M, valueType _omega, indexType _maxIter )
     { build_SOR( M, _omega, _maxIter ); }
 
+    /*!
+     *  Select the multicolor sweeps on \c nt threads (\c yes = true)
+     *  or the natural order sweeps (\c yes = false, the default).
+     *  The coloring is computed here if already built or at each \c build.
+     */
+    void
+    setMulticolor( bool yes, indexType nt = 1 ) {
+      SPARSETOOL_ASSERT( nt > 0, "SSORpreconditioner::setMulticolor bad number of threads " << nt )
+      multicolor = yes;
+      nThreads   = nt;
+      if ( PRECO::pr_size > 0 ) build_colors();
+    }
+
+    //! \c true if the multicolor sweeps are used
+    bool isMulticolor() const { return multicolor; }
+
+    //! number of colors of the multicolor sweeps (0 if not used)
+    indexType numColors() const { return colors.numColors(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
@@ -180,6 +222,18 @@ namespace SparseTool {
       typedef typename VECTOR::valueType vType;
       indexType k;
       x.setZero();
+
+      if ( multicolor ) {
+        colors.run( [&]( indexType tid, SweepBarrier & barrier ) {
+          bool sense = false;
+          for ( indexType ii = 0; ii < maxIter; ++ii )
+            colors.sweep( x, b, D, omega, true, tid, barrier, sense );
+          for ( indexType ii = 0; ii < maxIter; ++ii )
+            colors.sweep( x, b, D, omega, false, tid, barrier, sense );
+        } );
+        return;
+      }
+
       for ( indexType ii = 0; ii < maxIter; ++ii ) {
           
         // calcolo ((1/omega-1)*D-U)*x + b;;
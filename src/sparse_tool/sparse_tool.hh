@@ -81,6 +81,11 @@ using namespace SparseToolLoad;
 #include <string>
 
 #include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 // workaround for windows macros
 #ifdef max
@@ -2623,6 +2628,412 @@ c = a / b    for ( i=0; i < sz; ++i ) c[i] = a[i] / b[i];
   }
   //@}
 
+  /*
+  //  #######
+  //     #    #    # #####  ######   ##   #####   ####
+  //     #    #    # #    # #       #  #  #    # #
+  //     #    ###### #    # #####  #    # #    #  ####
+  //     #    #    # #####  #      ###### #    #      #
+  //     #    #    # #   #  #      #    # #    # #    #
+  //     #    #    # #    # ###### #    # #####   ####
+  */
+
+  //! \name Threads
+  //@{
+
+  /*! \cond NODOC */
+
+  // sense reversing barrier shared by the threads of one parallel_run
+  class SweepBarrier {
+    indexType              nt;
+    std::atomic<indexType> count;
+    std::atomic<bool>      sense;
+  public:
+    explicit
+    SweepBarrier( indexType n ) : nt(n), count(n), sense(false) {}
+
+    // restart for n threads, no thread may be waiting
+    void
+    reset( indexType n ) {
+      nt = n;
+      count.store(n);
+      sense.store(false);
+    }
+
+    void
+    wait( bool & local_sense ) {
+      local_sense = !local_sense;
+      if ( count.fetch_sub(1) == 1 ) {
+        count.store(nt);
+        sense.store(local_sense);
+      } else {
+        while ( sense.load() != local_sense ) std::this_thread::yield();
+      }
+    }
+  };
+
+  /*! \endcond */
+
+  /*!
+   *  Persistent team of \c size() threads for the parallel loops repeated
+   *  many times, as the application of the preconditioners.
+   *
+   *  The <tt> size()-1 </tt> workers are started by the first \c run and
+   *  then wait on a condition variable, so a \c run costs a wake up and
+   *  not the creation of the threads.  \c run calls
+   *  <tt> fun(tid,barrier) </tt> for \c tid = 0,...,size()-1, \c tid = 0
+   *  is the calling thread; it returns when all the threads are done and
+   *  then rethrows the first exception thrown by \c fun (a thread that
+   *  throws must not leave the others waiting on the barrier).
+   *  A \c run on a pool busy with another \c run (a concurrent or nested
+   *  call) is done by one shot threads.  A copy has its own workers.
+   */
+  class ThreadPool {
+    typedef std::function<void(indexType,SweepBarrier&)> JOB;
+
+    indexType                       nt;
+    std::vector<std::thread>        workers;
+    std::mutex                      busy;   // held by the running run
+    std::mutex                      mtx;    // protects the fields below
+    std::condition_variable         start_cv;
+    std::condition_variable         done_cv;
+    uint64_t                        generation;
+    indexType                       running;
+    bool                            stop;
+    JOB const *                     job;
+    SweepBarrier                    barrier;
+    std::vector<std::exception_ptr> error;
+
+    void
+    worker( indexType tid, uint64_t seen ) {
+      while ( true ) {
+        JOB const * f;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          while ( !stop && generation == seen ) start_cv.wait(lock);
+          if ( stop ) return;
+          seen = generation;
+          f    = job;
+        }
+        try { (*f)( tid, barrier ); }
+        catch (...) { error[tid] = std::current_exception(); }
+        std::lock_guard<std::mutex> lock(mtx);
+        if ( --running == 0 ) done_cv.notify_one();
+      }
+    }
+
+    void
+    shutdown() {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+      }
+      start_cv.notify_all();
+      for ( indexType t = 0; t < workers.size(); ++t ) workers[t].join();
+      workers.clear();
+      stop = false;
+    }
+
+  public:
+
+    explicit
+    ThreadPool( indexType n = 1 )
+    : nt(n), generation(0), running(0), stop(false), job(nullptr), barrier(n)
+    { SPARSETOOL_ASSERT( n > 0, "ThreadPool bad number of threads " << n ) }
+
+    ThreadPool( ThreadPool const & P )
+    : nt(P.nt), generation(0), running(0), stop(false), job(nullptr), barrier(P.nt)
+    {}
+
+    ThreadPool &
+    operator = ( ThreadPool const & P )
+    { resize( P.nt ); return *this; }
+
+    ~ThreadPool() { shutdown(); }
+
+    //! number of threads of the team, the calling one included
+    indexType size() const { return nt; }
+
+    //! change the number of threads, the workers are restarted by the next \c run
+    void
+    resize( indexType n ) {
+      SPARSETOOL_ASSERT( n > 0, "ThreadPool::resize bad number of threads " << n )
+      if ( n == nt ) return;
+      std::lock_guard<std::mutex> owner(busy);
+      shutdown();
+      nt = n;
+    }
+
+    //! call <tt> fun(tid,barrier) </tt> from the \c size() threads of the team
+    template <typename FUN>
+    void
+    run( FUN const & fun ) {
+      if ( nt == 1 ) {
+        SweepBarrier b(1);
+        fun( indexType(0), b );
+        return;
+      }
+      std::unique_lock<std::mutex> owner( busy, std::try_to_lock );
+      if ( !owner.owns_lock() ) {
+        ThreadPool once(nt);
+        once.run(fun);
+        return;
+      }
+      JOB f = std::cref(fun);
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        if ( workers.empty() ) {
+          workers.reserve(nt-1);
+          for ( indexType tid = 1; tid < nt; ++tid )
+            workers.push_back( std::thread( &ThreadPool::worker, this, tid, generation ) );
+        }
+        barrier.reset(nt);
+        error.assign( nt, std::exception_ptr() );
+        job     = &f;
+        running = nt-1;
+        ++generation;
+      }
+      start_cv.notify_all();
+      try { fun( indexType(0), barrier ); }
+      catch (...) { error[0] = std::current_exception(); }
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        while ( running > 0 ) done_cv.wait(lock);
+        job = nullptr;
+      }
+      for ( indexType tid = 0; tid < nt; ++tid )
+        if ( error[tid] ) std::rethrow_exception( error[tid] );
+    }
+  };
+
+  /*!
+   *  Call <tt> fun(tid,barrier) </tt> for \c tid = 0,...,nt-1 from \c nt
+   *  threads, \c tid = 0 is the calling thread, \c barrier is shared by
+   *  all of them.  One shot version of \c ThreadPool::run: the threads
+   *  are started and joined by each call.
+   */
+  template <typename FUN>
+  inline
+  void
+  parallel_run( indexType nt, FUN const & fun ) {
+    ThreadPool pool(nt);
+    pool.run(fun);
+  }
+  //@}
+
+  /*
+  //  ######  #     #  #####  #    # ####### #######
+  //  #     # #     # #     # #   #  #          #
+  //  #     # #     # #       #  #   #          #
+  //  ######  #     # #       ###    #####      #
+  //  #     # #     # #       #  #   #          #
+  //  #     # #     # #     # #   #  #          #
+  //  ######   #####   #####  #    # #######    #
+  */
+
+  //! \name Bucket Ordering
+  //@{
+
+  /*! \cond NODOC */
+
+  // threads for ordering the entries, 0 = hardware threads
+  inline
+  indexType &
+  sp_assembly_threads()
+  { static indexType nt = 0; return nt; }
+
+  // threads for nnz entries: one every 2^16 entries at most and, with
+  // nb > 0 buckets, per thread histograms no larger than twice the entries
+  inline
+  indexType
+  sp_assembly_nt( indexType nnz, indexType nb ) {
+    indexType nt = sp_assembly_threads();
+    if ( nt == 0 ) nt = indexType( std::thread::hardware_concurrency() );
+    if ( nt == 0 ) nt = 1;
+    nt = std::min( nt, nnz/65536+1 );
+    if ( nb > 0 ) nt = std::min( nt, indexType( std::max( uint64_t(1), (2*uint64_t(nnz))/nb ) ) );
+    return nt;
+  }
+
+  /*! \endcond */
+
+  /*!
+   *  Set the number of threads ordering the entries of the sparse
+   *  matrices in \c internalOrder (and so in \c convert and in the
+   *  MatrixMarket readers).  0 (default) uses the hardware threads,
+   *  small matrices use less threads.
+   */
+  static
+  inline
+  void
+  setAssemblyThreads( indexType nt )
+  { sp_assembly_threads() = nt; }
+
+  //! number of threads set by \c setAssemblyThreads
+  static
+  inline
+  indexType
+  getAssemblyThreads()
+  { return sp_assembly_threads(); }
+
+  /*!
+   *  Stable counting sort of the \c nnz entries \c (K,S,V) by the bucket
+   *  key \c K in \c [0,nb).  On exit \c P (\c nb+1 entries) are the
+   *  bucket pointers and \c So, \c Vo the keys \c S and the values \c V
+   *  by buckets, in the input order inside each bucket.
+   *
+   *  The entries are split among the threads, each one counts its part in
+   *  its own histogram; the offsets of the threads in every bucket follow
+   *  from the prefix sum of the histograms and the entries are scattered
+   *  concurrently.
+   */
+  template <typename T>
+  static
+  void
+  BucketScatter(
+    indexType           nb,
+    indexType           nnz,
+    indexType const     K[],
+    indexType const     S[],
+    T const             V[],
+    Vector<indexType> & P,
+    Vector<indexType> & So,
+    Vector<T>         & Vo
+  ) {
+    indexType const nt = sp_assembly_nt( nnz, nb );
+    std::vector<indexType> cnt( size_t(nt)*nb, 0 );
+    P.resize(nb+1);
+    So.resize(nnz);
+    Vo.resize(nnz);
+
+    // step 1: histogram of each thread
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType * c  = cnt.data() + size_t(t)*nb;
+      indexType   hi = indexType( (uint64_t(nnz)*(t+1))/nt );
+      for ( indexType k = indexType( (uint64_t(nnz)*t)/nt ); k < hi; ++k ) {
+        SPARSETOOL_TEST( K[k] < nb, "BucketScatter: bad key " << K[k] << " >= " << nb )
+        ++c[K[k]];
+      }
+    } );
+
+    // step 2: offset of each thread inside the buckets, bucket sizes in P(b+1)
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType hi = indexType( (uint64_t(nb)*(t+1))/nt );
+      for ( indexType b = indexType( (uint64_t(nb)*t)/nt ); b < hi; ++b ) {
+        indexType tot = 0;
+        for ( indexType s = 0; s < nt; ++s ) {
+          indexType & c = cnt[size_t(s)*nb+b];
+          indexType   n = c;
+          c    = tot;
+          tot += n;
+        }
+        P(b+1) = tot;
+      }
+    } );
+    P(0) = 0;
+    for ( indexType b = 0; b < nb; ++b ) P(b+1) += P(b);
+
+    // step 3: scatter
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType * c  = cnt.data() + size_t(t)*nb;
+      indexType   hi = indexType( (uint64_t(nnz)*(t+1))/nt );
+      for ( indexType k = indexType( (uint64_t(nnz)*t)/nt ); k < hi; ++k ) {
+        indexType pos = P(K[k]) + c[K[k]]++;
+        So(pos) = S[k];
+        Vo(pos) = V[k];
+      }
+    } );
+  }
+
+  /*!
+   *  Sort by \c S the entries of each bucket \c [P(b),P(b+1)) of the
+   *  \c nb buckets and sum the entries with the same key.  The sort is
+   *  stable, the duplicates are summed in their order.  On exit \c P,
+   *  \c S and \c V are compressed and \c V has one more trailing zero.
+   *
+   *  The buckets are split among the threads by number of entries;
+   *  buckets already ordered are only scanned, short ones are sorted by
+   *  insertion.
+   */
+  template <typename T>
+  static
+  void
+  BucketSortSum(
+    indexType           nb,
+    Vector<indexType> & P,
+    Vector<indexType> & S,
+    Vector<T>         & V
+  ) {
+    indexType const nnz = P(nb);
+    indexType const nt  = sp_assembly_nt( nnz, 0 );
+    std::vector<indexType> cut( nt+1 ), U( nb+1 );
+    cut[0]  = 0;
+    cut[nt] = nb;
+    for ( indexType t = 1; t < nt; ++t )
+      cut[t] = indexType(
+        std::lower_bound( P.begin(), P.begin()+nb, indexType( (uint64_t(nnz)*t)/nt ) ) - P.begin()
+      );
+
+    // step 1: sort and compact each bucket in place, U(b+1) unique entries
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      std::vector<std::pair<indexType,T> > buf;
+      for ( indexType b = cut[t]; b < cut[t+1]; ++b ) {
+        indexType lo = P(b), hi = P(b+1), k;
+        for ( k = lo+1; k < hi && S(k-1) <= S(k); ++k ) {}
+        if ( k < hi ) {
+          if ( hi-lo <= 32 ) {
+            for ( k = lo+1; k < hi; ++k ) {
+              indexType s = S(k);
+              T         v = V(k);
+              indexType m = k;
+              for ( ; m > lo && S(m-1) > s; --m ) { S(m) = S(m-1); V(m) = V(m-1); }
+              S(m) = s;
+              V(m) = v;
+            }
+          } else {
+            buf.clear();
+            for ( k = lo; k < hi; ++k ) buf.push_back( std::make_pair( S(k), V(k) ) );
+            std::stable_sort(
+              buf.begin(), buf.end(),
+              []( std::pair<indexType,T> const & a, std::pair<indexType,T> const & c )
+              { return a.first < c.first; }
+            );
+            for ( k = lo; k < hi; ++k ) { S(k) = buf[k-lo].first; V(k) = buf[k-lo].second; }
+          }
+        }
+        indexType w = lo;
+        for ( k = lo+1; k < hi; ++k ) {
+          if ( S(k) == S(w) ) V(w) += V(k);
+          else { ++w; S(w) = S(k); V(w) = V(k); }
+        }
+        U[b+1] = hi > lo ? w-lo+1 : 0;
+      }
+    } );
+
+    // step 2: move the unique entries when there are duplicates
+    U[0] = 0;
+    for ( indexType b = 0; b < nb; ++b ) U[b+1] += U[b];
+    if ( U[nb] < nnz ) {
+      Vector<indexType> S1( U[nb] );
+      Vector<T>         V1( U[nb]+1 );
+      parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+        for ( indexType b = cut[t]; b < cut[t+1]; ++b )
+          for ( indexType k = U[b]; k < U[b+1]; ++k ) {
+            S1(k) = S(P(b)+k-U[b]);
+            V1(k) = V(P(b)+k-U[b]);
+          }
+      } );
+      S.swap(S1);
+      V.swap(V1);
+      for ( indexType b = 0; b <= nb; ++b ) P(b) = U[b];
+    } else {
+      V.resize(nnz+1);
+    }
+    V(U[nb]) = T(0);
+  }
+
+  //@}
+
   /*
   //  ####   #####     ##    #####    ####   ######
   // #       #    #   #  #   #    #  #       #
@@ -4033,10 +4444,38 @@ CCoorMatrix<double> ccoor(sobj);
 
     /*! \brief
      *  Order the internal structure to permit random access to nonzeros.
+     *  The entries are counting sorted by columns, then the rows of each
+     *  column are sorted and the duplicates summed, on the threads set by
+     *  \c setAssemblyThreads (see \c BucketScatter and \c BucketSortSum).
      */
     void
     internalOrder() {
-      QuickSortIJ<indexType,T>( &I.front(), &J.front(), &A.front(), SPARSE::sp_nnz);
+      Vector<indexType> Is;
+      Vector<valueType> As;
+      BucketScatter<T>(
+        SPARSE::sp_ncols, SPARSE::sp_nnz, J.data(), I.data(), A.data(), C, Is, As
+      );
+      BucketSortSum<T>( SPARSE::sp_ncols, C, Is, As );
+      I.swap(Is);
+      A.swap(As);
+      SPARSE::sp_nnz = C(SPARSE::sp_ncols);
+      J.resize(SPARSE::sp_nnz);
+      SPARSE::sp_lower_nnz = 0;
+      SPARSE::sp_diag_nnz  = 0;
+      SPARSE::sp_upper_nnz = 0;
+      for ( indexType j = 0; j < SPARSE::sp_ncols; ++j )
+        for ( indexType k = C(j); k < C(j+1); ++k ) {
+          J(k) = j;
+          SPARSE::ldu_count(I(k),j);
+        }
+      SPARSE::sp_isOrdered = true;
+    }
+
+  private:
+
+    // entries sorted by columns and rows: sum duplicates, count and build C
+    void
+    compress() {
       // eliminate duplicate elements
       indexType i1 = 0, i = 0;
       SPARSE::sp_lower_nnz = 0;
@@ -4061,6 +4500,8 @@ CCoorMatrix<double> ccoor(sobj);
 
       indexType nc = 0;
       C(0) = 0;
+      // leading empty columns
+      if ( SPARSE::sp_nnz > 0 ) while ( nc < J(0) ) C(++nc) = 0;
       for ( indexType k = 1; k < SPARSE::sp_nnz; ++k ) {
         SPARSETOOL_TEST(
           J(k-1) <= J(k),
@@ -4079,6 +4520,8 @@ CCoorMatrix<double> ccoor(sobj);
       while ( ++nc <= SPARSE::sp_ncols ) C(nc) = SPARSE::sp_nnz;
     }
 
+  public:
+
     //! Return the position of the element \c (i,j) in the vector storing elements
     indexType
     position( indexType i, indexType j ) const {
@@ -4111,6 +4554,47 @@ CCoorMatrix<double> ccoor(sobj);
       return A(SPARSE::sp_nnz-1);
     }
 
+    /*! \brief
+     *  Set the number of entries to \c nnz without inserting them:
+     *  rows, columns and values are then written by position through
+     *  \c getI, \c getJ and \c getA, and \c internalOrder must be
+     *  called when done.  The first entries are kept if \c nnz is less
+     *  than the current number of entries.
+     */
+    void
+    setNnz( indexType nnz ) {
+      I.resize(nnz);
+      J.resize(nnz);
+      A.resize(nnz+1);
+      A.back() = T(0);
+      SPARSE::sp_nnz       = nnz;
+      SPARSE::sp_isOrdered = false;
+    }
+
+    /*! \brief
+     *  Build the matrix of \c nr rows and \c nc columns from the \c nnz
+     *  entries stored in the arrays \c Ri (rows), \c Ji (columns) and
+     *  \c V (values); the indices are converted to \c indexType.
+     *  If \c ordered the entries are already sorted by columns and rows
+     *  without duplicates, as after \c internalOrder, and are not sorted again.
+     */
+    template <typename IT>
+    void
+    load( indexType nr, indexType nc, indexType nnz,
+          IT const Ri[], IT const Ji[], valueType const V[],
+          bool ordered = false ) {
+      resize( nr, nc, nnz );
+      setNnz( nnz );
+      for ( indexType k = 0; k < nnz; ++k ) {
+        I(k) = indexType(Ri[k]);
+        J(k) = indexType(Ji[k]);
+        A(k) = V[k];
+        SPARSE::test_index(I(k),J(k));
+      }
+      if ( ordered ) compress();
+      else           internalOrder();
+    }
+
     valueType const &
     operator [] (indexType idx) const {
       SPARSE::test_nnz(idx);
@@ -4163,7 +4647,9 @@ CCoorMatrix<double> ccoor(sobj);
     Vector<valueType> const & getA(void) const { return A; } //!< return the value vector
     Vector<valueType>       & getA(void)       { return A; } //!< return the value vector
     Vector<indexType> const & getI(void) const { return I; } //!< return the row index vector
+    Vector<indexType>       & getI(void)       { return I; } //!< return the row index vector (see \c setNnz)
     Vector<indexType> const & getJ(void) const { return J; } //!< return the column index vector
+    Vector<indexType>       & getJ(void)       { return J; } //!< return the column index vector (see \c setNnz)
     Vector<indexType> const & getC(void) const { return C; } //!< return the pointer of the column index (valid after ordering)
 
     // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -4413,12 +4899,15 @@ CRowMatrix<double> crow(sobj);   // instance a CRowMatrix<double> class which is
     mutable indexType iter_row;
     mutable indexType iter_ptr;
 
+    // sort the columns of each row and sum the duplicates (unless already
+    // \c sorted) and count the entries
     void
-    internalOrder() {
+    internalOrder( bool sorted = false ) {
       SPARSETOOL_ASSERT(
         R[SPARSE::sp_nrows] == SPARSE::sp_nnz,
         "CRowMatrix::internalOrder() bad data for matrix"
       )
+      if ( !sorted ) BucketSortSum<T>( SPARSE::sp_nrows, R, J, A );
       indexType ii, kk, rk, rk1;
       SPARSE::sp_lower_nnz = 0;
       SPARSE::sp_diag_nnz  = 0;
@@ -4426,7 +4915,6 @@ CRowMatrix<double> crow(sobj);   // instance a CRowMatrix<double> class which is
       for ( ii = 0, rk = R(0); ii < SPARSE::sp_nrows; ++ii, rk = rk1 ) {
         rk1 = R(ii+1);
         if ( rk1 > rk ) { // skip empty rows
-          QuickSortI<indexType,T>( &J(rk), &A(rk), rk1 - rk);
           // setup statistic
           for ( kk = rk; kk < rk1; ++kk ) SPARSE::ldu_count(ii,J(kk));
   #ifdef SPARSETOOL_DEBUG
@@ -4462,20 +4950,22 @@ CRowMatrix<double> crow(sobj);   // instance a CRowMatrix<double> class which is
       for ( M.Begin(); M.End();  M.Next() ) {
         indexType i = M.row();
         indexType j = M.column();
-        if ( cmp(i, j) ) ++R(i);
+        if ( cmp(i, j) ) ++R(i+1);
       }
       for ( indexType k = 0; k < SPARSE::sp_nrows; ++k ) R(k+1) += R(k);
 
-      // step 2: Fill matrix
+      // step 2: Fill matrix, in the order of M (ordered rows stay ordered)
       for ( M.Begin(); M.End(); M.Next() ) {
         indexType i = M.row();
         indexType j = M.column();
         if ( cmp(i,j) ) {
-          indexType ii = --R(i);
+          indexType ii = R(i)++;
           M.assign(A(ii));
           J(ii) = j;
         }
       }
+      for ( indexType k = SPARSE::sp_nrows; k > 0; --k ) R(k) = R(k-1);
+      R(0) = 0;
 
       SPARSETOOL_TEST(
         R(0) == 0 && R(SPARSE::sp_nrows) == SPARSE::sp_nnz,
@@ -4575,6 +5065,46 @@ CRowMatrix<double> crow(sobj);   // instance a CRowMatrix<double> class which is
     resize(SparseBase<MAT> const & M)
     { resize(M,all_ok()); }
 
+    /*! \brief
+     *  Build the matrix of \c nr rows and \c nc columns from compressed
+     *  rows: \c Rp the \c nr+1 row pointers, \c Ji the column indices and
+     *  \c V the values; the indices are converted to \c indexType.
+     *  If \c ordered the columns are already increasing in each row and
+     *  are not sorted again.  The pointers and the indices are checked
+     *  also in release builds.
+     */
+    template <typename IT>
+    void
+    load( indexType nr, indexType nc,
+          IT const Rp[], IT const Ji[], valueType const V[],
+          bool ordered = false ) {
+      SPARSETOOL_ASSERT(
+        Rp[0] == 0,
+        "CRowMatrix::load bad row pointers"
+      )
+      for ( indexType k = 0; k < nr; ++k )
+        SPARSETOOL_ASSERT(
+          Rp[k] <= Rp[k+1],
+          "CRowMatrix::load decreasing row pointers at " << k
+        )
+      SPARSE::setup( nr, nc );
+      SPARSE::sp_nnz = indexType(Rp[nr]);
+      R.resize( nr + 1 );
+      J.resize( SPARSE::sp_nnz );
+      A.resize( SPARSE::sp_nnz + 1 );
+      for ( indexType k = 0; k <= nr; ++k ) R(k) = indexType(Rp[k]);
+      for ( indexType k = 0; k < SPARSE::sp_nnz; ++k ) {
+        SPARSETOOL_ASSERT(
+          indexType(Ji[k]) < nc,
+          "CRowMatrix::load column index " << Ji[k] << " out of range at " << k
+        )
+        J(k) = indexType(Ji[k]);
+        A(k) = V[k];
+      }
+      A(SPARSE::sp_nnz) = valueType(0);
+      internalOrder( ordered );
+    }
+
     void
     scaleRow( indexType nr, valueType const & val ) {
       SPARSE::test_row(nr);
@@ -4800,8 +5330,11 @@ CColMatrix<double> ccol(sobj);  // instance a CColMatrix<double> class which is
     mutable indexType iter_col;
     mutable indexType iter_ptr;
 
+    // sort the rows of each column and sum the duplicates (unless already
+    // \c sorted) and count the entries
     void
-    internalOrder() {
+    internalOrder( bool sorted = false ) {
+      if ( !sorted ) BucketSortSum<T>( SPARSE::sp_ncols, C, I, A );
       indexType jj, kk, ck, ck1;
       SPARSE::sp_lower_nnz = 0;
       SPARSE::sp_diag_nnz  = 0;
@@ -4809,7 +5342,6 @@ CColMatrix<double> ccol(sobj);  // instance a CColMatrix<double> class which is
       for ( jj = 0, ck = C(0); jj < SPARSE::sp_ncols; ++jj, ck = ck1 ) {
         ck1 = C(jj+1);
         if ( ck1 > ck ) { // skip empty columns
-          QuickSortI<indexType,T>( &I(ck), &A(ck), ck1 - ck );
           // setup statistic
           for ( kk = ck; kk < ck1; ++kk ) SPARSE::ldu_count(I(kk),jj);
   #ifdef SPARSETOOL_DEBUG
@@ -4844,20 +5376,22 @@ CColMatrix<double> ccol(sobj);  // instance a CColMatrix<double> class which is
       for ( M.Begin(); M.End(); M.Next() ) {
         indexType i = M.row();
         indexType j = M.column();
-        if ( cmp(i,j) ) ++C(j);
+        if ( cmp(i,j) ) ++C(j+1);
       }
       for ( indexType k = 0; k < SPARSE::sp_ncols; ++k ) C(k+1) += C(k);
 
-      // step 2: Fill matrix
+      // step 2: Fill matrix, in the order of M (ordered columns stay ordered)
       for ( M.Begin(); M.End(); M.Next() ) {
         indexType i = M.row();
         indexType j = M.column();
         if ( cmp(i,j) ) {
-          indexType jj = --C(j);
+          indexType jj = C(j)++;
           M.assign(A(jj));
           I(jj) = i;
         }
       }
+      for ( indexType k = SPARSE::sp_ncols; k > 0; --k ) C(k) = C(k-1);
+      C(0) = 0;
       SPARSETOOL_TEST(
         C(0) == 0 && C(SPARSE::sp_ncols) == SPARSE::sp_nnz,
         "CColMatrix::resize(Sparse & A) failed"
@@ -4957,6 +5491,46 @@ CColMatrix<double> ccol(sobj);  // instance a CColMatrix<double> class which is
     resize( SparseBase<MAT> const & M )
     { resize(M,all_ok()); }
 
+    /*! \brief
+     *  Build the matrix of \c nr rows and \c nc columns from compressed
+     *  columns: \c Cp the \c nc+1 column pointers, \c Ii the row indices
+     *  and \c V the values; the indices are converted to \c indexType.
+     *  If \c ordered the rows are already increasing in each column and
+     *  are not sorted again.  The pointers and the indices are checked
+     *  also in release builds.
+     */
+    template <typename IT>
+    void
+    load( indexType nr, indexType nc,
+          IT const Cp[], IT const Ii[], valueType const V[],
+          bool ordered = false ) {
+      SPARSETOOL_ASSERT(
+        Cp[0] == 0,
+        "CColMatrix::load bad column pointers"
+      )
+      for ( indexType k = 0; k < nc; ++k )
+        SPARSETOOL_ASSERT(
+          Cp[k] <= Cp[k+1],
+          "CColMatrix::load decreasing column pointers at " << k
+        )
+      SPARSE::setup( nr, nc );
+      SPARSE::sp_nnz = indexType(Cp[nc]);
+      C.resize( nc + 1 );
+      I.resize( SPARSE::sp_nnz );
+      A.resize( SPARSE::sp_nnz + 1 );
+      for ( indexType k = 0; k <= nc; ++k ) C(k) = indexType(Cp[k]);
+      for ( indexType k = 0; k < SPARSE::sp_nnz; ++k ) {
+        SPARSETOOL_ASSERT(
+          indexType(Ii[k]) < nr,
+          "CColMatrix::load row index " << Ii[k] << " out of range at " << k
+        )
+        I(k) = indexType(Ii[k]);
+        A(k) = V[k];
+      }
+      A(SPARSE::sp_nnz) = valueType(0);
+      internalOrder( ordered );
+    }
+
     void
     scaleRow( indexType nr, valueType const & val ) {
       SPARSE::test_row(nr);
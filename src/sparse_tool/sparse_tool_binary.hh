@@ -0,0 +1,864 @@
+/*!
+
+  \file     sparse_tool_binary.hh
+  \brief    Binary files of the sparse matrices (format version 1,
+            see \c SB_VERSION): save, load with conversion of the
+            indices and values, and read only memory mapped view.
+
+*/
+
+#ifndef SPARSETOOL_BINARY_HH
+#define SPARSETOOL_BINARY_HH
+
+#include "sparse_tool.hh"
+#include "sparse_tool_matrix_market.hh"
+#include "../lapack_wrapper/lapack_wrapper++.hh"
+
+#include <stdint.h>
+#include <complex>
+#include <limits>
+
+namespace SparseTool {
+
+  /*
+  //  ######
+  //  #     # # #    #   ##   #####  #   #
+  //  #     # # ##   #  #  #  #    #  # #
+  //  ######  # # #  # #    # #    #   #
+  //  #     # # #  # # ###### #####    #
+  //  #     # # #   ## #    # #   #    #
+  //  ######  # #    # #    # #    #   #
+  */
+
+  /*!
+   *  Storage of a matrix in the binary format.
+   *
+   *  A binary file (version 1) is a header of 192 bytes followed by up
+   *  to four raw arrays in native byte order, each at an offset multiple
+   *  of 64 bytes: the compressed pointers (rows of \c CRowMatrix, columns
+   *  of \c CColMatrix and \c CCoorMatrix), the row indices, the column
+   *  indices and the values.  The header stores the sizes, the width of
+   *  the indices, the type of the values and the ordering flags, so that
+   *  a file can be loaded with a copy, converting indices and values if
+   *  needed, or used in place through \c SparseBinaryView.
+   */
+  typedef enum {
+    SB_CROW  = 0, //!< compressed rows (\c CRowMatrix)
+    SB_CCOL  = 1, //!< compressed columns (\c CColMatrix)
+    SB_CCOOR = 2, //!< coordinates sorted by columns (\c CCoorMatrix)
+    SB_COO   = 3  //!< plain coordinates (\c lapack_wrapper::SparseCCOOR)
+  } SparseBinaryStorage;
+
+  /*! \cond NODOC */
+
+  static uint32_t const SB_VERSION = 1;
+  static uint32_t const SB_ENDIAN  = 0x01020304;
+  static uint64_t const SB_ALIGN   = 64;
+
+  // slots of the arrays
+  enum { SB_PTR = 0, SB_ROW = 1, SB_COL = 2, SB_VAL = 3 };
+
+  // flags
+  enum { SB_ORDERED = 1, SB_FORTRAN = 2, SB_FULL = 4, SB_ROW_MAJOR = 8 };
+
+  // code of the type of the values
+  template <typename T> struct sb_code { static uint32_t const value = 0; };
+  template <> struct sb_code<int>                  { static uint32_t const value = 1; };
+  template <> struct sb_code<float>                { static uint32_t const value = 2; };
+  template <> struct sb_code<double>               { static uint32_t const value = 3; };
+  template <> struct sb_code<std::complex<float> > { static uint32_t const value = 4; };
+  template <> struct sb_code<std::complex<double> >{ static uint32_t const value = 5; };
+
+  // bytes of a value of code \c c, 0 for an unknown code
+  inline
+  uint32_t
+  sb_bytes( uint32_t c ) {
+    switch ( c ) {
+      case 1: return sizeof(int);
+      case 2: return sizeof(float);
+      case 3: return sizeof(double);
+      case 4: return sizeof(std::complex<float>);
+      case 5: return sizeof(std::complex<double>);
+    }
+    return 0;
+  }
+
+  struct SparseBinaryHeader {
+    char     magic[8];    // "SPTLBIN"
+    uint32_t version;
+    uint32_t endian;      // SB_ENDIAN as written
+    uint32_t storage;     // SparseBinaryStorage
+    uint32_t indexBytes;  // 4 or 8
+    uint32_t valueCode;   // sb_code
+    uint32_t valueBytes;
+    uint32_t flags;
+    uint32_t reserved0;
+    uint64_t nRows, nCols, nnz;
+    uint64_t nLower, nDiag, nUpper;
+    uint64_t offset[4];   // byte offset of the arrays, 0 if missing
+    uint64_t length[4];   // number of elements of the arrays
+    uint64_t reserved[5];
+  };
+
+  static_assert( sizeof(SparseBinaryHeader) == 192, "SparseBinaryHeader must be 192 bytes" );
+
+  // conversion of the values on load, complex to real is refused
+  template <typename T, typename S> inline
+  void sb_cast( T & d, S const & s ) { d = T(s); }
+
+  template <typename T, typename S> inline
+  void sb_cast( std::complex<T> & d, S const & s ) { d = std::complex<T>(T(s)); }
+
+  template <typename T, typename S> inline
+  void sb_cast( std::complex<T> & d, std::complex<S> const & s )
+  { d = std::complex<T>( T(s.real()), T(s.imag()) ); }
+
+  template <typename T, typename S> inline
+  void sb_cast( T &, std::complex<S> const & )
+  { SPARSETOOL_ERR( "SparseBinary: cannot load complex values in a real matrix" ) }
+
+  template <typename T, typename S> inline
+  void
+  sb_convert( void const * src, uint64_t n, std::vector<T> & dst ) {
+    S const * s = static_cast<S const *>(src);
+    dst.resize( size_t(n) );
+    for ( uint64_t k = 0; k < n; ++k ) sb_cast( dst[k], s[k] );
+  }
+
+  // a binary file mapped in memory, header, pointers and indices checked
+  class SparseBinaryFile {
+    MappedFile         file;
+    SparseBinaryHeader h;
+    std::string        name;
+
+    SparseBinaryFile( SparseBinaryFile const & );
+    SparseBinaryFile & operator = ( SparseBinaryFile const & );
+
+  public:
+
+    template <typename IT>
+    IT const *
+    index( int slot ) const {
+      SPARSETOOL_TEST( sizeof(IT) == h.indexBytes, "SparseBinary: bad index width" )
+      return reinterpret_cast<IT const *>( file.begin() + h.offset[slot] );
+    }
+
+  private:
+
+    void
+    check_array( int slot, uint64_t len, uint64_t bytes ) const {
+      SPARSETOOL_ASSERT(
+        h.offset[slot] != 0 && h.length[slot] == len,
+        "SparseBinary: file `" << name << "' array " << slot << " missing or of wrong length"
+      )
+      // written as a division to not overflow with a corrupted header
+      SPARSETOOL_ASSERT(
+        h.offset[slot] % SB_ALIGN == 0 &&
+        h.offset[slot] <= file.size() &&
+        len <= ( file.size() - h.offset[slot] ) / bytes,
+        "SparseBinary: file `" << name << "' array " << slot << " out of the file"
+      )
+    }
+
+    // compressed pointers: start at 0, non decreasing, end at nnz
+    template <typename IT>
+    void
+    check_pointers( uint64_t n ) const {
+      IT const * P = index<IT>(SB_PTR);
+      SPARSETOOL_ASSERT(
+        P[0] == 0 && uint64_t(P[n]) == h.nnz,
+        "SparseBinary: file `" << name << "' pointers must go from 0 to nnz = " << h.nnz
+      )
+      for ( uint64_t k = 0; k < n; ++k )
+        SPARSETOOL_ASSERT(
+          P[k] <= P[k+1],
+          "SparseBinary: file `" << name << "' decreasing pointers at " << k
+        )
+    }
+
+    // indices in [base,base+n)
+    template <typename IT>
+    void
+    check_indices( int slot, uint64_t base, uint64_t n ) const {
+      IT const * K = index<IT>(slot);
+      for ( uint64_t k = 0; k < h.nnz; ++k )
+        SPARSETOOL_ASSERT(
+          uint64_t(K[k]) >= base && uint64_t(K[k]) < base+n,
+          "SparseBinary: file `" << name << "' index " << K[k] <<
+          " out of range in array " << slot << " at " << k
+        )
+    }
+
+    template <typename IT>
+    void
+    check_arrays( uint64_t np ) const {
+      uint64_t base = (h.flags & SB_FORTRAN) != 0 ? 1 : 0;
+      if ( np > 0 )               check_pointers<IT>( np-1 );
+      if ( h.storage != SB_CROW ) check_indices<IT>( SB_ROW, base, h.nRows );
+      if ( h.storage != SB_CCOL ) check_indices<IT>( SB_COL, base, h.nCols );
+    }
+
+  public:
+
+    explicit
+    SparseBinaryFile( std::string const & fname )
+    : file( fname.c_str() ), name( fname ) {
+      SPARSETOOL_ASSERT(
+        file.size() >= sizeof(SparseBinaryHeader),
+        "SparseBinary: file `" << name << "' too short"
+      )
+      memcpy( &h, file.begin(), sizeof(SparseBinaryHeader) );
+      SPARSETOOL_ASSERT(
+        strncmp( h.magic, "SPTLBIN", 8 ) == 0,
+        "SparseBinary: file `" << name << "' is not a binary sparse matrix"
+      )
+      SPARSETOOL_ASSERT(
+        h.version >= 1 && h.version <= SB_VERSION,
+        "SparseBinary: file `" << name << "' version " << h.version <<
+        " not supported (max " << SB_VERSION << ")"
+      )
+      SPARSETOOL_ASSERT(
+        h.endian == SB_ENDIAN,
+        "SparseBinary: file `" << name << "' written with a different byte order"
+      )
+      SPARSETOOL_ASSERT(
+        h.storage <= SB_COO && ( h.indexBytes == 4 || h.indexBytes == 8 ),
+        "SparseBinary: file `" << name << "' bad storage or index width"
+      )
+      SPARSETOOL_ASSERT(
+        sb_bytes( h.valueCode ) != 0 && h.valueBytes == sb_bytes( h.valueCode ),
+        "SparseBinary: file `" << name << "' value type " << h.valueCode <<
+        " of " << h.valueBytes << " bytes not supported"
+      )
+      SPARSETOOL_ASSERT(
+        h.nRows < ~uint64_t(0) && h.nCols < ~uint64_t(0),
+        "SparseBinary: file `" << name << "' bad dimensions"
+      )
+      uint64_t np = 0;
+      switch ( h.storage ) {
+        case SB_CROW:  np = h.nRows+1; break;
+        case SB_CCOL:  np = h.nCols+1; break;
+        case SB_CCOOR: np = h.offset[SB_PTR] != 0 ? h.nCols+1 : 0; break;
+      }
+      if ( np > 0 )              check_array( SB_PTR, np, h.indexBytes );
+      if ( h.storage != SB_CROW ) check_array( SB_ROW, h.nnz, h.indexBytes );
+      if ( h.storage != SB_CCOL ) check_array( SB_COL, h.nnz, h.indexBytes );
+      check_array( SB_VAL, h.nnz, h.valueBytes );
+      if ( h.indexBytes == 4 ) check_arrays<uint32_t>( np );
+      else                     check_arrays<uint64_t>( np );
+    }
+
+    SparseBinaryHeader const & header() const { return h; }
+    std::string        const & fileName() const { return name; }
+
+    bool ordered() const { return (h.flags & SB_ORDERED) != 0; }
+    bool hasArray( int slot ) const { return h.offset[slot] != 0; }
+
+    void
+    require( SparseBinaryStorage s, uint64_t maxIndex, char const who[] ) const {
+      SPARSETOOL_ASSERT(
+        h.storage == uint32_t(s),
+        "SparseBinary: file `" << name << "' stores storage " << h.storage <<
+        " cannot be loaded in a " << who
+      )
+      SPARSETOOL_ASSERT(
+        h.nRows <= maxIndex && h.nCols <= maxIndex && h.nnz <= maxIndex,
+        "SparseBinary: file `" << name << "' too large for the indices of a " << who
+      )
+    }
+
+
+    // the values as T: in place if the type match, else converted in buf
+    template <typename T>
+    T const *
+    values( std::vector<T> & buf ) const {
+      void const * p = file.begin() + h.offset[SB_VAL];
+      if ( h.valueCode == sb_code<T>::value && h.valueBytes == sizeof(T) )
+        return static_cast<T const *>(p);
+      switch ( h.valueCode ) {
+        case 1: sb_convert<T,int>( p, h.nnz, buf );                  break;
+        case 2: sb_convert<T,float>( p, h.nnz, buf );                break;
+        case 3: sb_convert<T,double>( p, h.nnz, buf );               break;
+        case 4: sb_convert<T,std::complex<float> >( p, h.nnz, buf );  break;
+        case 5: sb_convert<T,std::complex<double> >( p, h.nnz, buf ); break;
+        default:
+          SPARSETOOL_ERR(
+            "SparseBinary: file `" << name << "' unknown value type " << h.valueCode
+          )
+      }
+      return buf.empty() ? nullptr : &buf.front();
+    }
+  };
+
+  // header and arrays of a file to be written
+  class SparseBinaryWriter {
+    SparseBinaryHeader h;
+    void const *       data[4];
+
+  public:
+
+    SparseBinaryWriter(
+      SparseBinaryStorage s,
+      uint32_t            indexBytes,
+      uint32_t            valueCode,
+      uint32_t            valueBytes,
+      uint64_t            nr,
+      uint64_t            nc,
+      uint64_t            nnz,
+      uint32_t            flags
+    ) {
+      memset( &h, 0, sizeof(h) );
+      memcpy( h.magic, "SPTLBIN", 8 );
+      h.version    = SB_VERSION;
+      h.endian     = SB_ENDIAN;
+      h.storage    = uint32_t(s);
+      h.indexBytes = indexBytes;
+      h.valueCode  = valueCode;
+      h.valueBytes = valueBytes;
+      h.flags      = flags;
+      h.nRows      = nr;
+      h.nCols      = nc;
+      h.nnz        = nnz;
+      for ( int k = 0; k < 4; ++k ) data[k] = nullptr;
+    }
+
+    void
+    counts( uint64_t lower, uint64_t diag, uint64_t upper )
+    { h.nLower = lower; h.nDiag = diag; h.nUpper = upper; }
+
+    void
+    array( int slot, void const * p, uint64_t len )
+    { data[slot] = p; h.length[slot] = len; h.offset[slot] = 1; }
+
+    void
+    write( std::string const & fname ) {
+      uint64_t pos = sizeof(h);
+      for ( int k = 0; k < 4; ++k ) {
+        if ( h.offset[k] == 0 ) continue;
+        pos = (pos + SB_ALIGN - 1) / SB_ALIGN * SB_ALIGN;
+        h.offset[k] = pos;
+        pos += h.length[k] * ( k == SB_VAL ? h.valueBytes : h.indexBytes );
+      }
+      ofstream file( fname.c_str(), std::ios::binary );
+      SPARSETOOL_ASSERT( file.is_open(), "SparseBinary: cannot open `" << fname << "' for writing" )
+      file.write( reinterpret_cast<char const *>(&h), sizeof(h) );
+      char const zeros[SB_ALIGN] = {0};
+      pos = sizeof(h);
+      for ( int k = 0; k < 4; ++k ) {
+        if ( h.offset[k] == 0 ) continue;
+        file.write( zeros, std::streamsize(h.offset[k] - pos) );
+        uint64_t bytes = h.length[k] * ( k == SB_VAL ? h.valueBytes : h.indexBytes );
+        if ( bytes > 0 ) file.write( static_cast<char const *>(data[k]), std::streamsize(bytes) );
+        pos = h.offset[k] + bytes;
+      }
+      SPARSETOOL_ASSERT( file.good(), "SparseBinary: error writing `" << fname << "'" )
+    }
+  };
+
+  template <typename T, typename M>
+  inline
+  void
+  sb_counts( SparseBinaryWriter & w, Sparse<T,M> const & A ) {
+    indexType lower, diag, upper;
+    A.nnz( lower, diag, upper );
+    w.counts( lower, diag, upper );
+  }
+
+  template <typename T>
+  inline
+  T const *
+  sb_front( Vector<T> const & v )
+  { return v.empty() ? nullptr : &v.front(); }
+
+  template <typename T, typename IT>
+  inline
+  void
+  sb_load( SparseBinaryFile const & f, CRowMatrix<T> & A, IT const * ) {
+    SparseBinaryHeader const & h = f.header();
+    std::vector<T> buf;
+    A.load( indexType(h.nRows), indexType(h.nCols),
+            f.index<IT>(SB_PTR), f.index<IT>(SB_COL), f.values(buf), f.ordered() );
+  }
+
+  template <typename T, typename IT>
+  inline
+  void
+  sb_load( SparseBinaryFile const & f, CColMatrix<T> & A, IT const * ) {
+    SparseBinaryHeader const & h = f.header();
+    std::vector<T> buf;
+    A.load( indexType(h.nRows), indexType(h.nCols),
+            f.index<IT>(SB_PTR), f.index<IT>(SB_ROW), f.values(buf), f.ordered() );
+  }
+
+  template <typename T, typename IT>
+  inline
+  void
+  sb_load( SparseBinaryFile const & f, CCoorMatrix<T> & A, IT const * ) {
+    SparseBinaryHeader const & h = f.header();
+    std::vector<T> buf;
+    A.load( indexType(h.nRows), indexType(h.nCols), indexType(h.nnz),
+            f.index<IT>(SB_ROW), f.index<IT>(SB_COL), f.values(buf), f.ordered() );
+  }
+
+  template <typename T, typename IT>
+  inline
+  void
+  sb_load( SparseBinaryFile const & f, lapack_wrapper::SparseCCOOR<T> & A, IT const * ) {
+    typedef lapack_wrapper::integer integer;
+    SparseBinaryHeader const & h = f.header();
+    std::vector<T> buf;
+    T const * V  = f.values(buf);
+    integer   nr = integer(h.nRows);
+    integer   nc = integer(h.nCols);
+    integer   nz = integer(h.nnz);
+    bool      fi = (h.flags & SB_FORTRAN) != 0;
+    if ( (h.flags & SB_FULL) != 0 ) {
+      if ( (h.flags & SB_ROW_MAJOR) != 0 ) A.setup_as_full_row_major( nr, nc, fi );
+      else                                 A.setup_as_full_column_major( nr, nc, fi );
+      if ( nz > 0 ) A.fill( V, nz );
+      return;
+    }
+    IT const * R = f.index<IT>(SB_ROW);
+    IT const * C = f.index<IT>(SB_COL);
+    A.init( nr, nc, nz, fi );
+    if ( fi ) for ( integer k = 0; k < nz; ++k ) A.push_value_F( integer(R[k]), integer(C[k]), V[k] );
+    else      for ( integer k = 0; k < nz; ++k ) A.push_value_C( integer(R[k]), integer(C[k]), V[k] );
+  }
+
+  template <typename MAT>
+  inline
+  void
+  sb_load( SparseBinaryFile const & f, MAT & A ) {
+    if ( f.header().indexBytes == 4 ) sb_load( f, A, static_cast<uint32_t const *>(nullptr) );
+    else                              sb_load( f, A, static_cast<uint64_t const *>(nullptr) );
+  }
+
+  /*! \endcond */
+
+  /*!
+   *  Save a compressed row matrix to a file in binary format
+   *  \param fname the name of the file to save
+   *  \param A     sparse matrix to save
+   */
+  template <typename T>
+  static
+  void
+  SparseBinarySaveToFile( std::string const & fname, CRowMatrix<T> const & A ) {
+    SparseBinaryWriter w(
+      SB_CROW, sizeof(indexType), sb_code<T>::value, sizeof(T),
+      A.numRows(), A.numCols(), A.nnz(), A.isOrdered() ? SB_ORDERED : 0
+    );
+    sb_counts( w, A );
+    w.array( SB_PTR, sb_front(A.getR()), A.numRows()+1 );
+    w.array( SB_COL, sb_front(A.getJ()), A.nnz() );
+    w.array( SB_VAL, sb_front(A.getA()), A.nnz() );
+    w.write( fname );
+  }
+
+  /*!
+   *  Save a compressed column matrix to a file in binary format
+   *  \param fname the name of the file to save
+   *  \param A     sparse matrix to save
+   */
+  template <typename T>
+  static
+  void
+  SparseBinarySaveToFile( std::string const & fname, CColMatrix<T> const & A ) {
+    SparseBinaryWriter w(
+      SB_CCOL, sizeof(indexType), sb_code<T>::value, sizeof(T),
+      A.numRows(), A.numCols(), A.nnz(), A.isOrdered() ? SB_ORDERED : 0
+    );
+    sb_counts( w, A );
+    w.array( SB_PTR, sb_front(A.getC()), A.numCols()+1 );
+    w.array( SB_ROW, sb_front(A.getI()), A.nnz() );
+    w.array( SB_VAL, sb_front(A.getA()), A.nnz() );
+    w.write( fname );
+  }
+
+  /*!
+   *  Save a compressed coordinate matrix to a file in binary format,
+   *  the column pointers are saved only if the matrix is ordered
+   *  \param fname the name of the file to save
+   *  \param A     sparse matrix to save
+   */
+  template <typename T>
+  static
+  void
+  SparseBinarySaveToFile( std::string const & fname, CCoorMatrix<T> const & A ) {
+    SparseBinaryWriter w(
+      SB_CCOOR, sizeof(indexType), sb_code<T>::value, sizeof(T),
+      A.numRows(), A.numCols(), A.nnz(), A.isOrdered() ? SB_ORDERED : 0
+    );
+    sb_counts( w, A );
+    if ( A.isOrdered() ) w.array( SB_PTR, sb_front(A.getC()), A.numCols()+1 );
+    w.array( SB_ROW, sb_front(A.getI()), A.nnz() );
+    w.array( SB_COL, sb_front(A.getJ()), A.nnz() );
+    w.array( SB_VAL, sb_front(A.getA()), A.nnz() );
+    w.write( fname );
+  }
+
+  /*!
+   *  Save a \c lapack_wrapper::SparseCCOOR matrix to a file in binary
+   *  format, with its indexing (C or FORTRAN) and full storage flags
+   *  \param fname the name of the file to save
+   *  \param A     sparse matrix to save
+   */
+  template <typename T>
+  static
+  void
+  SparseBinarySaveToFile(
+    std::string                    const & fname,
+    lapack_wrapper::SparseCCOOR<T> const & A
+  ) {
+    typedef lapack_wrapper::integer integer;
+    uint32_t flags = 0;
+    if ( A.FORTRAN_indexing() ) flags |= SB_FORTRAN;
+    if ( A.is_full() )          flags |= SB_FULL;
+    if ( A.is_row_major() )     flags |= SB_ROW_MAJOR;
+    uint64_t nnz = uint64_t(A.get_nnz());
+    SparseBinaryWriter w(
+      SB_COO, sizeof(integer), sb_code<T>::value, sizeof(T),
+      uint64_t(A.get_number_of_rows()), uint64_t(A.get_number_of_cols()), nnz, flags
+    );
+    integer const * R = nullptr;
+    integer const * C = nullptr;
+    T       const * V = nullptr;
+    if ( nnz > 0 ) A.get_data( R, C, V );
+    w.array( SB_ROW, R, nnz );
+    w.array( SB_COL, C, nnz );
+    w.array( SB_VAL, V, nnz );
+    w.write( fname );
+  }
+
+  /*!
+   *  Load a compressed row matrix from a file in binary format,
+   *  indices and values are converted if stored with other types
+   *  \param fname the name of the file to load
+   *  \param A     the matrix
+   */
+  template <typename T>
+  static
+  void
+  SparseBinaryLoadFromFile( std::string const & fname, CRowMatrix<T> & A ) {
+    SparseBinaryFile f( fname );
+    f.require( SB_CROW, indexType(-1), "CRowMatrix" );
+    sb_load( f, A );
+  }
+
+  /*!
+   *  Load a compressed column matrix from a file in binary format,
+   *  indices and values are converted if stored with other types
+   *  \param fname the name of the file to load
+   *  \param A     the matrix
+   */
+  template <typename T>
+  static
+  void
+  SparseBinaryLoadFromFile( std::string const & fname, CColMatrix<T> & A ) {
+    SparseBinaryFile f( fname );
+    f.require( SB_CCOL, indexType(-1), "CColMatrix" );
+    sb_load( f, A );
+  }
+
+  /*!
+   *  Load a compressed coordinate matrix from a file in binary format,
+   *  indices and values are converted if stored with other types
+   *  \param fname the name of the file to load
+   *  \param A     the matrix
+   */
+  template <typename T>
+  static
+  void
+  SparseBinaryLoadFromFile( std::string const & fname, CCoorMatrix<T> & A ) {
+    SparseBinaryFile f( fname );
+    f.require( SB_CCOOR, indexType(-1), "CCoorMatrix" );
+    sb_load( f, A );
+  }
+
+  /*!
+   *  Load a \c lapack_wrapper::SparseCCOOR matrix from a file in binary
+   *  format, with the indexing and storage it was saved with
+   *  \param fname the name of the file to load
+   *  \param A     the matrix
+   */
+  template <typename T>
+  static
+  void
+  SparseBinaryLoadFromFile(
+    std::string              const & fname,
+    lapack_wrapper::SparseCCOOR<T> & A
+  ) {
+    SparseBinaryFile f( fname );
+    f.require(
+      SB_COO, uint64_t(std::numeric_limits<lapack_wrapper::integer>::max()), "SparseCCOOR"
+    );
+    sb_load( f, A );
+  }
+
+  /*
+  //  #     #
+  //  #     # # ###### #    #
+  //  #     # # #      #    #
+  //  #     # # #####  #    #
+  //   #   #  # #      # ## #
+  //    # #   # #      ##  ##
+  //     #    # ###### #    #
+  */
+
+  /*!
+   *  Read only sparse matrix using in place the arrays of a file in
+   *  binary format (saved from \c CRowMatrix, \c CColMatrix or an
+   *  ordered \c CCoorMatrix): the file is memory mapped and nothing is
+   *  copied.  Opening reads the pointers and the indices once to check
+   *  that they are consistent, the values are read on first use.
+   *  The indices and values must be stored as
+   *  \c indexType and \c T, otherwise use \c SparseBinaryLoadFromFile.
+   *
+   *  The view supports the iterator, the random access to the elements
+   *  and the products \c A*x and \c A^x.
+   */
+  template <typename T>
+  class SparseBinaryView : public Sparse<T,SparseBinaryView<T> > {
+    typedef SparseBinaryView<T> MATRIX;
+    typedef Sparse<T,MATRIX>    SPARSE;
+  public:
+    typedef T valueType; //!< the type of the elements of the matrix
+
+  private:
+
+    SparseBinaryFile * file;
+    uint32_t           storage;
+
+    indexType const * P; // compressed pointers
+    indexType const * I; // row indices
+    indexType const * J; // column indices
+    valueType const * A; // values
+    valueType         zero;
+
+    mutable indexType iter_idx; // row or column of the iterator
+    mutable indexType iter_ptr;
+
+    SparseBinaryView( SparseBinaryView const & );
+    SparseBinaryView & operator = ( SparseBinaryView const & );
+
+  public:
+
+    //! Empty view, see \c open
+    SparseBinaryView(void)
+    : file(nullptr), storage(SB_CROW), P(nullptr), I(nullptr), J(nullptr), A(nullptr), zero(0)
+    { SPARSE::setup(0,0); }
+
+    //! View of the matrix stored in the file \c fname
+    explicit
+    SparseBinaryView( std::string const & fname )
+    : file(nullptr), storage(SB_CROW), P(nullptr), I(nullptr), J(nullptr), A(nullptr), zero(0)
+    { open( fname ); }
+
+    ~SparseBinaryView() { close(); }
+
+    //! Map the file \c fname and set up the view on its arrays
+    void
+    open( std::string const & fname ) {
+      close();
+      file = new SparseBinaryFile( fname );
+      SparseBinaryHeader const & h = file->header();
+      SPARSETOOL_ASSERT(
+        h.storage != SB_COO,
+        "SparseBinaryView: file `" << fname << "' stores a SparseCCOOR, use SparseBinaryLoadFromFile"
+      )
+      SPARSETOOL_ASSERT(
+        h.indexBytes == sizeof(indexType) &&
+        h.valueCode  == sb_code<T>::value &&
+        h.valueBytes == sizeof(T),
+        "SparseBinaryView: file `" << fname << "' index or value type differ, use SparseBinaryLoadFromFile"
+      )
+      SPARSETOOL_ASSERT(
+        file->ordered() && ( h.storage != SB_CCOOR || file->hasArray(SB_PTR) ),
+        "SparseBinaryView: file `" << fname << "' stores an unordered matrix"
+      )
+      file->require( SparseBinaryStorage(h.storage), indexType(-1), "SparseBinaryView" );
+      storage = h.storage;
+      SPARSE::setup( indexType(h.nRows), indexType(h.nCols) );
+      SPARSE::sp_nnz       = indexType(h.nnz);
+      SPARSE::sp_lower_nnz = indexType(h.nLower);
+      SPARSE::sp_diag_nnz  = indexType(h.nDiag);
+      SPARSE::sp_upper_nnz = indexType(h.nUpper);
+      P = file->hasArray(SB_PTR) ? file->index<indexType>(SB_PTR) : nullptr;
+      I = file->hasArray(SB_ROW) ? file->index<indexType>(SB_ROW) : nullptr;
+      J = file->hasArray(SB_COL) ? file->index<indexType>(SB_COL) : nullptr;
+      std::vector<T> unused;
+      A = file->values( unused );
+    }
+
+    //! Unmap the file, the view becomes empty
+    void
+    close() {
+      delete file;
+      file = nullptr;
+      P = I = J = nullptr;
+      A = nullptr;
+      SPARSE::setup(0,0);
+    }
+
+    //! Storage of the viewed file
+    SparseBinaryStorage getStorage() const { return SparseBinaryStorage(storage); }
+
+    //! Return the position of the element \c (i,j) in the vector storing elements
+    indexType
+    position( indexType i, indexType j ) const {
+      SPARSE::test_index(i,j);
+      indexType lo, hi, key;
+      indexType const * K;
+      if ( storage == SB_CROW ) { lo = P[i]; hi = P[i+1]; K = J; key = j; }
+      else                      { lo = P[j]; hi = P[j+1]; K = I; key = i; }
+      indexType const * p = std::lower_bound( K+lo, K+hi, key );
+      if ( p == K+hi || *p != key ) return SPARSE::sp_nnz;
+      return indexType(p-K);
+    }
+
+    valueType const &
+    operator () ( indexType i, indexType j ) const {
+      indexType pos = position(i,j);
+      SPARSETOOL_TEST(
+        pos != SPARSE::sp_nnz,
+        "SparseBinaryView(" << i << "," << j << ") referring to a non existent element"
+      )
+      return A[pos];
+    }
+
+    valueType const &
+    value( indexType i, indexType j ) const {
+      indexType pos = position(i,j);
+      return pos == SPARSE::sp_nnz ? zero : A[pos];
+    }
+
+    bool
+    exists( indexType i, indexType j ) const
+    { return position(i,j) != SPARSE::sp_nnz; }
+
+    valueType const &
+    operator [] ( indexType idx ) const
+    { SPARSE::test_nnz(idx); return A[idx]; }
+
+    // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+    // ITERATOR
+    void
+    Begin(void) const {
+      iter_idx = iter_ptr = 0;
+      if ( storage != SB_CCOOR && SPARSE::sp_nnz > 0 ) while ( P[iter_idx+1] == 0 ) ++iter_idx;
+    }
+
+    void
+    Next(void) const {
+      ++iter_ptr;
+      if ( storage != SB_CCOOR && iter_ptr < SPARSE::sp_nnz )
+        while ( iter_ptr >= P[iter_idx+1] ) ++iter_idx;
+    }
+
+    bool End(void) const { return iter_ptr < SPARSE::sp_nnz; }
+
+    indexType
+    row(void) const
+    { return storage == SB_CROW ? iter_idx : I[iter_ptr]; }
+
+    indexType
+    column(void) const
+    { return storage == SB_CCOL ? iter_idx : J[iter_ptr]; }
+
+    valueType const & value(void) const { return A[iter_ptr]; }
+
+    //! Assign the pointed element to \c rhs
+    template <typename TS>
+    void assign( TS & rhs ) const { rhs = A[iter_ptr]; }
+
+    //! perform the operation res += s * (A * x)
+    template <typename VRES, typename VB> inline
+    void
+    add_S_mul_M_mul_V(
+      VectorBase<T,VRES>     & res,
+      T const                & s,
+      VectorBase<T,VB> const & x
+    ) const {
+      SPARSETOOL_TEST( (void*)&res != (void*)&x, "SparseBinaryView M_mul_V equal pointer" )
+      switch ( storage ) {
+        case SB_CROW:
+          for ( indexType i = 0; i < SPARSE::sp_nrows; ++i ) {
+            T bf(0);
+            for ( indexType k = P[i]; k < P[i+1]; ++k ) bf += A[k] * x(J[k]);
+            res(i) += s * bf;
+          }
+          break;
+        case SB_CCOL:
+          for ( indexType j = 0; j < SPARSE::sp_ncols; ++j ) {
+            T xj = s * x(j);
+            for ( indexType k = P[j]; k < P[j+1]; ++k ) res(I[k]) += A[k] * xj;
+          }
+          break;
+        default:
+          for ( indexType k = 0; k < SPARSE::sp_nnz; ++k ) res(I[k]) += s * A[k] * x(J[k]);
+          break;
+      }
+    }
+
+    //! perform the operation res += s * (A ^ x)
+    template <typename VRES, typename VB> inline
+    void
+    add_S_mul_Mt_mul_V(
+      VectorBase<T,VRES>     & res,
+      T const                & s,
+      VectorBase<T,VB> const & x
+    ) const {
+      SPARSETOOL_TEST( (void*)&res != (void*)&x, "SparseBinaryView Mt_mul_V equal pointer" )
+      switch ( storage ) {
+        case SB_CROW:
+          for ( indexType i = 0; i < SPARSE::sp_nrows; ++i ) {
+            T xi = s * x(i);
+            for ( indexType k = P[i]; k < P[i+1]; ++k ) res(J[k]) += A[k] * xi;
+          }
+          break;
+        case SB_CCOL:
+          for ( indexType j = 0; j < SPARSE::sp_ncols; ++j ) {
+            T bf(0);
+            for ( indexType k = P[j]; k < P[j+1]; ++k ) bf += A[k] * x(I[k]);
+            res(j) += s * bf;
+          }
+          break;
+        default:
+          for ( indexType k = 0; k < SPARSE::sp_nnz; ++k ) res(J[k]) += s * A[k] * x(I[k]);
+          break;
+      }
+    }
+
+  };
+
+  /*! \cond NODOC */
+  SPARSELIB_MUL_STRUCTURES(SparseBinaryView)
+  /*! \endcond */
+
+}
+
+namespace SparseToolLoad {
+
+  using ::SparseTool::SparseBinaryStorage;
+  using ::SparseTool::SparseBinarySaveToFile;
+  using ::SparseTool::SparseBinaryLoadFromFile;
+  using ::SparseTool::SparseBinaryView;
+
+  using ::SparseTool::SB_CROW;
+  using ::SparseTool::SB_CCOL;
+  using ::SparseTool::SB_CCOOR;
+  using ::SparseTool::SB_COO;
+
+}
+
+#endif
+
+/*
+// ####### ####### #######
+// #       #     # #
+// #       #     # #
+// #####   #     # #####
+// #       #     # #
+// #       #     # #
+// ####### ####### #
+*/
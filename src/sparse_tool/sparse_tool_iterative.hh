@@ -19,14 +19,39 @@
   - \c IdPreconditioner\<T\> which implements the identity preconditioner.
   - \c Dpreconditioner\<T\> which implements the diagonal preconditioner.
   - \c ILDUpreconditioner\<T\> which implement an incomplete \a LDU preconditioner.
+       With \c setNumThreads(nt) the triangular solves are level scheduled
+       and run on \c nt threads (also \c RILDUpreconditioner and
+       \c ILDUKpreconditioner).
+  - \c ICpreconditioner\<T\> which implements the incomplete Cholesky
+       \c IC(0) and \c IC(k) preconditioner for SPD matrices.
+  - \c AMGpreconditioner\<T\> which implements a smoothed aggregation
+       algebraic multigrid V-cycle.
+  - \c SchwarzPreconditioner\<T\> which implements the overlapping
+       additive Schwarz (block Jacobi) preconditioner, the local blocks
+       are factored and solved concurrently.
+  - \c SPAIpreconditioner\<T\> and \c FSAIpreconditioner\<T\> which
+       implement the sparse approximate inverse (general matrices) and
+       its factorized form (SPD matrices), applied by matrix-vector
+       products only.
 
   A set of template iterative solvers are available:
   
   - \c cg implementing the cojugate gradient solver
+  - \c cg_pipelined implementing the pipelined cojugate gradient solver
+        of Ghysels-Vanroose (one fused vector sweep per iteration)
   - \c bicgstab implementing the Bi-conjugate stabilized 
         solver of Van Der Vorst.
   - \c gmres implementing generalized minimal residual 
        of Saad-Shultz
+  - \c gmres_sstep implementing the s-step (communication avoiding)
+       generalized minimal residual with block orthogonalization
+       done by \c lapack_wrapper
+  - \c fgmres implementing the flexible (right preconditioned)
+       generalized minimal residual, the preconditioner may be
+       a variable operator, e.g. an inner iterative solver
+  - \c gcrodr implementing GCRO-DR, the restarted minimal residual
+       with deflated restarting which keeps a recycle subspace
+       between the solves of a sequence of related systems
 */
 
 /*!
@@ -49,6 +74,10 @@
   double residual = bicgstab(A, b, x, P, tolerance, maxIter, iter);
 
   double residual = gmres(A, b, x, P, tolerance, maxSubIter, maxIter, iter);
+
+  // repeated solves of the same size: temporaries allocated only once
+  GmresWorkspace<double> ws;
+  double residual = gmres(A, b, x, P, tolerance, maxSubIter, maxIter, iter, ws);
 \endcode
 
   In the example
@@ -63,19 +92,28 @@
   - \c maxIter : is the maximum number of allowable iterations;
   - \c iter : is the number of iterations done;
   - \c residual : the residual of the approximated solution;
+  - \c ws : optional workspace (\c CgWorkspace, \c CgPipelinedWorkspace,
+    \c BicgstabWorkspace, \c GmresWorkspace, \c GmresSstepWorkspace,
+    \c CocgWorkspace, \c CocrWorkspace) holding the temporary vectors of the solver.
 */
 
 #ifndef SPARSETOOL_ITERATIVE_HH
 #define SPARSETOOL_ITERATIVE_HH
 
 #include "sparse_tool.hh"
+#include "../lapack_wrapper/lapack_wrapper++.hh"
 #include <iostream>
 
 #include "preconditioner/id.hxx"
 #include "preconditioner/diag.hxx"
+#include "preconditioner/ldu_levels.hxx"
+#include "preconditioner/scratch.hxx"
 #include "preconditioner/ildu.hxx"
 #include "preconditioner/rildu.hxx"
 #include "preconditioner/ilduk.hxx"
+#include "preconditioner/ilut.hxx"
+#include "preconditioner/ic.hxx"
+#include "preconditioner/multicolor.hxx"
 #include "preconditioner/sor.hxx"
 #include "preconditioner/ssor.hxx"
 #include "preconditioner/cssor.hxx"
@@ -86,10 +124,19 @@
 #include "preconditioner/hss_opoly.hxx"
 #include "preconditioner/hss_opoly_ssor.hxx"
 #include "preconditioner/hss_chebyshev.hxx"
+#include "preconditioner/amg.hxx"
+#include "preconditioner/schwarz.hxx"
+#include "preconditioner/apinv_pattern.hxx"
+#include "preconditioner/spai.hxx"
+#include "preconditioner/fsai.hxx"
 
 #include "iterative/cg.hxx"
+#include "iterative/cg_pipelined.hxx"
 #include "iterative/cg_poly.hxx"
 #include "iterative/gmres.hxx"
+#include "iterative/gmres_sstep.hxx"
+#include "iterative/fgmres.hxx"
+#include "iterative/gcrodr.hxx"
 #include "iterative/bicgstab.hxx"
 #include "iterative/cocg.hxx"
 #include "iterative/cocr.hxx"
@@ -123,6 +170,9 @@ namespace SparseTool {
     RILDUpreconditioner<valueType> P;
     CRowMatrix<valueType>          Mat;
 
+    // work vectors q, r
+    PrecoScratch<Vector<Vector<valueType> > > scratch;
+
     //! build incomplete LDU decomposition with specified pattern \c P
     template <typename MAT, typename PAT>
     void
@@ -130,8 +180,11 @@ namespace SparseTool {
       maxIter = iter;
       P.build(A,PT);
       Mat = A;
-      //q.resize(A.numRows());
-      //r.resize(A.numRows());
+      PRECO::pr_size = A.numRows();
+      Vector<Vector<valueType> > & ws = scratch.setup();
+      ws.resize(2);
+      ws(0).resize(A.numRows());
+      ws(1).resize(A.numRows());
     }
 
   public:
@@ -158,11 +211,19 @@ namespace SparseTool {
     build( MAT const & _M, PRE const & _P, indexType _iter )
     { build_ILDUiter(_M,_P,_iter); }
 
+    //! concurrent \c assPreco on this object, each with its own work vectors
+    void setThreadSafe( bool yes ) { scratch.setThreadSafe(yes); }
+
+    //! \c true if \c assPreco can be called concurrently
+    bool isThreadSafe() const { return scratch.isThreadSafe(); }
+
     //! apply preconditioner to vector \c v and store result to vector \c res
     template <typename VECTOR>
     void
     assPreco( VECTOR & x, VECTOR const & b ) const {
-      VECTOR q(b.size()), r(x.size());
+      typename PrecoScratch<Vector<Vector<valueType> > >::Lease ws( scratch );
+      Vector<valueType> & q = (*ws)(0);
+      Vector<valueType> & r = (*ws)(1);
       x = b;
       for ( indexType i = 0; i < maxIter; ++i ) {
         r = b-Mat*x;
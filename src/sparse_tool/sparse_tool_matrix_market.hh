@@ -18,9 +18,20 @@
 #define SPARSETOOL_MATRIX_MARKET_HH
 
 #include <string.h>
+#include <stdlib.h>
+#include <sstream>
+#include <thread>
+
+#include "sparse_tool.hh"
 
 #if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
   #define sscanf sscanf_s
+#else
+  #define SPARSETOOL_MM_MMAP
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
 #endif
 
 namespace SparseTool {
@@ -64,6 +75,343 @@ namespace SparseTool {
   static char const MM_HEADER[] = "% Generated with saveToMatrixMarket of toolkit SparseTool\n"
                                   "% by Enrico Bertolazzi\n"
                                   "%--------------------------------------------------------\n";
+
+  // read only view of a whole file, memory mapped where available
+  class MappedFile {
+    char const *      ptr;
+    size_t            len;
+    std::vector<char> buffer;
+    #ifdef SPARSETOOL_MM_MMAP
+    void *            map;
+    #endif
+
+    MappedFile( MappedFile const & );
+    MappedFile & operator = ( MappedFile const & );
+
+  public:
+
+    explicit
+    MappedFile( char const fname[] ) : ptr(nullptr), len(0) {
+      #ifdef SPARSETOOL_MM_MMAP
+      map = MAP_FAILED;
+      int fd = ::open( fname, O_RDONLY );
+      SPARSETOOL_ASSERT( fd >= 0, "MappedFile: cannot open " << fname );
+      struct stat st;
+      if ( ::fstat( fd, &st ) == 0 && st.st_size > 0 ) {
+        len = size_t(st.st_size);
+        map = ::mmap( nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0 );
+      }
+      ::close( fd );
+      if ( map != MAP_FAILED ) {
+        ::madvise( map, len, MADV_SEQUENTIAL );
+        ptr = static_cast<char const*>(map);
+        return;
+      }
+      len = 0;
+      #endif
+      ifstream file( fname, std::ios::binary );
+      SPARSETOOL_ASSERT( file.is_open(), "MappedFile: cannot open " << fname );
+      file.seekg( 0, std::ios::end );
+      buffer.resize( size_t(file.tellg()) );
+      file.seekg( 0, std::ios::beg );
+      if ( !buffer.empty() ) file.read( &buffer.front(), buffer.size() );
+      ptr = buffer.empty() ? nullptr : &buffer.front();
+      len = buffer.size();
+    }
+
+    ~MappedFile() {
+      #ifdef SPARSETOOL_MM_MMAP
+      if ( map != MAP_FAILED ) ::munmap( map, len );
+      #endif
+    }
+
+    char const * begin() const { return ptr; }
+    char const * end()   const { return ptr+len; }
+    size_t       size()  const { return len; }
+  };
+
+  inline bool mm_blank( char c ) { return c == ' ' || c == '\t' || c == '\r'; }
+  inline bool mm_digit( char c ) { return c >= '0' && c <= '9'; }
+
+  // skip blanks, true if the line (or the buffer) ends at p
+  inline
+  bool
+  mm_eol( char const * & p, char const * e ) {
+    while ( p < e && mm_blank(*p) ) ++p;
+    return p == e || *p == '\n';
+  }
+
+  // unsigned index, false if missing or overflowing
+  inline
+  bool
+  mm_index( char const * & p, char const * e, indexType & v ) {
+    while ( p < e && mm_blank(*p) ) ++p;
+    uint64_t a = 0;
+    char const * s = p;
+    while ( p < e && mm_digit(*p) && a <= 0xFFFFFFFFu ) a = 10*a + uint64_t(*p++ - '0');
+    v = indexType(a);
+    return p > s && a <= 0xFFFFFFFFu && ( p == e || !mm_digit(*p) );
+  }
+
+  /*
+  // Floating point number: up to 19 significant digits and a power of
+  // ten up to 22 are converted exactly with one product (Clinger fast
+  // path); anything else, including inf and nan, goes to strtod.
+  */
+  inline
+  bool
+  mm_real( char const * & p, char const * e, double & v ) {
+    static double const p10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    while ( p < e && mm_blank(*p) ) ++p;
+    char const * s = p;
+    bool neg = false;
+    if ( p < e && ( *p == '-' || *p == '+' ) ) neg = *p++ == '-';
+    uint64_t m  = 0;
+    int      nd = 0, ex = 0;
+    bool     ok = false, exact = true;
+    for ( ; p < e && mm_digit(*p); ++p ) {
+      ok = true;
+      if      ( nd < 19 ) { m = 10*m + uint64_t(*p - '0'); if ( m > 0 ) ++nd; }
+      else if ( *p != '0' ) exact = false;
+      else    ++ex;
+    }
+    if ( p < e && *p == '.' )
+      for ( ++p; p < e && mm_digit(*p); ++p ) {
+        ok = true;
+        if ( nd < 19 ) { m = 10*m + uint64_t(*p - '0'); if ( m > 0 ) ++nd; --ex; }
+        else if ( *p != '0' ) exact = false;
+      }
+    if ( ok && p < e && ( *p == 'e' || *p == 'E' ) ) {
+      ++p;
+      bool eneg = false;
+      if ( p < e && ( *p == '-' || *p == '+' ) ) eneg = *p++ == '-';
+      int x = 0;
+      if ( p == e || !mm_digit(*p) ) ok = false;
+      for ( ; p < e && mm_digit(*p); ++p ) if ( x < 10000 ) x = 10*x + (*p - '0');
+      ex += eneg ? -x : x;
+    }
+    if ( ok && exact && m <= (uint64_t(1)<<53) && ex >= -22 && ex <= 22 ) {
+      v = double(m);
+      v = ex < 0 ? v / p10[-ex] : v * p10[ex];
+      if ( neg ) v = -v;
+      return true;
+    }
+    // strtod needs a terminated string
+    p = s;
+    while ( p < e && !mm_blank(*p) && *p != '\n' ) ++p;
+    std::string tok( s, p );
+    char * ep;
+    v = strtod( tok.c_str(), &ep );
+    return ep == tok.c_str() + tok.size() && !tok.empty();
+  }
+
+  template <typename T>
+  inline
+  void
+  mm_assign( double re, double, T & a )
+  { a = T(re); }
+
+  template <typename T>
+  inline
+  void
+  mm_assign( double re, double im, std::complex<T> & a )
+  { a = std::complex<T>(T(re),T(im)); }
+
+  template <typename T>
+  inline
+  T
+  mm_mirror( T const & a, MatrixType mType )
+  { return mType == MM_SKEW_SYMMETRIC ? T(-a) : a; }
+
+  template <typename T>
+  inline
+  std::complex<T>
+  mm_mirror( std::complex<T> const & a, MatrixType mType ) {
+    switch ( mType ) {
+      case MM_SKEW_SYMMETRIC: return -a;
+      case MM_HERMITIAN:      return std::conj(a);
+      default:                break;
+    }
+    return a;
+  }
+
+  template <typename T> inline bool mm_is_complex( T const & )               { return false; }
+  template <typename T> inline bool mm_is_complex( std::complex<T> const & ) { return true; }
+
+  // start of the line after the one containing p
+  inline
+  char const *
+  mm_next_line( char const * p, char const * e ) {
+    char const * q = p < e ? static_cast<char const*>(memchr( p, '\n', size_t(e-p) )) : nullptr;
+    return q == nullptr ? e : q+1;
+  }
+
+  // entry "i j re [im]" of the line [p,e), zero based indices
+  inline
+  bool
+  mm_entry(
+    char const * p,
+    char const * e,
+    indexType    nr,
+    indexType    nc,
+    bool         cpx,
+    indexType &  i,
+    indexType &  j,
+    double    &  re,
+    double    &  im
+  ) {
+    im = 0;
+    bool ok = mm_index( p, e, i ) && mm_index( p, e, j ) &&
+              i > 0 && i <= nr && j > 0 && j <= nc &&
+              mm_real( p, e, re ) && ( !cpx || mm_real( p, e, im ) ) &&
+              mm_eol( p, e );
+    --i; --j;
+    return ok;
+  }
+
+  // error state of a block SOURCE at the end of the text: a source with
+  // get_zerr (zstream::gzip_block_reader) must end with Z_OK (0) or
+  // Z_STREAM_END (1), otherwise its blocks were cut by a bad crc or a
+  // truncated file; sources without get_zerr never fail
+  template <typename SOURCE>
+  inline
+  auto
+  mm_source_error( SOURCE const & src, int ) -> decltype( int(src.get_zerr()) ) {
+    int err = src.get_zerr();
+    return err == 0 || err == 1 ? 0 : err;
+  }
+
+  template <typename SOURCE>
+  inline
+  int
+  mm_source_error( SOURCE const &, long )
+  { return 0; }
+
+  // lines of the text pulled by blocks from SOURCE, in place in the
+  // blocks, a line split between two blocks is joined in a copy
+  template <typename SOURCE>
+  class MMBlockLines {
+    SOURCE &     src;
+    char const * p;
+    char const * e;
+    std::string  tail;
+    bool         used; // tail returned by the last call
+    bool         more;
+
+  public:
+
+    explicit
+    MMBlockLines( SOURCE & s )
+    : src(s), p(nullptr), e(nullptr), used(false), more(true) {}
+
+    // next line in [q,qe) with its end of line, valid until the next call
+    bool
+    next( char const * & q, char const * & qe ) {
+      if ( used ) { tail.clear(); used = false; }
+      while ( true ) {
+        if ( p < e ) {
+          char const * r = mm_next_line( p, e );
+          if ( r < e || e[-1] == '\n' ) {
+            if ( tail.empty() ) { q = p; qe = r; p = r; return true; }
+            tail.append( p, r );
+            p = r;
+            break;
+          }
+          tail.append( p, e );
+          p = e;
+        }
+        char const * b = nullptr;
+        size_t       n = 0;
+        more = more && src.next_block( b, n );
+        if ( !more ) break;
+        p = b;
+        e = b+n;
+      }
+      if ( tail.empty() ) return false;
+      q    = tail.data();
+      qe   = q+tail.size();
+      used = true;
+      return true;
+    }
+  };
+
+  // decimal digits of v at p, returns the end
+  inline
+  char *
+  mm_put_uint( char * p, uint64_t v ) {
+    char d[20];
+    int  n = 0;
+    do { d[n++] = char('0'+v%10); v /= 10; } while ( v > 0 );
+    while ( n > 0 ) *p++ = d[--n];
+    return p;
+  }
+
+  // v as m 10^-k with the smallest k such that m/10^k reads back exactly
+  // v (m < 2^53 and 10^k exact, so strtod and the division round the same
+  // rational), "%.17g" for the values without such a short form
+  inline
+  char *
+  mm_put_real( char * p, double v ) {
+    static double const p10[] = {
+      1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,
+      1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+    };
+    double const two53 = 9007199254740992.0;
+    double const a     = std::abs(v);
+    if ( a == 0 ) {
+      if ( std::signbit(v) ) *p++ = '-';
+      *p++ = '0';
+      return p;
+    }
+    if ( a < two53 ) {
+      for ( int k = 0; k < 18; ++k ) {
+        double s = a * p10[k];
+        if ( s >= two53 ) break;
+        double m = std::floor( s + 0.5 );
+        if ( m == 0 || m / p10[k] != a ) continue;
+        char d[20];
+        int  n = 0;
+        for ( uint64_t u = uint64_t(m); u > 0; u /= 10 ) d[n++] = char('0'+u%10);
+        if ( v < 0 ) *p++ = '-';
+        if ( n <= k ) {
+          *p++ = '0'; *p++ = '.';
+          for ( int z = n; z < k; ++z ) *p++ = '0';
+        }
+        while ( n > 0 ) {
+          if ( n == k && p[-1] != '.' ) *p++ = '.';
+          *p++ = d[--n];
+        }
+        return p;
+      }
+    }
+    return p + snprintf( p, 32, "%.17g", v );
+  }
+
+  // "\tvalue" or "\tre\tim" at p, returns the end
+  template <typename T>
+  inline
+  char *
+  mm_put_value( char * p, T const & a ) {
+    *p++ = '\t';
+    return mm_put_real( p, double(a) );
+  }
+
+  template <typename T>
+  inline
+  char *
+  mm_put_value( char * p, std::complex<T> const & a ) {
+    *p++ = '\t';
+    p = mm_put_real( p, double(a.real()) );
+    *p++ = '\t';
+    return mm_put_real( p, double(a.imag()) );
+  }
+
+  // upper bound of the characters of an entry line
+  static size_t const MM_ENTRY_CHARS = 2*21 + 2*33 + 4;
+
   /*! \endcond */
 
   /*!
@@ -253,7 +601,7 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
         );
 
         sp.insert( i, j );
-        if ( mType != MM_GENERAL ) sp.insert( j, i );
+        if ( mType != MM_GENERAL && i != j ) sp.insert( j, i );
       }
 
       sp.internalOrder();
@@ -290,7 +638,7 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
         );
 
         mat.insert(i,j) = a;
-        switch ( mType ) {
+        if ( i != j ) switch ( mType ) {
           case MM_SYMMETRIC:      mat.insert(j,i) =  a; break;
           case MM_SKEW_SYMMETRIC: mat.insert(j,i) = -a; break;
           default: break;
@@ -334,7 +682,7 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
         );
 
         mat.insert(i,j) = std::complex<T>(re,im);
-        switch ( mType ) {
+        if ( i != j ) switch ( mType ) {
           case MM_SYMMETRIC:      mat.insert(j,i) = std::complex<T>(re,im);   break;
           case MM_SKEW_SYMMETRIC: mat.insert(j,i) = std::complex<T>(-re,-im); break;
           case MM_HERMITIAN:      mat.insert(j,i) = std::complex<T>(re,-im);  break;
@@ -381,7 +729,7 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
         );
 
         mat.insert(i,j) = a;
-        switch ( mType ) {
+        if ( i != j ) switch ( mType ) {
           case MM_SYMMETRIC:      mat.insert(j,i) =  a; break;
           case MM_SKEW_SYMMETRIC: mat.insert(j,i) = -a; break;
           default: break;
@@ -485,6 +833,251 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
       file.close();
     }
 
+    /*! \brief
+     *  Read the coordinate file \c fname in \c mat, fast path for large files.
+     *
+     *  The file is memory mapped (read in one block where \c mmap is not
+     *  available) and the lines of the entries are split in \c nThreads
+     *  chunks, parsed concurrently directly in the coordinate arrays of
+     *  \c mat (see \c CCoorMatrix::setNnz).  \c nThreads = 0 (default)
+     *  uses the hardware threads, small files use less threads.
+     */
+    template <typename T>
+    void
+    readFast( char const fname[], CCoorMatrix<T> & mat, unsigned nThreads = 0 ) {
+
+      MappedFile   file( fname );
+      char const * b = file.begin();
+      char const * e = file.end();
+
+      // step 0: the header ends with the line of the sizes
+      char const * p = b;
+      while ( p < e ) {
+        bool comment = *p == '%';
+        p = mm_next_line( p, e );
+        if ( !comment ) break;
+      }
+      {
+        std::istringstream header( std::string( b, p ) );
+        readHeader( header );
+      }
+
+      SPARSETOOL_ASSERT(
+        cType == MM_COORDINATE,
+        "MatrixMarket: file must be a coordinate file!, data is " << *this
+      );
+      SPARSETOOL_ASSERT(
+        vType != MM_PATTERN,
+        "MatrixMarket: try to read a matrix from a pattern only file!, data is " << *this
+      );
+      SPARSETOOL_ASSERT(
+        vType != MM_COMPLEX || mm_is_complex( T(0) ),
+        "MatrixMarket: try to read a complex matrix into a non complex one!, data is " << *this
+      );
+
+      // step 1: chunks of at least 64K at line boundaries
+      size_t body = size_t(e-p);
+      if ( nThreads == 0 ) nThreads = std::thread::hardware_concurrency();
+      if ( nThreads == 0 ) nThreads = 1;
+      if ( nThreads > body/65536+1 ) nThreads = unsigned(body/65536+1);
+
+      std::vector<char const *> cut( nThreads+1 );
+      cut[0]        = p;
+      cut[nThreads] = e;
+      for ( unsigned t = 1; t < nThreads; ++t ) {
+        char const * q = p + (body*t)/nThreads;
+        cut[t] = q <= cut[t-1] ? cut[t-1] : mm_next_line( q-1, e );
+      }
+
+      // step 2: count the entries of each chunk, skip blank and comment lines
+      std::vector<indexType> off( nThreads+1, 0 ), nmirror( nThreads, 0 );
+      parallel_run( nThreads, [&]( indexType t, SweepBarrier & ) {
+        indexType n = 0;
+        for ( char const * q = cut[t]; q < cut[t+1]; q = mm_next_line( q, cut[t+1] ) ) {
+          char const * c = q;
+          if ( !mm_eol( c, cut[t+1] ) && *c != '%' ) ++n;
+        }
+        off[t+1] = n;
+      } );
+      for ( unsigned t = 0; t < nThreads; ++t ) off[t+1] += off[t];
+
+      SPARSETOOL_ASSERT(
+        off[nThreads] == numNnz,
+        "In reading Matrix Market File " << fname << ", found " << off[nThreads] <<
+        " entries, the header declares " << numNnz
+      );
+
+      // step 3: parse, the mirrored entries of a chunk after all the entries of the file
+      bool mirror = mType != MM_GENERAL;
+      bool cpx    = vType == MM_COMPLEX;
+      mat.resize( nRows, nCols, 0 );
+      mat.setNnz( mirror ? 2*numNnz : numNnz );
+      indexType * I = mat.nnz() > 0 ? &mat.getI().front() : nullptr;
+      indexType * J = mat.nnz() > 0 ? &mat.getJ().front() : nullptr;
+      T         * A = &mat.getA().front();
+
+      std::vector<char const *> bad( nThreads, nullptr );
+      parallel_run( nThreads, [&]( indexType t, SweepBarrier & ) {
+        indexType k  = off[t];
+        indexType km = numNnz + off[t];
+        char const * ce = cut[t+1];
+        for ( char const * q = cut[t]; q < ce; q = mm_next_line( q, ce ) ) {
+          char const * c = q;
+          if ( mm_eol( c, ce ) || *c == '%' ) continue;
+          indexType i, j;
+          double    re, im;
+          if ( !mm_entry( c, ce, nRows, nCols, cpx, i, j, re, im ) ) { bad[t] = q; return; }
+          I[k] = i;
+          J[k] = j;
+          mm_assign( re, im, A[k] );
+          if ( mirror && i != j ) {
+            I[km] = j;
+            J[km] = i;
+            A[km] = mm_mirror( A[k], mType );
+            ++km;
+          }
+          ++k;
+        }
+        nmirror[t] = km - numNnz - off[t];
+      } );
+
+      for ( unsigned t = 0; t < nThreads; ++t ) {
+        if ( bad[t] == nullptr ) continue;
+        numLine = 1 + indexType( std::count( b, bad[t], '\n' ) );
+        SPARSETOOL_ERR(
+          "In reading Matrix Market File " << fname << ", bad entry on line " <<
+          numLine << "\nRead<<" << std::string( bad[t], mm_next_line( bad[t], e ) ) <<
+          ">>, data is " << *this
+        );
+      }
+
+      // step 4: pack the mirrored entries and order
+      indexType nz = numNnz;
+      if ( mirror ) {
+        for ( unsigned t = 0; t < nThreads; ++t ) {
+          indexType from = numNnz + off[t];
+          std::copy( I+from, I+from+nmirror[t], I+nz );
+          std::copy( J+from, J+from+nmirror[t], J+nz );
+          std::copy( A+from, A+from+nmirror[t], A+nz );
+          nz += nmirror[t];
+        }
+      }
+      mat.setNnz( nz );
+      mat.internalOrder();
+    }
+
+    //! read with \c readFast and copy the matrix in the template \c M class.
+    template<typename MAT>
+    void
+    readFast( char const fname[], MAT & M, unsigned nThreads = 0 ) {
+      CCoorMatrix<typename MAT::valueType> M1;
+      readFast( fname, M1, nThreads );
+      M.resize( M1 );
+    }
+
+    /*! \brief
+     *  Read a coordinate file in \c mat pulling the text by blocks from
+     *  \c src, for compressed files (e.g. \c zstream::gzip_block_reader).
+     *
+     *  \c SOURCE provides <c> bool next_block( char const * & p, size_t & n ) </c>
+     *  returning the next block of text in <c> [p,p+n) </c>, valid until
+     *  the next call, and \c false at the end.  The entries are parsed in
+     *  place in the blocks, only a line split between two blocks is
+     *  copied, so the source can produce the next block while the
+     *  parser works on the current one.  If \c SOURCE has \c get_zerr
+     *  (as \c zstream::gzip_block_reader) a stream that ended with an
+     *  error, e.g. a bad crc or a truncated file, is refused.
+     */
+    template <typename SOURCE, typename T>
+    void
+    readBlocks( SOURCE & src, CCoorMatrix<T> & mat ) {
+
+      MMBlockLines<SOURCE> lines( src );
+      char const * q;
+      char const * qe;
+
+      // step 0: the header ends with the line of the sizes
+      {
+        std::string header;
+        while ( lines.next( q, qe ) ) {
+          header.append( q, qe );
+          if ( *q != '%' ) break;
+        }
+        std::istringstream hs( header );
+        readHeader( hs );
+      }
+
+      SPARSETOOL_ASSERT(
+        cType == MM_COORDINATE,
+        "MatrixMarket: file must be a coordinate file!, data is " << *this
+      );
+      SPARSETOOL_ASSERT(
+        vType != MM_PATTERN,
+        "MatrixMarket: try to read a matrix from a pattern only file!, data is " << *this
+      );
+      SPARSETOOL_ASSERT(
+        vType != MM_COMPLEX || mm_is_complex( T(0) ),
+        "MatrixMarket: try to read a complex matrix into a non complex one!, data is " << *this
+      );
+
+      // step 1: parse the lines, the mirrored entry next to the entry
+      bool mirror = mType != MM_GENERAL;
+      bool cpx    = vType == MM_COMPLEX;
+      mat.resize( nRows, nCols, 0 );
+      mat.setNnz( mirror ? 2*numNnz : numNnz );
+      indexType * I = mat.nnz() > 0 ? &mat.getI().front() : nullptr;
+      indexType * J = mat.nnz() > 0 ? &mat.getJ().front() : nullptr;
+      T         * A = &mat.getA().front();
+      indexType   k = 0, nz = 0;
+
+      while ( lines.next( q, qe ) ) {
+        ++numLine;
+        char const * c = q;
+        if ( mm_eol( c, qe ) || *c == '%' ) continue;
+        indexType i, j;
+        double    re, im;
+        SPARSETOOL_ASSERT(
+          nz < numNnz && mm_entry( c, qe, nRows, nCols, cpx, i, j, re, im ),
+          "In reading Matrix Market File, bad or exceeding entry on line " << numLine <<
+          "\nRead<<" << std::string( q, qe ) << ">>, data is " << *this
+        );
+        I[k] = i;
+        J[k] = j;
+        mm_assign( re, im, A[k] );
+        ++k;
+        ++nz;
+        if ( mirror && i != j ) {
+          I[k] = j;
+          J[k] = i;
+          A[k] = mm_mirror( A[k-1], mType );
+          ++k;
+        }
+      }
+
+      int zerr = mm_source_error( src, 0 );
+      SPARSETOOL_ASSERT(
+        zerr == 0,
+        "In reading Matrix Market File, the compressed stream ended with error " <<
+        zerr << " after " << numLine << " lines (bad crc or truncated file)"
+      );
+      SPARSETOOL_ASSERT(
+        nz == numNnz,
+        "In reading Matrix Market File, found " << nz <<
+        " entries, the header declares " << numNnz
+      );
+      mat.setNnz( k );
+      mat.internalOrder();
+    }
+
+    //! read with \c readBlocks and copy the matrix in the template \c M class.
+    template <typename SOURCE, typename MAT>
+    void
+    readBlocks( SOURCE & src, MAT & M ) {
+      CCoorMatrix<typename MAT::valueType> M1;
+      readBlocks( src, M1 );
+      M.resize( M1 );
+    }
+
     ///////////////////////////////////////////////////////////////////
 
     unsigned numRows() const { return nRows;  } //!< number of rows of loaded matrix
@@ -630,6 +1223,131 @@ mm.load_matrix( A );      // copy loaded matrix in sparse matrix A
 
     file.close();
   }
+
+  /*!
+   *  Write a matrix in MatrixMarket coordinate format to \c stream, fast
+   *  path for large matrices.
+   *
+   *  The entries are collected by batches with the iterator of \c A, each
+   *  batch is split in \c nThreads chunks formatted concurrently in large
+   *  buffers, written in order with one \c write per chunk.  The values
+   *  are written with the shortest decimal form found that reads back to
+   *  the same \c double (17 significant digits at most), the output is the
+   *  same file of \c MatrixMarketSaveToFile up to the number formatting.
+   *  \c stream can be a \c zstream::opgzstream for a gzip file.
+   *  \c nThreads = 0 (default) uses the hardware threads.
+   *
+   *  \param stream   output stream (opened in binary mode)
+   *  \param A        sparse matrix to save
+   *  \param vType    \copydoc SparseTool::CoorType
+   *  \param mType    \copydoc SparseTool::MatrixType
+   *  \param nThreads number of threads formatting the entries
+   */
+
+  template <typename T,typename M>
+  static
+  void
+  MatrixMarketWriteFast(
+    std::ostream      & stream,
+    Sparse<T,M> const & A,
+    ValueType           vType,
+    MatrixType          mType,
+    unsigned            nThreads = 0
+  ) {
+
+    SPARSETOOL_ASSERT(
+      vType != MM_COMPLEX || mm_is_complex( T(0) ),
+      "MatrixMarketWriteFast: cannot write a NON complex matrix with a complex type"
+    );
+    SPARSETOOL_ASSERT(
+      vType == MM_PATTERN || vType == MM_COMPLEX || !mm_is_complex( T(0) ),
+      "MatrixMarketWriteFast: cannot write a complex matrix with non complex type"
+    );
+
+    stream
+      << "%%MatrixMarket matrix coordinate "
+      << cV[vType]   << ' '
+      << cM[mType]   << '\n'
+      << MM_HEADER
+      << A.numRows() << ' '
+      << A.numCols() << ' '
+      << A.nnz()     << '\n';
+
+    size_t const chunk = size_t(1) << 16;
+    size_t const nz    = size_t(A.nnz());
+    if ( nThreads == 0 ) nThreads = std::thread::hardware_concurrency();
+    if ( nThreads == 0 ) nThreads = 1;
+    if ( nThreads > nz/chunk+1 ) nThreads = unsigned(nz/chunk+1);
+
+    bool const values = vType != MM_PATTERN;
+    std::vector<indexType> I( nThreads*chunk ), J( nThreads*chunk );
+    std::vector<T>         V( values ? nThreads*chunk : 0 );
+    std::vector<std::vector<char> > buf( nThreads );
+    std::vector<size_t>             len( nThreads );
+    for ( unsigned t = 0; t < nThreads; ++t ) buf[t].resize( chunk*MM_ENTRY_CHARS );
+
+    A.Begin();
+    while ( A.End() ) {
+      // step 1: collect a batch, the iterator is sequential
+      size_t n = 0;
+      for ( ; n < I.size() && A.End(); A.Next(), ++n ) {
+        I[n] = A.row();
+        J[n] = A.column();
+        if ( values ) V[n] = A.value();
+      }
+      // step 2: format the chunks of the batch concurrently
+      parallel_run( nThreads, [&]( indexType t, SweepBarrier & ) {
+        size_t lo = std::min( n, t*chunk );
+        size_t hi = std::min( n, lo+chunk );
+        char * b  = &buf[t].front();
+        char * p  = b;
+        for ( size_t k = lo; k < hi; ++k ) {
+          p = mm_put_uint( p, uint64_t(I[k])+1 );
+          *p++ = '\t';
+          p = mm_put_uint( p, uint64_t(J[k])+1 );
+          if ( values ) p = mm_put_value( p, V[k] );
+          *p++ = '\n';
+        }
+        len[t] = size_t(p-b);
+      } );
+      // step 3: write in order
+      for ( unsigned t = 0; t < nThreads; ++t )
+        if ( len[t] > 0 ) stream.write( &buf[t].front(), std::streamsize(len[t]) );
+    }
+
+    SPARSETOOL_ASSERT(
+      stream.good(), "MatrixMarketWriteFast: write failed"
+    );
+  }
+
+  /*!
+   *  Save a matrix to a file in MatrixMarket format with
+   *  \c MatrixMarketWriteFast
+   *  \param fname    the name of the file to save
+   *  \param A        sparse matrix to save
+   *  \param vType    \copydoc SparseTool::CoorType
+   *  \param mType    \copydoc SparseTool::MatrixType
+   *  \param nThreads number of threads formatting the entries (0 = hardware threads)
+   */
+
+  template <typename T,typename M>
+  static
+  void
+  MatrixMarketSaveToFileFast(
+    std::string const & fname,
+    Sparse<T,M> const & A,
+    ValueType           vType,
+    MatrixType          mType,
+    unsigned            nThreads = 0
+  ) {
+    std::ofstream file( fname.c_str(), std::ios::out | std::ios::binary );
+    SPARSETOOL_ASSERT(
+      file.is_open(),
+      "MatrixMarketSaveToFileFast: cannot open " << fname
+    );
+    MatrixMarketWriteFast( file, A, vType, mType, nThreads );
+    file.close();
+  }
     
   /*!
    * Save a vector to a file in MatrixMarket format
@@ -722,6 +1440,8 @@ namespace SparseToolLoad {
 
   using ::SparseTool::MatrixMarket;
   using ::SparseTool::MatrixMarketSaveToFile;
+  using ::SparseTool::MatrixMarketSaveToFileFast;
+  using ::SparseTool::MatrixMarketWriteFast;
 
   using ::SparseTool::MM_COORDINATE;
   using ::SparseTool::MM_ARRAY;
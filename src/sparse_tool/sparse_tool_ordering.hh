@@ -0,0 +1,570 @@
+/*!
+
+  \file     sparse_tool_ordering.hh
+  \brief    Fill reducing orderings (reverse Cuthill-McKee and
+            approximate minimum degree) of the sparse matrices and
+            symmetric permutations built from them.
+
+*/
+
+#ifndef SPARSETOOL_ORDERING_HH
+#define SPARSETOOL_ORDERING_HH
+
+#include "sparse_tool.hh"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace SparseTool {
+
+  /*
+  //   #####  ######     #    ######  #     #
+  //  #     # #     #   # #   #     # #     #
+  //  #       #     #  #   #  #     # #     #
+  //  #  #### ######  #     # ######  #######
+  //  #     # #   #   ####### #       #     #
+  //  #     # #    #  #     # #       #     #
+  //   #####  #     # #     # #       #     #
+  */
+
+  /*!
+   *  Permutations are stored as the vector \c perm of the old indices in
+   *  the new order: the unknown \c k of the permuted system is the
+   *  unknown \c perm(k) of the original one, and the symmetric permuted
+   *  matrix is \f$ B = P A P^T \f$ with \f$ B(k,l) = A(\mathrm{perm}(k),
+   *  \mathrm{perm}(l)) \f$.
+   */
+
+  /*!
+   *  Adjacency graph of the pattern of \f$ A + A^T \f$ without the
+   *  diagonal, in compressed rows \c G_R (\c n+1 pointers) and \c G_J
+   *  (increasing columns in each row).
+   *  \param A   square sparse matrix or pattern
+   *  \param G_R row pointers of the graph
+   *  \param G_J adjacent nodes
+   */
+  template <typename MAT>
+  static
+  void
+  OrderingGraph(
+    SparseBase<MAT> const & A,
+    Vector<indexType>     & G_R,
+    Vector<indexType>     & G_J
+  ) {
+    SPARSETOOL_ASSERT(
+      A.numRows() == A.numCols(),
+      "OrderingGraph: only square matrix allowed"
+    )
+    indexType const n = A.numRows();
+    G_R.resize(n+1);
+    G_R = 0;
+    for ( A.Begin(); A.End(); A.Next() ) {
+      indexType i = A.row();
+      indexType j = A.column();
+      if ( i != j ) { ++G_R(i+1); ++G_R(j+1); }
+    }
+    for ( indexType i = 0; i < n; ++i ) G_R(i+1) += G_R(i);
+    G_J.resize(G_R(n));
+    {
+      Vector<indexType> fill(n);
+      for ( indexType i = 0; i < n; ++i ) fill(i) = G_R(i);
+      for ( A.Begin(); A.End(); A.Next() ) {
+        indexType i = A.row();
+        indexType j = A.column();
+        if ( i != j ) { G_J(fill(i)++) = j; G_J(fill(j)++) = i; }
+      }
+    }
+    // sort and remove the duplicates (the entries of both A(i,j) and A(j,i))
+    indexType nz = 0;
+    for ( indexType i = 0; i < n; ++i ) {
+      indexType * b = G_J.data() + G_R(i);
+      indexType * e = G_J.data() + G_R(i+1);
+      std::sort( b, e );
+      e = std::unique( b, e );
+      G_R(i) = nz;
+      for ( indexType * q = b; q < e; ++q ) G_J(nz++) = *q;
+    }
+    G_R(n) = nz;
+    G_J.resize(nz);
+  }
+
+  /*!
+   *  Bandwidth \f$ \max |i-j| \f$ of the nonzeros of \c A
+   */
+  template <typename MAT>
+  static
+  indexType
+  Bandwidth( SparseBase<MAT> const & A ) {
+    indexType bw = 0;
+    for ( A.Begin(); A.End(); A.Next() ) {
+      indexType i = A.row();
+      indexType j = A.column();
+      bw = std::max( bw, i > j ? i-j : j-i );
+    }
+    return bw;
+  }
+
+  /*!
+   *  Profile (envelope size) \f$ \sum_i (i - \min\{ j : a_{ij} \neq 0, j \leq i\}) \f$
+   *  of the lower part of the pattern of \f$ A + A^T \f$
+   */
+  template <typename MAT>
+  static
+  uint64_t
+  Profile( SparseBase<MAT> const & A ) {
+    SPARSETOOL_ASSERT(
+      A.numRows() == A.numCols(),
+      "Profile: only square matrix allowed"
+    )
+    Vector<indexType> first( A.numRows() );
+    for ( indexType i = 0; i < A.numRows(); ++i ) first(i) = i;
+    for ( A.Begin(); A.End(); A.Next() ) {
+      indexType i = A.row();
+      indexType j = A.column();
+      if ( j < i ) first(i) = std::min( first(i), j );
+      else         first(j) = std::min( first(j), i );
+    }
+    uint64_t prof = 0;
+    for ( indexType i = 0; i < A.numRows(); ++i ) prof += i - first(i);
+    return prof;
+  }
+
+  /*! \cond NODOC */
+
+  // level structure rooted in r: the nodes in queue by levels, returns the
+  // number of levels and in last the start of the last level
+  static
+  inline
+  indexType
+  rcm_levels(
+    Vector<indexType> const & G_R,
+    Vector<indexType> const & G_J,
+    indexType                 r,
+    indexType                 stamp,
+    std::vector<indexType>  & mark,
+    std::vector<indexType>  & queue,
+    indexType               & last
+  ) {
+    queue.clear();
+    queue.push_back(r);
+    mark[r] = stamp;
+    indexType nlev = 0, lo = 0;
+    while ( lo < queue.size() ) {
+      indexType hi = indexType(queue.size());
+      last = lo;
+      ++nlev;
+      for ( indexType kk = lo; kk < hi; ++kk ) {
+        indexType v = queue[kk];
+        for ( indexType jj = G_R(v); jj < G_R(v+1); ++jj ) {
+          indexType w = G_J(jj);
+          if ( mark[w] != stamp ) { mark[w] = stamp; queue.push_back(w); }
+        }
+      }
+      lo = hi;
+    }
+    return nlev;
+  }
+
+  /*! \endcond */
+
+  /*!
+   *  Reverse Cuthill-McKee ordering of the pattern of \f$ A + A^T \f$,
+   *  reduces the bandwidth and the profile.
+   *
+   *  Every connected component is numbered by a breadth first search from
+   *  a pseudo peripheral node (George-Liu), visiting the neighbours by
+   *  increasing degree; the final order is reversed.
+   *  \param A    square sparse matrix or pattern
+   *  \param perm the permutation, \c perm(k) is the old index of the new \c k
+   */
+  template <typename MAT>
+  static
+  void
+  RCMOrdering( SparseBase<MAT> const & A, Vector<indexType> & perm ) {
+    Vector<indexType> G_R, G_J;
+    OrderingGraph( A, G_R, G_J );
+    indexType const n    = A.numRows();
+    indexType const none = indexType(-1);
+    perm.resize(n);
+    if ( n == 0 ) return;
+
+    // nodes by increasing degree: the first not numbered node starts
+    // the next component
+    Vector<indexType> byDeg(n), cnt(n+1);
+    cnt = 0;
+    for ( indexType i = 0; i < n; ++i ) ++cnt(G_R(i+1)-G_R(i)+1);
+    for ( indexType d = 0; d < n; ++d ) cnt(d+1) += cnt(d);
+    for ( indexType i = 0; i < n; ++i ) byDeg(cnt(G_R(i+1)-G_R(i))++) = i;
+
+    std::vector<indexType> mark( n, none ), queue, nbr;
+    std::vector<bool>      done( n, false );
+    indexType stamp = 0, pos = 0;
+    for ( indexType s = 0; s < n; ++s ) {
+      indexType r = byDeg(s);
+      if ( done[r] ) continue;
+
+      // pseudo peripheral node
+      indexType last = 0;
+      indexType nlev = rcm_levels( G_R, G_J, r, stamp++, mark, queue, last );
+      while ( true ) {
+        indexType x = queue[last];
+        for ( indexType kk = last+1; kk < queue.size(); ++kk )
+          if ( G_R(queue[kk]+1)-G_R(queue[kk]) < G_R(x+1)-G_R(x) ) x = queue[kk];
+        indexType xlast = 0;
+        indexType xlev  = rcm_levels( G_R, G_J, x, stamp++, mark, queue, xlast );
+        if ( xlev <= nlev ) break;
+        r    = x;
+        nlev = xlev;
+        last = xlast;
+      }
+
+      // Cuthill-McKee from r
+      indexType head = pos;
+      perm(pos++) = r;
+      done[r]     = true;
+      while ( head < pos ) {
+        indexType v = perm(head++);
+        nbr.clear();
+        for ( indexType jj = G_R(v); jj < G_R(v+1); ++jj ) {
+          indexType w = G_J(jj);
+          if ( !done[w] ) { done[w] = true; nbr.push_back(w); }
+        }
+        std::stable_sort(
+          nbr.begin(), nbr.end(),
+          [&G_R]( indexType a, indexType b )
+          { return G_R(a+1)-G_R(a) < G_R(b+1)-G_R(b); }
+        );
+        for ( indexType kk = 0; kk < nbr.size(); ++kk ) perm(pos++) = nbr[kk];
+      }
+    }
+    std::reverse( perm.begin(), perm.end() );
+  }
+
+  /*!
+   *  Approximate minimum degree ordering of the pattern of
+   *  \f$ A + A^T \f$, reduces the fill-in of the factorization.
+   *
+   *  The elimination is simulated on the quotient graph: each eliminated
+   *  node becomes an element (a clique) absorbing the elements adjacent
+   *  to it, and the degrees of its neighbours are replaced by the upper
+   *  bound of Amestoy, Davis and Duff computed from the external degrees
+   *  \f$ |L_e \setminus L_p| \f$ of the adjacent elements; elements
+   *  contained in the new one are absorbed.  Supervariables are not
+   *  detected.  The dense rows (more than \f$ 10\sqrt{n} \f$ entries)
+   *  are ordered last.
+   *  \param A    square sparse matrix or pattern
+   *  \param perm the permutation, \c perm(k) is the old index of the new \c k
+   */
+  template <typename MAT>
+  static
+  void
+  AMDOrdering( SparseBase<MAT> const & A, Vector<indexType> & perm ) {
+    Vector<indexType> G_R, G_J;
+    OrderingGraph( A, G_R, G_J );
+    indexType const n    = A.numRows();
+    indexType const none = indexType(-1);
+    perm.resize(n);
+    if ( n == 0 ) return;
+
+    enum { VAR = 0, ELEM = 1, DEAD = 2, DENSE = 3 };
+    indexType const dense = std::max( indexType(16), indexType( 10*std::sqrt(double(n)) ) );
+
+    std::vector<unsigned char>          status( n, VAR );
+    std::vector<std::vector<indexType> > Av(n), Ev(n), Lv(n);
+    std::vector<indexType> deg(n), head( n, none ), next(n), prev(n);
+    std::vector<indexType> mark( n, 0 ), wmark( n, 0 ), w( n, 0 );
+
+    indexType nvar = n;
+    for ( indexType i = 0; i < n; ++i )
+      if ( G_R(i+1)-G_R(i) > dense ) { status[i] = DENSE; --nvar; }
+
+    // degree lists
+    indexType mindeg = 0;
+    auto insert = [&]( indexType i ) {
+      indexType d = deg[i];
+      prev[i] = none;
+      next[i] = head[d];
+      if ( head[d] != none ) prev[head[d]] = i;
+      head[d] = i;
+      if ( d < mindeg ) mindeg = d;
+    };
+    auto remove = [&]( indexType i ) {
+      if ( prev[i] != none ) next[prev[i]] = next[i];
+      else                   head[deg[i]]  = next[i];
+      if ( next[i] != none ) prev[next[i]] = prev[i];
+    };
+
+    for ( indexType i = 0; i < n; ++i ) {
+      if ( status[i] != VAR ) continue;
+      for ( indexType jj = G_R(i); jj < G_R(i+1); ++jj )
+        if ( status[G_J(jj)] == VAR ) Av[i].push_back(G_J(jj));
+      deg[i] = indexType(Av[i].size());
+      insert(i);
+    }
+
+    std::vector<indexType> Lp;
+    indexType k = 0, tag = 0;
+    while ( k < nvar ) {
+      while ( head[mindeg] == none ) ++mindeg;
+      indexType p = head[mindeg];
+      remove(p);
+      perm(k++) = p;
+
+      // step 1: the new element, variables adjacent to p and to its elements
+      ++tag;
+      mark[p] = tag;
+      Lp.clear();
+      for ( indexType v : Av[p] )
+        if ( status[v] == VAR && mark[v] != tag ) { mark[v] = tag; Lp.push_back(v); }
+      for ( indexType e : Ev[p] ) {
+        if ( status[e] != ELEM ) continue;
+        for ( indexType v : Lv[e] )
+          if ( status[v] == VAR && mark[v] != tag ) { mark[v] = tag; Lp.push_back(v); }
+        status[e] = DEAD;
+        std::vector<indexType>().swap(Lv[e]);
+      }
+      status[p] = ELEM;
+      std::vector<indexType>().swap(Av[p]);
+      std::vector<indexType>().swap(Ev[p]);
+
+      // step 2: external degrees |Le \ Lp| of the elements adjacent to Lp
+      for ( indexType i : Lp ) {
+        remove(i);
+        for ( indexType e : Ev[i] ) {
+          if ( status[e] != ELEM ) continue;
+          if ( wmark[e] != tag ) { wmark[e] = tag; w[e] = indexType(Lv[e].size()); }
+          --w[e];
+        }
+      }
+
+      // step 3: prune the lists of the variables of Lp and update the degrees
+      indexType const lp = indexType(Lp.size());
+      for ( indexType i : Lp ) {
+        std::vector<indexType> & E = Ev[i];
+        indexType dext = 0, ne = 0;
+        for ( indexType e : E ) {
+          if ( status[e] != ELEM ) continue;
+          if ( w[e] == 0 ) { // Le inside Lp: absorbed
+            status[e] = DEAD;
+            std::vector<indexType>().swap(Lv[e]);
+          } else {
+            dext   += w[e];
+            E[ne++] = e;
+          }
+        }
+        E.resize(ne);
+        E.push_back(p);
+        std::vector<indexType> & Ai = Av[i];
+        indexType na = 0;
+        for ( indexType v : Ai )
+          if ( status[v] == VAR && mark[v] != tag ) Ai[na++] = v;
+        Ai.resize(na);
+        indexType d = na + lp - 1 + dext;
+        d = std::min( d, deg[i] + lp - 1 );
+        d = std::min( d, nvar - k - 1 );
+        deg[i] = d;
+        insert(i);
+      }
+      Lv[p] = Lp;
+    }
+
+    // dense rows last
+    for ( indexType i = 0; i < n; ++i )
+      if ( status[i] == DENSE ) perm(k++) = i;
+  }
+
+  /*!
+   *  Inverse permutation, \c iperm(perm(k)) = k
+   */
+  static
+  inline
+  void
+  InversePermutation(
+    Vector<indexType> const & perm,
+    Vector<indexType>       & iperm
+  ) {
+    indexType const n    = perm.size();
+    indexType const none = indexType(-1);
+    iperm.resize(n);
+    iperm = none;
+    for ( indexType k = 0; k < n; ++k ) {
+      SPARSETOOL_ASSERT(
+        perm(k) < n && iperm(perm(k)) == none,
+        "InversePermutation: not a permutation, perm(" << k << ") = " << perm(k)
+      )
+      iperm(perm(k)) = k;
+    }
+  }
+
+  /*!
+   *  Permute the vector: \c y(k) = \c x(perm(k))
+   */
+  template <typename T>
+  static
+  void
+  PermuteVector(
+    Vector<T>         const & x,
+    Vector<indexType> const & perm,
+    Vector<T>               & y
+  ) {
+    SPARSETOOL_ASSERT(
+      &x != &y && x.size() == perm.size(),
+      "PermuteVector: bad arguments"
+    )
+    y.resize( perm.size() );
+    for ( indexType k = 0; k < perm.size(); ++k ) y(k) = x(perm(k));
+  }
+
+  /*!
+   *  Inverse permutation of the vector: \c x(perm(k)) = \c y(k)
+   */
+  template <typename T>
+  static
+  void
+  InversePermuteVector(
+    Vector<T>         const & y,
+    Vector<indexType> const & perm,
+    Vector<T>               & x
+  ) {
+    SPARSETOOL_ASSERT(
+      &x != &y && y.size() == perm.size(),
+      "InversePermuteVector: bad arguments"
+    )
+    x.resize( perm.size() );
+    for ( indexType k = 0; k < perm.size(); ++k ) x(perm(k)) = y(k);
+  }
+
+  /*!
+   *  Symmetric permutation \f$ B = P A P^T \f$ of a compressed row matrix:
+   *  the rows of \c B are the rows \c perm(k) of \c A with the columns
+   *  renumbered, copied concurrently and ordered by \c internalOrder.
+   */
+  template <typename T>
+  static
+  void
+  SymmetricPermute(
+    CRowMatrix<T>     const & A,
+    Vector<indexType> const & perm,
+    CRowMatrix<T>           & B
+  ) {
+    SPARSETOOL_ASSERT(
+      A.numRows() == A.numCols() && perm.size() == A.numRows() && &A != &B,
+      "SymmetricPermute: bad arguments"
+    )
+    indexType const n = A.numRows();
+    Vector<indexType> iperm, R(n+1), J(A.nnz());
+    Vector<T>         V(A.nnz());
+    InversePermutation( perm, iperm );
+    Vector<indexType> const & AR = A.getR();
+    Vector<indexType> const & AJ = A.getJ();
+    Vector<T>         const & AA = A.getA();
+    R(0) = 0;
+    for ( indexType k = 0; k < n; ++k ) R(k+1) = R(k) + AR(perm(k)+1) - AR(perm(k));
+    indexType const nt = sp_assembly_nt( A.nnz(), 0 );
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType hi = indexType( (uint64_t(n)*(t+1))/nt );
+      for ( indexType k = indexType( (uint64_t(n)*t)/nt ); k < hi; ++k )
+        for ( indexType kk = AR(perm(k)), pos = R(k); kk < AR(perm(k)+1); ++kk, ++pos ) {
+          J(pos) = iperm(AJ(kk));
+          V(pos) = AA(kk);
+        }
+    } );
+    B.load( n, n, R.data(), J.data(), V.data() );
+  }
+
+  /*!
+   *  Symmetric permutation \f$ B = P A P^T \f$ of a compressed column matrix
+   */
+  template <typename T>
+  static
+  void
+  SymmetricPermute(
+    CColMatrix<T>     const & A,
+    Vector<indexType> const & perm,
+    CColMatrix<T>           & B
+  ) {
+    SPARSETOOL_ASSERT(
+      A.numRows() == A.numCols() && perm.size() == A.numRows() && &A != &B,
+      "SymmetricPermute: bad arguments"
+    )
+    indexType const n = A.numRows();
+    Vector<indexType> iperm, C(n+1), I(A.nnz());
+    Vector<T>         V(A.nnz());
+    InversePermutation( perm, iperm );
+    Vector<indexType> const & AC = A.getC();
+    Vector<indexType> const & AI = A.getI();
+    Vector<T>         const & AA = A.getA();
+    C(0) = 0;
+    for ( indexType k = 0; k < n; ++k ) C(k+1) = C(k) + AC(perm(k)+1) - AC(perm(k));
+    indexType const nt = sp_assembly_nt( A.nnz(), 0 );
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType hi = indexType( (uint64_t(n)*(t+1))/nt );
+      for ( indexType k = indexType( (uint64_t(n)*t)/nt ); k < hi; ++k )
+        for ( indexType kk = AC(perm(k)), pos = C(k); kk < AC(perm(k)+1); ++kk, ++pos ) {
+          I(pos) = iperm(AI(kk));
+          V(pos) = AA(kk);
+        }
+    } );
+    B.load( n, n, C.data(), I.data(), V.data() );
+  }
+
+  /*!
+   *  Symmetric permutation \f$ B = P A P^T \f$ of a compressed coordinate matrix
+   */
+  template <typename T>
+  static
+  void
+  SymmetricPermute(
+    CCoorMatrix<T>    const & A,
+    Vector<indexType> const & perm,
+    CCoorMatrix<T>          & B
+  ) {
+    SPARSETOOL_ASSERT(
+      A.numRows() == A.numCols() && perm.size() == A.numRows() && &A != &B,
+      "SymmetricPermute: bad arguments"
+    )
+    indexType const n  = A.numRows();
+    indexType const nz = A.nnz();
+    Vector<indexType> iperm, I(nz), J(nz);
+    InversePermutation( perm, iperm );
+    Vector<indexType> const & AI = A.getI();
+    Vector<indexType> const & AJ = A.getJ();
+    indexType const nt = sp_assembly_nt( nz, 0 );
+    parallel_run( nt, [&]( indexType t, SweepBarrier & ) {
+      indexType hi = indexType( (uint64_t(nz)*(t+1))/nt );
+      for ( indexType kk = indexType( (uint64_t(nz)*t)/nt ); kk < hi; ++kk ) {
+        I(kk) = iperm(AI(kk));
+        J(kk) = iperm(AJ(kk));
+      }
+    } );
+    B.load( n, n, nz, I.data(), J.data(), A.getA().data() );
+  }
+
+}
+
+namespace SparseToolLoad {
+
+  using ::SparseTool::OrderingGraph;
+  using ::SparseTool::Bandwidth;
+  using ::SparseTool::Profile;
+  using ::SparseTool::RCMOrdering;
+  using ::SparseTool::AMDOrdering;
+  using ::SparseTool::InversePermutation;
+  using ::SparseTool::PermuteVector;
+  using ::SparseTool::InversePermuteVector;
+  using ::SparseTool::SymmetricPermute;
+
+}
+
+#endif
+
+/*
+// ####### ####### #######
+// #       #     # #
+// #       #     # #
+// #####   #     # #####
+// #       #     # #
+// #       #     # #
+// ####### ####### #
+*/
@@ -25,13 +25,15 @@
 #include <iostream>
 #include <algorithm>
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 #include <zlib.h>
 
-namespace zstream {
+#include "zstream_common.hh"
 
-/// default gzip buffer size,
-/// change this to suite your needs
-const size_t default_buffer_size = 4096;
+namespace zstream {
 
 /** \brief A stream decorator that takes compressed input and unzips it to a istream.
 
@@ -278,6 +280,93 @@ public:
   { }
 };
 
+/** \brief Pull reader of a gzip stream by decompressed blocks.
+
+ Instead of a streambuf serving characters, the reader hands out whole
+ decompressed blocks of block_size_ bytes, to be parsed in place:
+ next_block returns a pointer to the data that stays valid until the
+ following call.  With background_ set the input is read and inflated
+ by a worker thread into a second buffer while the caller works on the
+ current block.
+
+ Concatenated gzip members (as written by pigz or by appending .gz
+ files) are read as one stream, and input without the gzip magic is
+ passed through unchanged.  The crc and size of each member are checked
+ by zlib, errors end the stream and are returned by get_zerr.
+
+ \code
+ ifstream file( "matrix.mtx.gz", ios::binary );
+ gzip_block_reader gz( file );
+ char const * p;
+ size_t       n;
+ while ( gz.next_block( p, n ) ) parse( p, p+n );
+ if ( gz.get_zerr() != Z_OK && gz.get_zerr() != Z_STREAM_END ) error();
+ \endcode
+ */
+class gzip_block_reader {
+public:
+	/** Construct the reader
+	 *
+	 * \param istream_     compressed input, read only by the reader
+	 * \param block_size_  size of the decompressed blocks and of the input buffer
+	 * \param background_  inflate in a worker thread
+	 */
+	gzip_block_reader(
+    std::istream & istream_,
+    size_t         block_size_ = default_block_size,
+    bool           background_ = true
+  );
+
+	~gzip_block_reader();
+
+	/// next decompressed block in [data_,data_+size_), false at the end of the stream
+	bool next_block(char const*& data_, size_t& size_);
+
+	/// returns the latest zlib error state, Z_OK or Z_STREAM_END if no error
+	int get_zerr() const {
+		return m_err;
+	}
+
+	/// returns the number of uncompressed bytes handed out so far
+	unsigned long long get_out_size() const {
+		return m_out_size;
+	}
+
+	/// returns the number of gzip members read so far
+	unsigned get_members() const {
+		return m_members;
+	}
+
+private:
+	gzip_block_reader(gzip_block_reader const&);
+	gzip_block_reader& operator=(gzip_block_reader const&);
+
+	size_t fill(char* out_, size_t size_);
+	void   worker();
+
+	std::istream&     m_istream;
+	z_stream          m_zip_stream;
+	int               m_err;
+	bool              m_raw;
+	bool              m_end;      // no more data from fill
+	bool              m_in_member;
+	unsigned          m_members;
+	std::vector<char> m_input;
+	std::vector<char> m_block[2];
+	size_t            m_size[2];
+	bool              m_full[2];  // block ready to be handed out
+	int               m_held;     // block held by the caller, -1 none
+	int               m_next;     // next block to hand out
+	bool              m_done;     // worker finished
+	bool              m_stop;
+	bool              m_background;
+	unsigned long long m_out_size;
+
+	std::thread             m_thread;
+	std::mutex              m_mutex;
+	std::condition_variable m_cond;
+};
+
 /// A typedef for basic_zip_istream<char>
 typedef basic_gzip_istream<char> igzstream;
 /// A typedef for basic_zip_istream<wchart>
@@ -27,18 +27,6 @@
 
 namespace zstream {
 
-namespace detail {
-const int gz_magic[2] = { 0x1f, 0x8b }; /* gzip magic header */
-
-/* gzip flag byte */
-const int gz_ascii_flag  = 0x01; /* bit 0 set: file probably ascii text */
-const int gz_head_crc    = 0x02; /* bit 1 set: header CRC present */
-const int gz_extra_field = 0x04; /* bit 2 set: extra field present */
-const int gz_orig_name   = 0x08; /* bit 3 set: original file name present */
-const int gz_comment     = 0x10; /* bit 4 set: file comment present */
-const int gz_reserved    = 0xE0; /* bits 5..7: reserved */
-}
-
 template<
   typename Elem,
   typename Tr,
@@ -296,6 +284,165 @@ basic_gzip_istream<Elem, Tr, ElemA, ByteT, ByteAT>::read_long(
 	in_.read(reinterpret_cast<char*>(&x_), n_end);
 }
 
+inline
+gzip_block_reader::gzip_block_reader(
+  std::istream & istream_,
+  size_t         block_size_,
+  bool           background_
+)
+: m_istream(istream_)
+, m_err(Z_OK)
+, m_raw(false)
+, m_end(false)
+, m_in_member(false)
+, m_members(0)
+, m_input(block_size_ > 0 ? block_size_ : default_block_size)
+, m_held(-1)
+, m_next(0)
+, m_done(false)
+, m_stop(false)
+, m_background(background_)
+, m_out_size(0)
+{
+	m_zip_stream.zalloc = (alloc_func) 0;
+	m_zip_stream.zfree = (free_func) 0;
+	m_zip_stream.opaque = (voidpf) 0;
+	m_zip_stream.next_in = nullptr;
+	m_zip_stream.avail_in = 0;
+
+	// gzip wrapper, header and crc handled by zlib
+	m_err = inflateInit2(&m_zip_stream, 15 + 16);
+
+	for (int k = 0; k < 2; ++k) {
+		m_block[k].resize(m_input.size());
+		m_size[k] = 0;
+		m_full[k] = false;
+	}
+	if (m_err != Z_OK) {
+		m_end = m_done = true;
+		return;
+	}
+
+	// plain input passes through
+	m_istream.read(&m_input[0], 2);
+	std::streamsize n = m_istream.gcount();
+	m_raw = n < 2 || (unsigned char) m_input[0] != detail::gz_magic[0]
+	              || (unsigned char) m_input[1] != detail::gz_magic[1];
+	m_zip_stream.next_in = (Bytef*) &m_input[0];
+	m_zip_stream.avail_in = uInt(n);
+
+	if (m_background)
+		m_thread = std::thread(&gzip_block_reader::worker, this);
+}
+
+inline
+gzip_block_reader::~gzip_block_reader() {
+	if (m_thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cond.notify_all();
+		m_thread.join();
+	}
+	inflateEnd(&m_zip_stream);
+}
+
+inline
+size_t
+gzip_block_reader::fill(char* out_, size_t size_) {
+	size_t n = 0;
+	while (n < size_ && !m_end) {
+		if (m_zip_stream.avail_in == 0) {
+			m_istream.read(&m_input[0], std::streamsize(m_input.size()));
+			m_zip_stream.next_in = (Bytef*) &m_input[0];
+			m_zip_stream.avail_in = uInt(m_istream.gcount());
+			if (m_zip_stream.avail_in == 0) {
+				// input ended inside a member: truncated file
+				if (m_in_member) m_err = Z_DATA_ERROR;
+				m_end = true;
+				break;
+			}
+		}
+		if (m_raw) {
+			size_t k = std::min(size_t(m_zip_stream.avail_in), size_ - n);
+			memcpy(out_ + n, m_zip_stream.next_in, k);
+			m_zip_stream.next_in += k;
+			m_zip_stream.avail_in -= uInt(k);
+			n += k;
+			continue;
+		}
+		m_in_member = true;
+		m_zip_stream.next_out = (Bytef*) (out_ + n);
+		m_zip_stream.avail_out = uInt(size_ - n);
+		int err = inflate(&m_zip_stream, Z_NO_FLUSH);
+		n = size_ - m_zip_stream.avail_out;
+		if (err == Z_STREAM_END) {
+			// next member, if any
+			++m_members;
+			m_in_member = false;
+			m_err = inflateReset(&m_zip_stream);
+			if (m_err != Z_OK) m_end = true;
+		} else if (err != Z_OK && err != Z_BUF_ERROR) {
+			m_err = err;
+			m_end = true;
+		}
+	}
+	return n;
+}
+
+inline
+void
+gzip_block_reader::worker() {
+	int w = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_full[w] && !m_stop) m_cond.wait(lock);
+			if (m_stop) break;
+		}
+		size_t n = fill(&m_block[w][0], m_block[w].size());
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (n > 0) {
+			m_size[w] = n;
+			m_full[w] = true;
+			w ^= 1;
+		}
+		if (m_end) {
+			m_done = true;
+			m_cond.notify_all();
+			break;
+		}
+		m_cond.notify_all();
+	}
+}
+
+inline
+bool
+gzip_block_reader::next_block(char const*& data_, size_t& size_) {
+	if (!m_background) {
+		size_ = fill(&m_block[0][0], m_block[0].size());
+		data_ = &m_block[0][0];
+		m_out_size += size_;
+		return size_ > 0;
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_held >= 0) {
+		// the worker can now refill the block of the previous call
+		m_full[m_held] = false;
+		m_held = -1;
+		m_cond.notify_all();
+	}
+	while (!m_full[m_next] && !m_done) m_cond.wait(lock);
+	if (!m_full[m_next]) return false;
+	m_held = m_next;
+	m_next ^= 1;
+	data_ = &m_block[m_held][0];
+	size_ = m_size[m_held];
+	m_out_size += size_;
+	return true;
+}
+
 } // zstream
 
 #endif
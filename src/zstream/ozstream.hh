@@ -25,13 +25,15 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <zlib.h>
 
-namespace zstream {
+#include "zstream_common.hh"
 
-/// default gzip buffer size,
-/// change this to suite your needs
-const size_t default_buffer_size = 4096;
+namespace zstream {
 
 /// Compression strategy, see zlib doc.
 enum EStrategy {
@@ -143,7 +145,7 @@ public:
 
 	/// returns the zlib error state
 	int get_zerr() const {
-		return m_buf.get_err();
+		return m_buf.get_zerr();
 	}
 
 	/// returns the uncompressed data crc
@@ -289,6 +291,202 @@ private:
 	bool m_closed;
 };
 
+/** \brief A stream buffer that gzips blocks in parallel (pigz style).
+
+ The input is cut in blocks of block_size_ bytes, each compressed by a
+ pool of threads as an independent gzip member; the members are written
+ in order, by the thread writing to the stream, so the output is a
+ valid multi-member gzip stream (read by gzip, zcat, zlib and
+ gzip_block_reader; igzstream stops at the end of the first member).
+ At most two blocks per thread are in flight.  Every member restarts
+ the dictionary, so the ratio is slightly lower than a single stream
+ for small blocks.
+ */
+template<typename Elem, typename Tr = std::char_traits<Elem> >
+class basic_pgzip_streambuf: public std::basic_streambuf<Elem, Tr> {
+public:
+	typedef std::basic_ostream<Elem, Tr>& ostream_reference;
+	typedef typename std::basic_streambuf<Elem, Tr>::char_type char_type;
+	typedef typename std::basic_streambuf<Elem, Tr>::int_type int_type;
+
+	/** Construct a parallel gzip stream buffer
+	 *
+	 * \param ostream_    ostream where the compressed output is written
+	 * \param level_      level of compression 0, bad and fast, 9, good and slower
+	 * \param block_size_ size (bytes) of the uncompressed blocks
+	 * \param threads_    compressing threads, 0 for the hardware threads
+	 */
+	basic_pgzip_streambuf(ostream_reference ostream_, size_t level_,
+			size_t block_size_, unsigned threads_);
+
+	~basic_pgzip_streambuf();
+
+	int sync();
+	int_type overflow(int_type c);
+
+	/// compresses the last block and writes all the members
+	std::streamsize zfinish();
+
+	/// returns a reference to the output stream
+	ostream_reference get_ostream() const {
+		return m_ostream;
+	}
+
+	/// returns the latest zlib error status
+	int get_zerr() const {
+		return m_err;
+	}
+
+	/// returns the size (bytes) of the input data compressed so far.
+	unsigned long long get_in_size() const {
+		return m_in_size;
+	}
+
+	/// returns the size (bytes) of the compressed data written so far.
+	unsigned long long get_out_size() const {
+		return m_out_size;
+	}
+
+	/// returns the number of gzip members written so far
+	unsigned get_members() const {
+		return m_members;
+	}
+
+private:
+	basic_pgzip_streambuf(basic_pgzip_streambuf const&);
+	basic_pgzip_streambuf& operator=(basic_pgzip_streambuf const&);
+
+	struct block_type {
+		std::vector<char_type>     in;
+		std::vector<unsigned char> out;
+		size_t                     in_size;
+		size_t                     out_size;
+		int                        err;
+		bool                       done;
+	};
+
+	block_type* new_block();
+	void submit();
+	void write_front();
+	void worker();
+
+	ostream_reference m_ostream;
+	int               m_level;
+	size_t            m_block_size;
+	size_t            m_max_blocks;
+	int               m_err;
+	bool              m_finished;
+	unsigned          m_members;
+	unsigned long long m_in_size;
+	unsigned long long m_out_size;
+
+	block_type*             m_current;
+	std::deque<block_type*> m_work;  // to be compressed
+	std::deque<block_type*> m_order; // submitted, in output order
+	std::vector<block_type*> m_free;
+
+	std::vector<std::thread> m_threads;
+	std::mutex               m_mutex;
+	std::condition_variable  m_work_cond;
+	std::condition_variable  m_done_cond;
+	bool                     m_stop;
+};
+
+/*! \brief Base class for parallel gzip ostreams
+
+ Contains a basic_pgzip_streambuf.
+ */
+template<typename Elem, typename Tr = std::char_traits<Elem> >
+class basic_pgzip_ostreambase: virtual public std::basic_ios<Elem, Tr> {
+public:
+	typedef std::basic_ostream<Elem, Tr>& ostream_reference;
+	typedef basic_pgzip_streambuf<Elem, Tr> pgzip_streambuf_type;
+
+	basic_pgzip_ostreambase(ostream_reference ostream_, size_t level_,
+			size_t block_size_, unsigned threads_) :
+			m_buf(ostream_, level_, block_size_, threads_) {
+		this->init(&m_buf);
+	}
+
+	/// returns the underlying stream buffer
+	pgzip_streambuf_type* rdbuf() {
+		return &m_buf;
+	}
+
+	/// returns the zlib error state
+	int get_zerr() const {
+		return m_buf.get_zerr();
+	}
+
+	/// returns the compressed data size
+	unsigned long long get_out_size() const {
+		return m_buf.get_out_size();
+	}
+
+	/// returns the uncompressed data size
+	unsigned long long get_in_size() const {
+		return m_buf.get_in_size();
+	}
+
+	/// returns the number of gzip members written
+	unsigned get_members() const {
+		return m_buf.get_members();
+	}
+
+private:
+	pgzip_streambuf_type m_buf;
+};
+
+/*! \brief A parallel gzip ostream
+
+ Same use of basic_gzip_ostream, with the compression of the blocks
+ done by a pool of threads.  Call close or the destructor at the end.
+
+ \code
+ ofstream file( "matrix.mtx.gz", ios::binary );
+ opgzstream gz( file, 6, 1 << 20 );
+ gz << ...;
+ gz.close();
+ \endcode
+ */
+template<typename Elem, typename Tr = std::char_traits<Elem> >
+class basic_pgzip_ostream: public basic_pgzip_ostreambase<Elem, Tr>,
+		public std::basic_ostream<Elem, Tr> {
+public:
+	typedef std::basic_ostream<Elem, Tr>& ostream_reference;
+	typedef basic_pgzip_ostreambase<Elem, Tr> pgzip_ostreambase_type;
+	typedef std::basic_ostream<Elem, Tr> ostream_type;
+
+	/** Constructs a parallel gzip ostream decorator
+	 *
+	 * \param ostream_    ostream where the compressed output is written
+	 * \param level_      level of compression 0, bad and fast, 9, good and slower
+	 * \param block_size_ size (bytes) of the blocks compressed independently
+	 * \param threads_    compressing threads, 0 for the hardware threads
+	 */
+	basic_pgzip_ostream(ostream_reference ostream_,
+			size_t level_ = Z_DEFAULT_COMPRESSION,
+			size_t block_size_ = default_block_size, unsigned threads_ = 0) :
+			pgzip_ostreambase_type(ostream_, level_, block_size_, threads_),
+			ostream_type(this->rdbuf()), m_closed(false) {
+	}
+
+	~basic_pgzip_ostream() {
+		close();
+	}
+
+	void close() {
+		if (m_closed)
+			return;
+		this->flush();
+		this->rdbuf()->zfinish();
+		m_closed = true;
+	}
+
+private:
+	bool m_closed;
+};
+
 /// A typedef for basic_zip_ostream<char>
 typedef basic_gzip_ostream<char> ogzstream;
 /// A typedef for basic_zip_ostream<wchar_t>
@@ -297,10 +495,12 @@ typedef basic_gzip_ostream<wchar_t> wgzostream;
 typedef basic_zip_ostream<char> ozstream;
 /// A typedef for basic_zip_ostream<wchar_t>
 typedef basic_zip_ostream<wchar_t> wzostream;
+/// A typedef for basic_pgzip_ostream<char>
+typedef basic_pgzip_ostream<char> opgzstream;
 
 } // zstream
 
-#include "ozstream_impl.hpp"
+#include "ozstream_impl.hh"
 
 #endif
 
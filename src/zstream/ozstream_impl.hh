@@ -21,7 +21,7 @@
 #ifndef OUTPUT_ZIP_STREAM_IMPL_HPP
 #define OUTPUT_ZIP_STREAM_IMPL_HPP
 
-#include "ozstream.hpp"
+#include "ozstream.hh"
 #include "zlib.h"
 #include <sstream>
 #include <cstring>
@@ -32,18 +32,6 @@
 
 namespace zstream {
 
-namespace detail {
-const int gz_magic[2] = { 0x1f, 0x8b }; /* gzip magic header */
-
-/* gzip flag byte */
-const int gz_ascii_flag = 0x01; /* bit 0 set: file probably ascii text */
-const int gz_head_crc = 0x02; /* bit 1 set: header CRC present */
-const int gz_extra_field = 0x04; /* bit 2 set: extra field present */
-const int gz_orig_name = 0x08; /* bit 3 set: original file name present */
-const int gz_comment = 0x10; /* bit 4 set: file comment present */
-const int gz_reserved = 0xE0; /* bits 5..7: reserved */
-}
-
 template<
   typename Elem,
   typename Tr,
@@ -289,6 +277,190 @@ basic_gzip_ostream<Elem, Tr, ElemA, ByteT, ByteAT>::add_footer() {
 	put_long(this->rdbuf()->get_ostream(), this->rdbuf()->get_in_size());
 }
 
+template<typename Elem, typename Tr>
+basic_pgzip_streambuf<Elem, Tr>::basic_pgzip_streambuf(
+  ostream_reference ostream_,
+  size_t            level_,
+  size_t            block_size_,
+  unsigned          threads_
+)
+: m_ostream(ostream_)
+, m_level(std::min(9, static_cast<int>(level_)))
+, m_block_size(std::max(block_size_ / sizeof(char_type), size_t(1)))
+, m_err(Z_OK)
+, m_finished(false)
+, m_members(0)
+, m_in_size(0)
+, m_out_size(0)
+, m_stop(false)
+{
+	if (threads_ == 0) threads_ = std::thread::hardware_concurrency();
+	if (threads_ == 0) threads_ = 1;
+	m_max_blocks = 2 * threads_;
+	for (unsigned t = 0; t < threads_; ++t)
+		m_threads.push_back(std::thread(&basic_pgzip_streambuf::worker, this));
+
+	m_current = new_block();
+	char_type *p = &(m_current->in[0]);
+	this->setp(p, p + m_block_size);
+}
+
+template<typename Elem, typename Tr>
+basic_pgzip_streambuf<Elem, Tr>::~basic_pgzip_streambuf() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_work_cond.notify_all();
+	for (size_t t = 0; t < m_threads.size(); ++t)
+		m_threads[t].join();
+	delete m_current;
+	for (size_t k = 0; k < m_order.size(); ++k)
+		delete m_order[k];
+	for (size_t k = 0; k < m_free.size(); ++k)
+		delete m_free[k];
+}
+
+template<typename Elem, typename Tr>
+typename basic_pgzip_streambuf<Elem, Tr>::block_type*
+basic_pgzip_streambuf<Elem, Tr>::new_block() {
+	if (!m_free.empty()) {
+		block_type* b = m_free.back();
+		m_free.pop_back();
+		return b;
+	}
+	block_type* b = new block_type;
+	b->in.resize(m_block_size);
+	return b;
+}
+
+template<typename Elem, typename Tr>
+void
+basic_pgzip_streambuf<Elem, Tr>::worker() {
+	z_stream zs;
+	zs.zalloc = (alloc_func) 0;
+	zs.zfree  = (free_func) 0;
+	zs.opaque = (voidpf) 0;
+	// a gzip member (header and footer by zlib) for each block
+	int err = deflateInit2(&zs, m_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+	for (;;) {
+		block_type* b;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_work.empty() && !m_stop) m_work_cond.wait(lock);
+			if (m_work.empty()) break;
+			b = m_work.front();
+			m_work.pop_front();
+		}
+		b->err = err;
+		b->out_size = 0;
+		if (err == Z_OK) {
+			uLong n = uLong(b->in_size * sizeof(char_type));
+			b->out.resize(deflateBound(&zs, n));
+			zs.next_in   = (Bytef*) (b->in.empty() ? nullptr : &b->in[0]);
+			zs.avail_in  = uInt(n);
+			zs.next_out  = &b->out[0];
+			zs.avail_out = uInt(b->out.size());
+			// the bound fits the whole member: one call
+			b->err = ::deflate(&zs, Z_FINISH) == Z_STREAM_END ? Z_OK : Z_BUF_ERROR;
+			b->out_size = b->out.size() - zs.avail_out;
+			deflateReset(&zs);
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		b->done = true;
+		m_done_cond.notify_all();
+	}
+	if (err == Z_OK) deflateEnd(&zs);
+}
+
+template<typename Elem, typename Tr>
+void
+basic_pgzip_streambuf<Elem, Tr>::write_front() {
+	block_type* b;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		b = m_order.front();
+		while (!b->done) m_done_cond.wait(lock);
+		m_order.pop_front();
+	}
+	if (b->err != Z_OK) m_err = b->err;
+	m_ostream.write((char_type const*) &b->out[0],
+			static_cast<std::streamsize>(b->out_size / sizeof(char_type)));
+	m_out_size += b->out_size;
+	++m_members;
+	m_free.push_back(b);
+}
+
+template<typename Elem, typename Tr>
+void
+basic_pgzip_streambuf<Elem, Tr>::submit() {
+	block_type* b = m_current;
+	b->in_size = size_t(this->pptr() - this->pbase());
+	b->done = false;
+	m_in_size += b->in_size * sizeof(char_type);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_work.push_back(b);
+		m_order.push_back(b);
+	}
+	m_work_cond.notify_one();
+
+	// write the members done, wait if too many blocks are in flight
+	for (;;) {
+		bool ready;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			ready = !m_order.empty() && (m_order.front()->done || m_order.size() >= m_max_blocks);
+		}
+		if (!ready) break;
+		write_front();
+	}
+
+	m_current = new_block();
+	char_type *p = &(m_current->in[0]);
+	this->setp(p, p + m_block_size);
+}
+
+template<typename Elem, typename Tr>
+int
+basic_pgzip_streambuf<Elem, Tr>::sync() {
+	// blocks are cut only when full, so that flushes (std::endl) do not
+	// produce small members
+	return m_err == Z_OK ? 0 : -1;
+}
+
+template<typename Elem, typename Tr>
+typename basic_pgzip_streambuf<Elem, Tr>::int_type
+basic_pgzip_streambuf<Elem, Tr>::overflow(int_type c) {
+	if (m_finished)
+		return Tr::eof();
+	if (this->pptr() > this->pbase())
+		submit();
+	if (!Tr::eq_int_type(c, Tr::eof())) {
+		*this->pptr() = Tr::to_char_type(c);
+		this->pbump(1);
+		return c;
+	}
+	return Tr::not_eof(c);
+}
+
+template<typename Elem, typename Tr>
+std::streamsize
+basic_pgzip_streambuf<Elem, Tr>::zfinish() {
+	if (m_finished)
+		return 0;
+	unsigned long long out0 = m_out_size;
+	// the last block, an empty member if nothing was written
+	if (this->pptr() > this->pbase() || m_members + m_order.size() == 0)
+		submit();
+	while (!m_order.empty())
+		write_front();
+	m_ostream.flush();
+	m_finished = true;
+	this->setp(nullptr, nullptr);
+	return static_cast<std::streamsize>(m_out_size - out0);
+}
+
 } // zstream
 
 #endif
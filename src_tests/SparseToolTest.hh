@@ -0,0 +1,107 @@
+/*--------------------------------------------------------------------------*\
+ |                                                                          |
+ |  SparseTool   : COMMON FIXTURE OF THE SPARSETOOL TEST DRIVERS            |
+ |                                                                          |
+ |  file         : SparseToolTest.hh                                        |
+ |  authors      : Enrico Bertolazzi                                        |
+ |  affiliations : Dipartimento di Ingegneria Industriale                   |
+ |                 Universita` degli Studi di Trento                        |
+ |                 email : enrico.bertolazzi@unitn.it                       |
+ |                                                                          |
+ |  purpose:                                                                |
+ |                                                                          |
+ |    Model matrices, residuals and the pass/fail report shared by the      |
+ |    test drivers of SparseTool.                                           |
+ |                                                                          |
+\*--------------------------------------------------------------------------*/
+
+#ifndef SPARSETOOL_TEST_HH
+#define SPARSETOOL_TEST_HH
+
+#include <sparse_tool/sparse_tool.hh>
+
+#include <cmath>
+#include <iostream>
+
+namespace SparseToolTest {
+
+  using namespace ::SparseToolLoad;
+  using ::std::cout;
+
+  typedef ::SparseTool::indexType indexType;
+
+  static int nFail = 0;
+
+  //! 5 points Laplacian on a n x n grid plus a centered convection term
+  inline
+  void
+  laplacian2D( CCoorMatrix<double> & A, indexType n, double conv ) {
+    indexType N = n*n;
+    A.resize( N, N, 5*N );
+    for ( indexType i = 0; i < n; ++i ) {
+      for ( indexType j = 0; j < n; ++j ) {
+        indexType k = i*n+j;
+        A.insert(k,k) = 4;
+        if ( i > 0   ) A.insert(k,k-n) = -1-conv;
+        if ( i < n-1 ) A.insert(k,k+n) = -1+conv;
+        if ( j > 0   ) A.insert(k,k-1) = -1-conv;
+        if ( j < n-1 ) A.insert(k,k+1) = -1+conv;
+      }
+    }
+    A.internalOrder();
+  }
+
+  //! relative true residual ||b-A*x||/||b||
+  inline
+  double
+  residual(
+    CRowMatrix<double> const & A,
+    Vector<double>     const & b,
+    Vector<double>     const & x
+  ) {
+    Vector<double> r( b.size() );
+    r = b - A*x;
+    return normi(r)/normi(b);
+  }
+
+  //! max |a(i)-b(i)|
+  inline
+  double
+  maxDiff( Vector<double> const & a, Vector<double> const & b ) {
+    double e = 0;
+    for ( indexType i = 0; i < a.size(); ++i )
+      e = std::max( e, std::abs(a(i)-b(i)) );
+    return e;
+  }
+
+  //! report \c err, a failure if above \c tol
+  inline
+  void
+  check( char const * what, double err, double tol ) {
+    bool ok = err <= tol;
+    cout << (ok ? "  ok    " : "  FAIL  ") << what << " = " << err << '\n';
+    if ( !ok ) ++nFail;
+  }
+
+  //! report a condition
+  inline
+  void
+  check( char const * what, bool ok ) {
+    cout << (ok ? "  ok    " : "  FAIL  ") << what << '\n';
+    if ( !ok ) ++nFail;
+  }
+
+  //! final report, the exit code of the driver
+  inline
+  int
+  report() {
+    if ( nFail > 0 ) {
+      cout << nFail << " checks FAILED\n";
+      return 1;
+    }
+    cout << "All done!\n";
+    return 0;
+  }
+}
+
+#endif
@@ -0,0 +1,371 @@
+/*--------------------------------------------------------------------------*\
+ |                                                                          |
+ |  SparseTool   : DRIVER FOR TESTING THE PRECONDITIONERS                   |
+ |                                                                          |
+ |  file         : test10-SparseToolPreconditioners.cc                      |
+ |  authors      : Enrico Bertolazzi                                        |
+ |  affiliations : Dipartimento di Ingegneria Industriale                   |
+ |                 Universita` degli Studi di Trento                        |
+ |                 email : enrico.bertolazzi@unitn.it                       |
+ |                                                                          |
+ |  purpose:                                                                |
+ |                                                                          |
+ |    Solve 2D diffusion and convection-diffusion systems with the          |
+ |    preconditioners, check the true residuals and that the threaded       |
+ |    applies match the serial ones.                                        |
+ |                                                                          |
+\*--------------------------------------------------------------------------*/
+
+#define SPARSETOOL_DEBUG
+#include <sparse_tool/sparse_tool.hh>
+#include <sparse_tool/sparse_tool_iterative.hh>
+
+#include "SparseToolTest.hh"
+
+#include <thread>
+#include <vector>
+
+using namespace SparseToolTest;
+using namespace std;
+
+// S = diffusion, C = convection-diffusion, b = right hand side
+static CRowMatrix<double> S, C;
+static Vector<double>     b;
+
+static
+void
+testILDUthreads() {
+  cout << "ILDU, level scheduled threads\n";
+  indexType N = C.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  ILDUpreconditioner<double> P(C), P3;
+  P3.setNumThreads(3);
+  P3.build(C);
+  P.assPreco( r1, b );
+  P3.assPreco( r2, b );
+  check( "ildu threads diff      ", maxDiff(r1,r2), 1e-12 );
+  x.setZero();
+  bicgstab( C, b, x, P3, 1e-10, 1000u, iter );
+  check( "ildu bicgstab residual ", residual(C,b,x), 1e-8 );
+
+  ILDUKpreconditioner<double> K(C), K3;
+  K3.setNumThreads(3);
+  K3.build(C);
+  K.assPreco( r1, b );
+  K3.assPreco( r2, b );
+  check( "ilduk threads diff     ", maxDiff(r1,r2), 1e-12 );
+}
+
+static
+void
+testMulticolor() {
+  cout << "multicolor SOR and SSOR\n";
+  indexType N = C.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  // the colors are independent: same sweep with 1 or 3 threads
+  SORpreconditioner<double> S1(C,1.2,2), S3(C,1.2,2);
+  S1.setMulticolor(true,1);
+  S3.setMulticolor(true,3);
+  S1.assPreco( r1, b );
+  S3.assPreco( r2, b );
+  check( "sor colors threads diff", maxDiff(r1,r2), 0 );
+  x.setZero();
+  fgmres( C, b, x, S3, 1e-10, 30u, 2000u, iter );
+  check( "sor fgmres residual    ", residual(C,b,x), 1e-8 );
+
+  SSORpreconditioner<double> Q;
+  Q.setMulticolor(true,4);
+  Q.build(C,1.2,1);
+  x.setZero();
+  fgmres( C, b, x, Q, 1e-10, 30u, 2000u, iter );
+  check( "ssor fgmres residual   ", residual(C,b,x), 1e-8 );
+}
+
+static
+void
+testAMG() {
+  cout << "AMG\n";
+  indexType N = S.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  AMGpreconditioner<double> M(S), M4;
+  M4.setNumThreads(4);
+  M4.build(S);
+  M.assPreco( r1, b );
+  M4.assPreco( r2, b );
+  check( "amg threads diff       ", maxDiff(r1,r2), 1e-12 );
+  x.setZero();
+  cg( S, b, x, M, 1e-10, 1000u, iter );
+  check( "amg cg residual        ", residual(S,b,x), 1e-8 );
+
+  AMGpreconditioner<double> M3;
+  M3.setSmoother(AMG_CHEBYSHEV,3);
+  M3.build(S);
+  x.setZero();
+  cg( S, b, x, M3, 1e-10, 1000u, iter );
+  check( "amg cheb cg residual   ", residual(S,b,x), 1e-8 );
+}
+
+static
+void
+testILUT() {
+  cout << "ILUT\n";
+  indexType N = C.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  ILUTpreconditioner<double> T(C,1e-3,10), T4;
+  T4.setNumThreads(4);
+  T4.build(C,1e-3,10);
+  T.assPreco( r1, b );
+  T4.assPreco( r2, b );
+  check( "ilut threads diff      ", maxDiff(r1,r2), 1e-12 );
+  x.setZero();
+  bicgstab( C, b, x, T, 1e-10, 1000u, iter );
+  check( "ilut bicgstab residual ", residual(C,b,x), 1e-8 );
+
+  // no dropping: exact LU
+  CCoorMatrix<double> A;
+  laplacian2D( A, 12, 0.5 );
+  CRowMatrix<double> R(A);
+  indexType n = R.numRows();
+  Vector<double> b0(n), x0(n);
+  b0 = 1;
+  ILUTpreconditioner<double> E(R,0.0,n);
+  E.assPreco( x0, b0 );
+  check( "ilut exact residual    ", residual(R,b0,x0), 1e-12 );
+}
+
+static
+void
+testIC() {
+  cout << "IC\n";
+  indexType N = S.numRows();
+  Vector<double> x(N);
+  indexType iter;
+
+  ICpreconditioner<double> I0(S), I2(S,2);
+  x.setZero();
+  cg( S, b, x, I0, 1e-10, 1000u, iter );
+  check( "ic(0) cg residual      ", residual(S,b,x), 1e-8 );
+  x.setZero();
+  cg( S, b, x, I2, 1e-10, 1000u, iter );
+  check( "ic(2) cg residual      ", residual(S,b,x), 1e-8 );
+
+  // full fill: exact Cholesky
+  CCoorMatrix<double> A;
+  laplacian2D( A, 12, 0 );
+  CRowMatrix<double> R(A);
+  indexType n = R.numRows();
+  Vector<double> b0(n), x0(n);
+  b0 = 1;
+  ICpreconditioner<double> E(R,n);
+  E.assPreco( x0, b0 );
+  check( "ic exact residual      ", residual(R,b0,x0), 1e-12 );
+}
+
+static
+void
+testSchwarz() {
+  cout << "Schwarz\n";
+  indexType N = S.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  SchwarzPreconditioner<double> P(S,16,1), P4;
+  P4.setNumThreads(4);
+  P4.build(S,16,1);
+  P.assPreco( r1, b );
+  P4.assPreco( r2, b );
+  check( "schwarz threads diff   ", maxDiff(r1,r2), 1e-12 );
+  x.setZero();
+  cg( S, b, x, P, 1e-10, 1000u, iter );
+  check( "schwarz cg residual    ", residual(S,b,x), 1e-8 );
+
+  SchwarzPreconditioner<double> R;
+  R.setRestricted(true);
+  R.build(C,16,1);
+  x.setZero();
+  fgmres( C, b, x, R, 1e-10, 50u, 1000u, iter );
+  check( "ras fgmres residual    ", residual(C,b,x), 1e-8 );
+
+  // one block with the exact sparse local solver is a direct solver
+  SchwarzPreconditioner<double> E;
+  E.setExactLocalSolver(100);
+  E.build(C,1,0);
+  E.assPreco( x, b );
+  check( "schwarz exact residual ", residual(C,b,x), 1e-10 );
+}
+
+static
+void
+testApproximateInverses() {
+  cout << "SPAI and FSAI\n";
+  indexType N = S.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  FSAIpreconditioner<double> F(S,2), F4;
+  F4.setNumThreads(4);
+  F4.build(S,2);
+  F.assPreco( r1, b );
+  F4.assPreco( r2, b );
+  check( "fsai threads diff      ", maxDiff(r1,r2), 1e-12 );
+  x.setZero();
+  cg( S, b, x, F, 1e-10, 1000u, iter );
+  check( "fsai cg residual       ", residual(S,b,x), 1e-8 );
+
+  SPAIpreconditioner<double> P(C,2);
+  x.setZero();
+  bicgstab( C, b, x, P, 1e-10, 1000u, iter );
+  check( "spai bicgstab residual ", residual(C,b,x), 1e-8 );
+
+  // full pattern: the exact inverse
+  CCoorMatrix<double> A;
+  laplacian2D( A, 4, 0.3 );
+  CRowMatrix<double> R(A);
+  indexType n = R.numRows();
+  Vector<double> b0(n), x0(n);
+  for ( indexType i = 0; i < n; ++i ) b0(i) = i+1;
+  SPAIpreconditioner<double> E(R,n);
+  E.assPreco( x0, b0 );
+  check( "spai full residual     ", residual(R,b0,x0), 1e-10 );
+}
+
+// applies of one preconditioner from a worker thread
+template <typename PRECO>
+class ConcurrentApply {
+  PRECO          const & P;
+  Vector<double> const & r0;
+  double               & err;
+public:
+  ConcurrentApply( PRECO const & _P, Vector<double> const & _r0, double & _err )
+  : P(_P), r0(_r0), err(_err)
+  {}
+
+  void
+  operator () () const {
+    Vector<double> r( b.size() );
+    for ( int k = 0; k < 20; ++k ) {
+      P.assPreco( r, b );
+      err = max( err, maxDiff(r,r0) );
+    }
+  }
+};
+
+// max difference of 4 concurrent applies in thread safe mode from a serial one
+template <typename PRECO>
+static
+double
+concurrentDiff( PRECO & P ) {
+  Vector<double> r0( b.size() );
+  P.assPreco( r0, b );
+  P.setThreadSafe(true);
+  double err[4] = { 0, 0, 0, 0 };
+  vector<thread> workers;
+  for ( int t = 0; t < 4; ++t )
+    workers.push_back( thread( ConcurrentApply<PRECO>( P, r0, err[t] ) ) );
+  for ( int t = 0; t < 4; ++t ) workers[t].join();
+  P.setThreadSafe(false);
+  return max( max(err[0],err[1]), max(err[2],err[3]) );
+}
+
+static
+void
+testConcurrentApply() {
+  cout << "concurrent applies\n";
+  JACOBIpreconditioner<double> J(S,0.8,3);
+  check( "jacobi concurrent diff ", concurrentDiff(J), 0 );
+  AMGpreconditioner<double> M(S);
+  check( "amg concurrent diff    ", concurrentDiff(M), 0 );
+  SchwarzPreconditioner<double> P(S,8,1);
+  check( "schwarz concurrent diff", concurrentDiff(P), 0 );
+  SPAIpreconditioner<double> Q(C,2);
+  check( "spai concurrent diff   ", concurrentDiff(Q), 0 );
+}
+
+// factors stored in single precision, apply in double
+static
+void
+testMixedPrecision() {
+  cout << "mixed precision factors\n";
+  indexType N = C.numRows();
+  Vector<double> x(N), r1(N), r2(N);
+  indexType iter;
+
+  ILDUpreconditioner<double>       P(C);
+  ILDUpreconditioner<double,float> Pf(C);
+  P.assPreco( r1, b );
+  Pf.assPreco( r2, b );
+  check( "ildu float rel diff    ", maxDiff(r1,r2)/normi(r1), 1e-5 );
+  x.setZero();
+  bicgstab( C, b, x, Pf, 1e-10, 1000u, iter );
+  check( "ildu float residual    ", residual(C,b,x), 1e-8 );
+
+  ILDUKpreconditioner<double,float> Kf(C);
+  x.setZero();
+  bicgstab( C, b, x, Kf, 1e-10, 1000u, iter );
+  check( "ilduk float residual   ", residual(C,b,x), 1e-8 );
+}
+
+// new values on the same pattern: refactor as a fresh build
+static
+void
+testRefactor() {
+  cout << "numeric refactorization\n";
+  indexType N = C.numRows();
+  Vector<double> r1(N), r2(N);
+
+  CRowMatrix<double> C2(C), S2(S);
+  indexType k = 0;
+  for ( C2.Begin(); C2.End(); C2.Next() ) C2.value() *= 1+0.3*sin(double(k++));
+  for ( S2.Begin(); S2.End(); S2.Next() ) S2.value() *= 2;
+
+  ILDUpreconditioner<double> P(C), P2(C2);
+  P.refactor(C2);
+  P.assPreco( r1, b );
+  P2.assPreco( r2, b );
+  check( "ildu refactor diff     ", maxDiff(r1,r2), 1e-12 );
+
+  ILDUKpreconditioner<double> K(C), K2(C2);
+  K.refactor(C2);
+  K.assPreco( r1, b );
+  K2.assPreco( r2, b );
+  check( "ilduk refactor diff    ", maxDiff(r1,r2), 1e-12 );
+
+  ICpreconditioner<double> I, I2;
+  I.analyze(S,1);
+  I.refactor(S2);
+  I2.build(S2,1);
+  I.assPreco( r1, b );
+  I2.assPreco( r2, b );
+  check( "ic refactor diff       ", maxDiff(r1,r2), 1e-12 );
+}
+
+int
+main() {
+  CCoorMatrix<double> A;
+  laplacian2D( A, 60, 0 );
+  S.resize( A );
+  laplacian2D( A, 60, 0.4 );
+  C.resize( A );
+  b.resize( S.numRows() );
+  for ( indexType i = 0; i < b.size(); ++i ) b(i) = 1+sin(0.1*i);
+
+  testILDUthreads();
+  testMulticolor();
+  testAMG();
+  testILUT();
+  testIC();
+  testSchwarz();
+  testApproximateInverses();
+  testConcurrentApply();
+  testMixedPrecision();
+  testRefactor();
+  return report();
+}
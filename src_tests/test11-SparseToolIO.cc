@@ -0,0 +1,342 @@
+/*--------------------------------------------------------------------------*\
+ |                                                                          |
+ |  SparseTool   : DRIVER FOR TESTING THE SPARSE MATRIX FILES               |
+ |                                                                          |
+ |  file         : test11-SparseToolIO.cc                                   |
+ |  authors      : Enrico Bertolazzi                                        |
+ |  affiliations : Dipartimento di Ingegneria Industriale                   |
+ |                 Universita` degli Studi di Trento                        |
+ |                 email : enrico.bertolazzi@unitn.it                       |
+ |                                                                          |
+ |  purpose:                                                                |
+ |                                                                          |
+ |    Round trip of sparse matrices through MatrixMarket files (plain and   |
+ |    parallel writer, memory mapped reader, gzip stream, parallel gzip     |
+ |    writer and block reader) and through the binary files and views.      |
+ |    Corrupted binary headers are refused.  Check also the parallel        |
+ |    ordering of entries with duplicates.                                  |
+ |                                                                          |
+\*--------------------------------------------------------------------------*/
+
+#define SPARSETOOL_DEBUG
+#include <sparse_tool/sparse_tool.hh>
+#include <sparse_tool/sparse_tool_matrix_market.hh>
+#include <sparse_tool/sparse_tool_binary.hh>
+
+#include "SparseToolTest.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wshorten-64-to-32"
+#endif
+
+#include <zstream/izstream.hh>
+#include <zstream/ozstream.hh>
+
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+using namespace SparseToolTest;
+using namespace std;
+
+// temporary files, removed at the end
+static char const fMM[]  = "bin/test11-tmp.mtx";
+static char const fMMF[] = "bin/test11-tmp-fast.mtx";
+static char const fGZ[]  = "bin/test11-tmp.mtx.gz";
+static char const fGZ1[] = "bin/test11-tmp-single.mtx.gz";
+static char const fGZ2[] = "bin/test11-tmp-fast.mtx.gz";
+static char const fR[]   = "bin/test11-tmp-row.bin";
+static char const fC[]   = "bin/test11-tmp-col.bin";
+static char const fK[]   = "bin/test11-tmp-coor.bin";
+static char const fX[]   = "bin/test11-tmp-bad.bin";
+
+// convection-diffusion matrix with values that need all the digits
+static
+void
+buildMatrix( CCoorMatrix<double> & A, unsigned n ) {
+  unsigned N = n*n;
+  A.resize( N, N, 5*N );
+  for ( unsigned i = 0; i < n; ++i ) {
+    for ( unsigned j = 0; j < n; ++j ) {
+      unsigned k = i*n+j;
+      double   s = 1+sin(double(k))/3;
+      A.insert(k,k) = 4*s;
+      if ( i > 0   ) A.insert(k,k-n) = -1.3*s;
+      if ( i < n-1 ) A.insert(k,k+n) = -0.7*s;
+      if ( j > 0   ) A.insert(k,k-1) = -1.3e-5*s;
+      if ( j < n-1 ) A.insert(k,k+1) = -0.7e5*s;
+    }
+  }
+  A.internalOrder();
+}
+
+// same entries in the same order; tol = 0 requires equal values
+static
+bool
+sameMatrix( CCoorMatrix<double> const & A, CCoorMatrix<double> const & B, double tol ) {
+  if ( A.numRows() != B.numRows() || A.numCols() != B.numCols() ||
+       A.nnz()     != B.nnz() ) return false;
+  for ( indexType k = 0; k < A.nnz(); ++k ) {
+    if ( A.getI()(k) != B.getI()(k) || A.getJ()(k) != B.getJ()(k) ) return false;
+    if ( abs(A.getA()(k)-B.getA()(k)) > tol*abs(A.getA()(k)) ) return false;
+  }
+  return true;
+}
+
+static
+void
+testMatrixMarket( CCoorMatrix<double> const & A ) {
+  cout << "MatrixMarket\n";
+  MatrixMarket        mm;
+  CCoorMatrix<double> B;
+
+  MatrixMarketSaveToFile( fMM, A, MM_REAL, MM_GENERAL );
+  mm.read( fMM, B );
+  check( "read              ", sameMatrix( A, B, 1e-14 ) );
+  mm.readFast( fMM, B, 1 );
+  check( "readFast 1 thread ", sameMatrix( A, B, 1e-14 ) );
+  mm.readFast( fMM, B, 4 );
+  check( "readFast 4 threads", sameMatrix( A, B, 1e-14 ) );
+}
+
+static
+void
+testGzip( CCoorMatrix<double> const & A ) {
+  cout << "gzip\n";
+  MatrixMarket        mm;
+  CCoorMatrix<double> B;
+  // compress the file of testMatrixMarket in a single member
+  {
+    ifstream           in( fMM );
+    ofstream           file( fGZ1, ios::out | ios::binary );
+    zstream::ogzstream gz( file );
+    gz << in.rdbuf();
+    gz.close();
+  }
+  {
+    ifstream file( fGZ1, ios::in | ios::binary );
+    zstream::igzstream gz( file );
+    mm.read( gz, B );
+    check( "igzstream read    ", sameMatrix( A, B, 1e-14 ) );
+  }
+  for ( int bg = 0; bg < 2; ++bg ) {
+    ifstream file( fGZ1, ios::in | ios::binary );
+    zstream::gzip_block_reader gz( file, 1000, bg == 1 );
+    mm.readBlocks( gz, B );
+    check( "gzip_block_reader ", gz.get_zerr() <= 1 && sameMatrix( A, B, 1e-14 ) );
+  }
+}
+
+static
+void
+testParallelGzip( CCoorMatrix<double> const & A ) {
+  cout << "parallel gzip\n";
+  MatrixMarket        mm;
+  CCoorMatrix<double> B;
+  // many small members compressed by 3 threads
+  {
+    ifstream            in( fMM );
+    ofstream            file( fGZ, ios::out | ios::binary );
+    zstream::opgzstream gz( file, 6, 1 << 12, 3 );
+    gz << in.rdbuf();
+    gz.close();
+    check( "opgzstream members", gz.get_zerr() == 0 && gz.get_members() > 1 );
+  }
+  // igzstream stops at the first member, the block reader reads them all
+  for ( int bg = 0; bg < 2; ++bg ) {
+    ifstream file( fGZ, ios::in | ios::binary );
+    zstream::gzip_block_reader gz( file, 1000, bg == 1 );
+    mm.readBlocks( gz, B );
+    check( "gzip_block_reader ", gz.get_zerr() <= 1 && sameMatrix( A, B, 1e-14 ) );
+  }
+}
+
+// the fast writer prints the shortest exact representation
+static
+void
+testFastWriter( CCoorMatrix<double> const & A ) {
+  cout << "parallel MatrixMarket writer\n";
+  MatrixMarket        mm;
+  CCoorMatrix<double> B;
+
+  MatrixMarketSaveToFileFast( fMMF, A, MM_REAL, MM_GENERAL, 4 );
+  mm.readFast( fMMF, B, 3 );
+  check( "write/readFast exact", sameMatrix( A, B, 0 ) );
+
+  CRowMatrix<double> R;
+  mm.readFast( fMMF, R );
+  check( "readFast to CRow  ", R.nnz() == A.nnz() );
+
+  {
+    ofstream           file( fGZ2, ios::out | ios::binary );
+    zstream::ogzstream gz( file );
+    MatrixMarketWriteFast( gz, A, MM_REAL, MM_GENERAL, 2 );
+    gz.close();
+  }
+  ifstream           file( fGZ2, ios::in | ios::binary );
+  zstream::igzstream gz( file );
+  mm.read( gz, B );
+  check( "write to stream   ", sameMatrix( A, B, 0 ) );
+}
+
+static
+void
+testBinary( CCoorMatrix<double> const & A ) {
+  cout << "binary files\n";
+  CRowMatrix<double> R(A);
+  CColMatrix<double> C(A);
+
+  SparseBinarySaveToFile( fR, R );
+  SparseBinarySaveToFile( fC, C );
+  SparseBinarySaveToFile( fK, A );
+
+  CRowMatrix<double>  R2;
+  CColMatrix<double>  C2;
+  CCoorMatrix<double> K2;
+  SparseBinaryLoadFromFile( fR, R2 );
+  SparseBinaryLoadFromFile( fC, C2 );
+  SparseBinaryLoadFromFile( fK, K2 );
+  check( "CCoor round trip  ", sameMatrix( A, K2, 0 ) );
+
+  bool ok = R2.nnz() == A.nnz() && C2.nnz() == A.nnz();
+  for ( A.Begin(); ok && A.End(); A.Next() )
+    ok = R2(A.row(),A.column()) == A.value() &&
+         C2(A.row(),A.column()) == A.value();
+  check( "CRow/CCol round trip", ok );
+
+  // load with conversion of the values
+  CRowMatrix<float> Rf;
+  SparseBinaryLoadFromFile( fR, Rf );
+  ok = Rf.nnz() == A.nnz();
+  for ( A.Begin(); ok && A.End(); A.Next() )
+    ok = Rf(A.row(),A.column()) == float(A.value());
+  check( "load as float     ", ok );
+
+  // products with the read only views of the three layouts
+  indexType      N = A.numRows();
+  Vector<double> x(N), y0(N), z0(N), y(N), z(N);
+  for ( indexType i = 0; i < N; ++i ) x(i) = sin(i+1.0);
+  y0 = R*x;
+  z0 = R^x;
+  char const * files[] = { fR, fC, fK };
+  for ( int f = 0; f < 3; ++f ) {
+    SparseBinaryView<double> V( files[f] );
+    y = V*x;
+    z = V^x;
+    check( "view products     ",
+           dist(y,y0) <= 1e-12*normi(y0) && dist(z,z0) <= 1e-12*normi(z0) );
+  }
+}
+
+// copy of fR with a corrupted header: 0 = value type, 1 = array past the end
+static
+void
+corruptedCopy( char const * fname, int what ) {
+  ifstream in( fR, ios::in | ios::binary );
+  string   data( (istreambuf_iterator<char>(in)), istreambuf_iterator<char>() );
+  SparseTool::SparseBinaryHeader h;
+  memcpy( &h, data.data(), sizeof(h) );
+  if ( what == 0 ) {
+    h.valueCode  = SparseTool::sb_code<complex<double> >::value;
+    h.valueBytes = 1;
+  } else {
+    h.offset[SparseTool::SB_VAL] = ~uint64_t(0) & ~(SparseTool::SB_ALIGN-1);
+  }
+  memcpy( &data[0], &h, sizeof(h) );
+  ofstream out( fname, ios::out | ios::binary );
+  out.write( data.data(), streamsize(data.size()) );
+}
+
+// SPARSETOOL_ERR exits, the load is tried by this driver in a child process
+// that returns 0 only when the file is refused
+static
+bool
+refused( char const * self, char const * fname ) {
+  string cmd = string(self) + " load " + fname + " 2> /dev/null";
+  return system( cmd.c_str() ) == 0;
+}
+
+static
+void
+testCorrupted( char const * self ) {
+  cout << "corrupted binary headers\n";
+  corruptedCopy( fX, 0 );
+  check( "bad value width refused", refused( self, fX ) );
+  corruptedCopy( fX, 1 );
+  check( "bad offset refused     ", refused( self, fX ) );
+}
+
+static
+void
+testOrdering() {
+  cout << "ordering of entries with duplicates\n";
+  indexType nr = 500, nc = 300;
+  CCoorMatrix<double> A( nr, nc, 0 );
+  map<pair<indexType,indexType>,double> ref; // (column,row) as CCoorMatrix
+  unsigned seed = 7;
+  for ( int k = 0; k < 50000; ++k ) {
+    seed = 1103515245*seed + 12345;
+    indexType i = (seed >> 8) % nr;
+    seed = 1103515245*seed + 12345;
+    indexType j = (seed >> 8) % (k % 5 == 0 ? 20 : nc); // some long columns
+    double v = (k % 1000)/8.0;
+    A.insert(i,j) += v;
+    ref[make_pair(j,i)] += v;
+  }
+  A.internalOrder();
+
+  bool ok = A.nnz() == ref.size();
+  map<pair<indexType,indexType>,double>::const_iterator it = ref.begin();
+  for ( A.Begin(); ok && A.End(); A.Next(), ++it )
+    ok = A.column() == it->first.first  &&
+         A.row()    == it->first.second &&
+         A.value()  == it->second;
+  check( "CCoor sorted and summed", ok );
+
+  CRowMatrix<double> R(A);
+  CColMatrix<double> C(A);
+  ok = R.nnz() == ref.size() && C.nnz() == ref.size();
+  for ( it = ref.begin(); ok && it != ref.end(); ++it )
+    ok = R(it->first.second,it->first.first) == it->second &&
+         C(it->first.second,it->first.first) == it->second;
+  check( "CRow/CCol from CCoor   ", ok );
+}
+
+int
+main( int argc, char const * argv[] ) {
+  if ( argc == 3 && string(argv[1]) == "load" ) {
+    CRowMatrix<complex<double> > R;
+    SparseBinaryLoadFromFile( argv[2], R );
+    return 1;
+  }
+
+  CCoorMatrix<double> A;
+  buildMatrix( A, 80 );
+  testMatrixMarket( A );
+  testGzip( A );
+  testParallelGzip( A );
+  testFastWriter( A );
+  testBinary( A );
+  testCorrupted( argv[0] );
+  testOrdering();
+
+  remove( fMM );
+  remove( fMMF );
+  remove( fGZ );
+  remove( fGZ1 );
+  remove( fGZ2 );
+  remove( fR );
+  remove( fC );
+  remove( fK );
+  remove( fX );
+  return report();
+}
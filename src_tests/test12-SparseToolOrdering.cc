@@ -0,0 +1,135 @@
+/*--------------------------------------------------------------------------*\
+ |                                                                          |
+ |  SparseTool   : DRIVER FOR TESTING THE FILL REDUCING ORDERINGS           |
+ |                                                                          |
+ |  file         : test12-SparseToolOrdering.cc                             |
+ |  authors      : Enrico Bertolazzi                                        |
+ |  affiliations : Dipartimento di Ingegneria Industriale                   |
+ |                 Universita` degli Studi di Trento                        |
+ |                 email : enrico.bertolazzi@unitn.it                       |
+ |                                                                          |
+ |  purpose:                                                                |
+ |                                                                          |
+ |    Reorder a scrambled 2D Laplacian with RCM and AMD, check that the     |
+ |    orderings are permutations, that RCM shrinks the band and that the    |
+ |    symmetrically permuted system gives back the solution of the          |
+ |    original one.                                                         |
+ |                                                                          |
+\*--------------------------------------------------------------------------*/
+
+#define SPARSETOOL_DEBUG
+#include <sparse_tool/sparse_tool.hh>
+#include <sparse_tool/sparse_tool_iterative.hh>
+#include <sparse_tool/sparse_tool_ordering.hh>
+
+#include "SparseToolTest.hh"
+
+#include <vector>
+
+using namespace SparseToolTest;
+using namespace std;
+
+// 5 points Laplacian on a n x n grid, unknowns scrambled by a fixed stride
+static
+void
+scrambledLaplacian2D( CCoorMatrix<double> & A, indexType n ) {
+  indexType N = n*n;
+  A.resize( N, N, 5*N );
+  for ( indexType i = 0; i < n; ++i ) {
+    for ( indexType j = 0; j < n; ++j ) {
+      indexType k  = i*n+j;
+      indexType pk = (k*37)%N;
+      A.insert(pk,pk) = 4;
+      if ( i > 0   ) A.insert(pk,((k-n)*37)%N) = -1;
+      if ( i < n-1 ) A.insert(pk,((k+n)*37)%N) = -1;
+      if ( j > 0   ) A.insert(pk,((k-1)*37)%N) = -1;
+      if ( j < n-1 ) A.insert(pk,((k+1)*37)%N) = -1;
+    }
+  }
+  A.internalOrder();
+}
+
+// number of entries that break the permutation
+static
+indexType
+permutationErrors( Vector<indexType> const & perm, indexType n ) {
+  if ( perm.size() != n ) return n;
+  vector<bool> seen( n, false );
+  indexType    nBad = 0;
+  for ( indexType k = 0; k < n; ++k ) {
+    if ( perm(k) >= n || seen[perm(k)] ) ++nBad;
+    else seen[perm(k)] = true;
+  }
+  return nBad;
+}
+
+// solve P A P^T (P x) = P b and compare with the solution of A x = b
+static
+void
+solvePermuted(
+  char               const * what,
+  CRowMatrix<double> const & A,
+  Vector<indexType>  const & perm,
+  Vector<double>     const & xe
+) {
+  indexType N = A.numRows();
+  CRowMatrix<double> B;
+  SymmetricPermute( A, perm, B );
+
+  Vector<double> b(N), bp(N), xp(N), x(N);
+  b = A*xe;
+  PermuteVector( b, perm, bp );
+
+  ILDUpreconditioner<double> P(B);
+  indexType iter;
+  xp.setZero();
+  cg( B, bp, xp, P, 1e-12, 1000u, iter );
+  InversePermuteVector( xp, perm, x );
+  check( what, residual(A,b,x), 1e-10 );
+}
+
+int
+main() {
+
+  indexType const n = 40;
+  CCoorMatrix<double> C;
+  scrambledLaplacian2D( C, n );
+  CRowMatrix<double> A(C);
+  indexType N = A.numRows();
+
+  Vector<indexType> prcm, pamd;
+  RCMOrdering( A, prcm );
+  AMDOrdering( A, pamd );
+  check( "rcm permutation errors ", permutationErrors( prcm, N ), 0 );
+  check( "amd permutation errors ", permutationErrors( pamd, N ), 0 );
+
+  // the bandwidth of the grid in the natural numbering is n
+  CRowMatrix<double> Ar;
+  SymmetricPermute( A, prcm, Ar );
+  cout << "bandwidth scrambled " << Bandwidth(A) << " rcm " << Bandwidth(Ar)
+       << " profile scrambled " << Profile(A) << " rcm " << Profile(Ar) << '\n';
+  check( "rcm bandwidth          ", Bandwidth(Ar), 2*n );
+  check( "rcm nnz changed        ", double(Ar.nnz())-double(A.nnz()), 0 );
+
+  // entries moved with the permutation, also for the column layout
+  CColMatrix<double> Ac(A), Acr;
+  SymmetricPermute( Ac, prcm, Acr );
+  double err = 0;
+  for ( Ar.Begin(); Ar.End(); Ar.Next() ) {
+    indexType i = Ar.row(), j = Ar.column();
+    err = max( err, abs( Ar.value() - A.value(prcm(i),prcm(j)) ) );
+    err = max( err, abs( Ar.value() - Acr.value(i,j) ) );
+  }
+  check( "permuted entries       ", err, 0 );
+
+  Vector<double> xe(N), y(N), z(N);
+  for ( indexType i = 0; i < N; ++i ) xe(i) = 1+sin(double(i));
+  PermuteVector( xe, pamd, y );
+  InversePermuteVector( y, pamd, z );
+  check( "vector round trip      ", dist( z, xe ), 0 );
+
+  solvePermuted( "rcm system residual    ", A, prcm, xe );
+  solvePermuted( "amd system residual    ", A, pamd, xe );
+
+  return report();
+}
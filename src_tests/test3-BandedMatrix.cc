@@ -21,13 +21,134 @@
 #include <lapack_wrapper/lapack_wrapper++.hh>
 #include <lapack_wrapper/TicToc.hh>
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 using namespace std;
+using lapack_wrapper::integer;
+using lapack_wrapper::doublereal;
 
+static int nFail = 0;
 
-int
-main() {
+static
+void
+check( char const * what, doublereal err, doublereal tol ) {
+  bool ok = err <= tol;
+  cout << (ok ? "  ok    " : "  FAIL  ") << what << " = " << err << '\n';
+  if ( !ok ) ++nFail;
+}
+
+/*
+ * 5 points operator on a n x n grid with the unknowns scrambled by a
+ * fixed stride, so the band of the natural numbering is the full matrix.
+ * tri = 1 keeps only the upper triangle, tri = -1 only the lower one.
+ */
+static
+void
+assemble(
+  lapack_wrapper::SparseCCOOR<doublereal> & A,
+  integer n,
+  doublereal s,
+  int     tri
+) {
+  integer N = n*n;
+  for ( integer a = 0; a < n; ++a ) {
+    for ( integer b = 0; b < n; ++b ) {
+      integer k = a*n+b;
+      integer nb[] = { k-n, k+n, k-1, k+1 };
+      bool    ok[] = { a > 0, a < n-1, b > 0, b < n-1 };
+      integer pk   = (k*7)%N;
+      A.push_value_C( pk, pk, 4.5*s );
+      for ( int m = 0; m < 4; ++m ) {
+        if ( !ok[m] ) continue;
+        integer pj = (nb[m]*7)%N;
+        if ( (tri == 1 && pk > pj) || (tri == -1 && pk < pj) ) continue;
+        A.push_value_C( pk, pj, tri == 0 && m % 2 == 0 ? -1.3*s : -0.7 );
+      }
+    }
+  }
+}
+
+// max |b-A*x|, A stored full or as a triangle of a symmetric matrix
+static
+doublereal
+residual(
+  lapack_wrapper::SparseCCOOR<doublereal> const & A,
+  vector<doublereal>                      const & x,
+  vector<doublereal>                      const & b,
+  bool                                            sym
+) {
+  integer N = integer(b.size());
+  vector<doublereal> r(b);
+  if ( sym ) A.gemv_Symmetric( -1, N, &x.front(), 1, 1, N, &r.front(), 1 );
+  else       A.gemv( -1, N, &x.front(), 1, 1, N, &r.front(), 1 );
+  doublereal e = 0;
+  for ( integer i = 0; i < N; ++i ) e = max( e, abs(r[i]) );
+  return e;
+}
+
+// band from a sparse matrix (also renumbered) and a frozen pattern
+static
+void
+test2() {
+
+  integer const n = 20, N = n*n;
+  vector<doublereal> b(N), x;
+  for ( integer i = 0; i < N; ++i ) b[i] = sin(i+1.0);
+
+  lapack_wrapper::SparseCCOOR<doublereal> A( N, N, 5*N, false );
+  assemble( A, n, 1, 0 );
+
+  for ( int rcm = 0; rcm < 2; ++rcm ) {
+    lapack_wrapper::BandedLU<doublereal> LU;
+    LU.setup( A, rcm == 1 );
+    if ( rcm == 1 ) {
+      // the renumbering is a permutation
+      integer const * P = LU.permutation();
+      vector<bool>    seen( N, false );
+      integer         nBad = P == nullptr ? N : 0;
+      for ( integer i = 0; P != nullptr && i < N; ++i ) {
+        if ( P[i] < 0 || P[i] >= N || seen[P[i]] ) ++nBad;
+        else seen[P[i]] = true;
+      }
+      check( "rcm permutation errors", nBad, 0 );
+    }
+    LU.factorize( "LU" );
+    x = b;
+    LU.solve( &x.front() );
+    check( rcm ? "BandedLU rcm residual" : "BandedLU residual    ",
+           residual( A, x, b, false ), 1e-12 );
+  }
+
+  for ( int tri = -1; tri <= 1; tri += 2 ) {
+    lapack_wrapper::SparseCCOOR<doublereal> S( N, N, 5*N, false );
+    assemble( S, n, 1, tri );
+    lapack_wrapper::BandedSPD<doublereal> C;
+    C.setup( tri < 0 ? lapack_wrapper::LOWER : lapack_wrapper::UPPER, S, true );
+    C.factorize( "SPD" );
+    x = b;
+    C.solve( &x.front() );
+    check( "BandedSPD rcm residual", residual( S, x, b, true ), 1e-12 );
+  }
+
+  // same pattern, new values assembled in the frozen slots
+  A.freeze_pattern();
+  for ( int k = 2; k <= 3; ++k ) {
+    A.setZero();
+    assemble( A, n, k, 0 );
+    lapack_wrapper::BandedLU<doublereal> LU;
+    LU.setup( A, true );
+    LU.factorize( "LU" );
+    x = b;
+    LU.solve( &x.front() );
+    check( "frozen pattern residual", residual( A, x, b, false ), 1e-12 );
+  }
+}
+
+static
+void
+test1() {
 
   lapack_wrapper::BandedLU<lapack_wrapper::doublereal> BLU;
 
@@ -65,7 +186,18 @@ main() {
 
   for ( int i = 0; i < N; ++i )
     cout << "x[ " << i << " ] = " << rhs[i] << '\n';
+}
 
+int
+main() {
+  cout << "test1\n";
+  test1();
+  cout << "\n\ntest2\n";
+  test2();
+  if ( nFail > 0 ) {
+    cout << nFail << " checks FAILED\n";
+    return 1;
+  }
   cout << "All done!\n";
   return 0;
 }
@@ -21,6 +21,7 @@
 #include <lapack_wrapper/lapack_wrapper++.hh>
 #include <lapack_wrapper/TicToc.hh>
 
+#include <cmath>
 #include <iostream>
 
 using namespace std;
@@ -117,12 +118,69 @@ test2() {
     cout << "x[ " << k << "] = " << rhs[7+k] << "\n";
 }
 
+// same matrix of test2 loaded from the lower triangle in a SparseCCOOR
+static
+bool
+test3() {
+
+  integer ii[] = {
+    1, 2, 2,
+    3, 5, 5,
+    6, 7,
+    3, 4, 4, 5,
+    6, 6, 6, 7, 7, 7
+  };
+
+  integer jj[] = {
+    1, 1, 2,
+    3, 3, 5,
+    6, 7,
+    1, 1, 2, 2,
+    3, 4, 5, 3, 4, 5
+  };
+
+  doublereal vals[] = {
+    2, 1, 1,
+    2, 1, 2,
+    2, 1,
+    1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1
+  };
+
+  lapack_wrapper::SparseCCOOR<doublereal> A( 7, 7, 18, true );
+  for ( int k = 0; k < 18; ++k ) A.push_value_F( ii[k], jj[k], vals[k] );
+
+  integer rBlocks[] = { 0, 2, 5, 7 };
+  bool    ok        = true;
+  for ( int given = 0; given < 2; ++given ) {
+    lapack_wrapper::BlockTridiagonalSymmetic<doublereal> BT;
+    if ( given == 1 ) BT.setup( 3, rBlocks, A, true );
+    else              BT.setup( A, true );
+    BT.factorize( "BT" );
+
+    // the solution is all ones
+    doublereal rhs[] = { 5, 4, 6, 4, 6, 5, 4 };
+    BT.solve( rhs );
+    doublereal err = 0;
+    for ( integer k = 0; k < 7; ++k ) err = max( err, abs(rhs[k]-1) );
+    cout << (given ? "given" : "found") << " blocks " << BT.numBlocks()
+         << " error " << err << '\n';
+    ok = ok && err < 1e-12;
+  }
+  return ok;
+}
+
 int
 main() {
   cout << "test1\n";
   test1();
   cout << "\n\ntest2\n";
   test2();
+  cout << "\n\ntest3\n";
+  if ( !test3() ) {
+    cout << "test3 FAILED\n";
+    return 1;
+  }
   cout << "All done!\n";
   return 0;
 }
@@ -0,0 +1,222 @@
+/*--------------------------------------------------------------------------*\
+ |                                                                          |
+ |  SparseTool   : DRIVER FOR TESTING THE ITERATIVE SOLVERS                 |
+ |                                                                          |
+ |  file         : test9-SparseToolIterative.cc                             |
+ |  authors      : Enrico Bertolazzi                                        |
+ |  affiliations : Dipartimento di Ingegneria Industriale                   |
+ |                 Universita` degli Studi di Trento                        |
+ |                 email : enrico.bertolazzi@unitn.it                       |
+ |                                                                          |
+ |  purpose:                                                                |
+ |                                                                          |
+ |    Solve 2D diffusion and convection-diffusion systems with the          |
+ |    iterative solvers and check the true residual of the solutions.       |
+ |                                                                          |
+\*--------------------------------------------------------------------------*/
+
+#define SPARSETOOL_DEBUG
+#include <sparse_tool/sparse_tool.hh>
+#include <sparse_tool/sparse_tool_iterative.hh>
+
+#include "SparseToolTest.hh"
+
+using namespace SparseToolTest;
+using namespace std;
+
+static
+void
+testCgPipelined() {
+  cout << "cg_pipelined\n";
+  CCoorMatrix<double> C;
+  laplacian2D( C, 40, 0 );
+  CRowMatrix<double> A(C);
+  indexType N = A.numRows();
+  Vector<double> b(N), x(N), xe(N);
+  for ( indexType i = 0; i < N; ++i ) xe(i) = 1+sin(double(i));
+  b = A*xe;
+
+  ILDUpreconditioner<double> P(A);
+  IdPreconditioner<double>   I;
+  indexType iter;
+
+  x.setZero();
+  cg_pipelined( A, b, x, P, 1e-10, 1000u, iter );
+  check( "cg_pipelined ILDU", residual(A,b,x), 1e-8 );
+
+  x.setZero();
+  cg_pipelined( A, b, x, I, 1e-10, 1000u, iter );
+  check( "cg_pipelined Id  ", residual(A,b,x), 1e-8 );
+
+  CgPipelinedWorkspace<double> ws;
+  for ( int rep = 0; rep < 2; ++rep ) {
+    x.setZero();
+    cg_pipelined( A, b, x, P, 1e-10, 1000u, iter, ws );
+    check( "cg_pipelined ws  ", residual(A,b,x), 1e-8 );
+  }
+}
+
+static
+void
+testGmresSstep() {
+  cout << "gmres_sstep\n";
+  CCoorMatrix<double> C;
+  laplacian2D( C, 40, 0.3 );
+  CRowMatrix<double> A(C);
+  indexType N = A.numRows();
+  Vector<double> b(N), x(N), xe(N);
+  for ( indexType i = 0; i < N; ++i ) xe(i) = 1+sin(double(i));
+  b = A*xe;
+
+  ILDUpreconditioner<double> P(A);
+  IdPreconditioner<double>   I;
+  indexType iter;
+
+  // block sizes not dividing m and a workspace reused across them
+  indexType const sList[] = { 1, 2, 4, 7 };
+  GmresSstepWorkspace<double> ws;
+  for ( indexType k = 0; k < 4; ++k ) {
+    x.setZero();
+    gmres_sstep( A, b, x, P, 1e-10, sList[k], 30u, 1000u, iter, ws );
+    check( "gmres_sstep ILDU", residual(A,b,x), 1e-8 );
+  }
+  x.setZero();
+  gmres_sstep( A, b, x, I, 1e-10, 4u, 30u, 3000u, iter );
+  check( "gmres_sstep Id  ", residual(A,b,x), 1e-8 );
+}
+
+// a reused workspace gives the same iterates of the allocating overload
+static
+void
+testWorkspaces() {
+  cout << "workspaces\n";
+  CCoorMatrix<double> C;
+  laplacian2D( C, 30, 0 );
+  CRowMatrix<double> A(C);
+  indexType N = A.numRows();
+  Vector<double> b(N), x(N), x0(N);
+  for ( indexType i = 0; i < N; ++i ) b(i) = 1+sin(double(i));
+
+  Dpreconditioner<double> P(A);
+  indexType iter;
+
+  CgWorkspace<double>       w1;
+  BicgstabWorkspace<double> w2;
+  GmresWorkspace<double>    w3;
+  CocgWorkspace<double>     w4;
+  CocrWorkspace<double>     w5;
+
+  x0.setZero(); cg( A, b, x0, P, 1e-10, 1000u, iter );
+  for ( int rep = 0; rep < 2; ++rep ) {
+    x.setZero(); cg( A, b, x, P, 1e-10, 1000u, iter, w1 );
+    check( "cg ws       same x", maxDiff(x,x0), 0 );
+  }
+  check( "cg       residual ", residual(A,b,x), 1e-8 );
+
+  x0.setZero(); bicgstab( A, b, x0, P, 1e-10, 1000u, iter );
+  for ( int rep = 0; rep < 2; ++rep ) {
+    x.setZero(); bicgstab( A, b, x, P, 1e-10, 1000u, iter, w2 );
+    check( "bicgstab ws same x", maxDiff(x,x0), 0 );
+  }
+  check( "bicgstab residual ", residual(A,b,x), 1e-8 );
+
+  x0.setZero(); gmres( A, b, x0, P, 1e-10, 20u, 1000u, iter );
+  for ( int rep = 0; rep < 2; ++rep ) {
+    x.setZero(); gmres( A, b, x, P, 1e-10, 20u, 1000u, iter, w3 );
+    check( "gmres ws    same x", maxDiff(x,x0), 0 );
+  }
+  check( "gmres    residual ", residual(A,b,x), 1e-8 );
+
+  x0.setZero(); cocg( A, b, x0, P, 1e-10, 1000u, iter );
+  x.setZero();  cocg( A, b, x, P, 1e-10, 1000u, iter, w4 );
+  check( "cocg ws     same x", maxDiff(x,x0), 0 );
+
+  x0.setZero(); cocr( A, b, x0, P, 1e-10, 1000u, iter );
+  x.setZero();  cocr( A, b, x, P, 1e-10, 1000u, iter, w5 );
+  check( "cocr ws     same x", maxDiff(x,x0), 0 );
+}
+
+// inner bicgstab used as variable preconditioner for fgmres
+class InnerBicgstab {
+  CRowMatrix<double>         const & A;
+  ILDUpreconditioner<double> const & P;
+  mutable BicgstabWorkspace<double>  ws;
+public:
+  InnerBicgstab(
+    CRowMatrix<double>         const & _A,
+    ILDUpreconditioner<double> const & _P
+  )
+  : A(_A), P(_P)
+  {}
+
+  void
+  operator () ( Vector<double> & z, Vector<double> const & v ) const {
+    indexType iter;
+    z.setZero();
+    bicgstab( A, v, z, P, 1e-2*normi(v), 3u, iter, ws );
+  }
+};
+
+static
+void
+testFgmres() {
+  cout << "fgmres\n";
+  CCoorMatrix<double> C;
+  laplacian2D( C, 40, 0.3 );
+  CRowMatrix<double> A(C);
+  indexType N = A.numRows();
+  Vector<double> b(N), x(N), xe(N);
+  for ( indexType i = 0; i < N; ++i ) xe(i) = 1+sin(double(i));
+  b = A*xe;
+
+  ILDUpreconditioner<double> P(A);
+  indexType iter;
+
+  x.setZero();
+  fgmres( A, b, x, P, 1e-10, 30u, 1000u, iter );
+  check( "fgmres ILDU    ", residual(A,b,x), 1e-8 );
+
+  FgmresWorkspace<double> ws;
+  InnerBicgstab inner( A, P );
+  for ( int rep = 0; rep < 2; ++rep ) {
+    x.setZero();
+    fgmres( A, b, x, inner, 1e-10, 30u, 1000u, iter, ws );
+    check( "fgmres bicgstab", residual(A,b,x), 1e-8 );
+  }
+}
+
+// a sequence of slowly changing systems sharing the recycle space
+static
+void
+testGcroDr() {
+  cout << "gcrodr\n";
+  GcroDrRecycle<double> rec(8);
+  Vector<double> b, x, xe;
+  for ( int step = 0; step < 4; ++step ) {
+    CCoorMatrix<double> C;
+    laplacian2D( C, 30, 0.2+0.01*step );
+    CRowMatrix<double> A(C);
+    indexType N = A.numRows();
+    b.resize(N);
+    x.resize(N);
+    xe.resize(N);
+    for ( indexType i = 0; i < N; ++i ) xe(i) = 1+sin(double(i)+step);
+    b = A*xe;
+    IdPreconditioner<double> P;
+    indexType iter;
+    x.setZero();
+    gcrodr( A, b, x, P, 1e-8, 30u, 5000u, iter, rec );
+    check( "gcrodr residual", residual(A,b,x), 1e-6 );
+  }
+  check( "gcrodr recycled", rec.size() > 0 );
+}
+
+int
+main() {
+  testCgPipelined();
+  testGmresSstep();
+  testWorkspaces();
+  testFgmres();
+  testGcroDr();
+  return report();
+}